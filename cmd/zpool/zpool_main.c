@@ -192,6 +192,7 @@ enum iostat_type {
 	IOS_QUEUES = 2,
 	IOS_L_HISTO = 3,
 	IOS_RQ_HISTO = 4,
+	IOS_ZIL_HISTO = 5,
 	IOS_COUNT,	/* always last element */
 };
 
@@ -201,9 +202,10 @@ enum iostat_type {
 #define	IOS_QUEUES_M	(1ULL << IOS_QUEUES)
 #define	IOS_L_HISTO_M	(1ULL << IOS_L_HISTO)
 #define	IOS_RQ_HISTO_M	(1ULL << IOS_RQ_HISTO)
+#define	IOS_ZIL_HISTO_M	(1ULL << IOS_ZIL_HISTO)
 
 /* Mask of all the histo bits */
-#define	IOS_ANYHISTO_M (IOS_L_HISTO_M | IOS_RQ_HISTO_M)
+#define	IOS_ANYHISTO_M (IOS_L_HISTO_M | IOS_RQ_HISTO_M | IOS_ZIL_HISTO_M)
 
 /*
  * Lookup table for iostat flags to nvlist names.  Basically a list
@@ -252,6 +254,14 @@ static const char *vsx_type_to_nvlist[IOS_COUNT][13] = {
 	    ZPOOL_CONFIG_VDEV_IND_TRIM_HISTO,
 	    ZPOOL_CONFIG_VDEV_AGG_TRIM_HISTO,
 	    NULL},
+	[IOS_ZIL_HISTO] = {
+	    ZPOOL_CONFIG_ZIL_QUEUE_LAT_HISTO,
+	    ZPOOL_CONFIG_ZIL_BUILD_LAT_HISTO,
+	    ZPOOL_CONFIG_ZIL_ISSUE_LAT_HISTO,
+	    ZPOOL_CONFIG_ZIL_DEVICE_LAT_HISTO,
+	    ZPOOL_CONFIG_ZIL_FLUSH_LAT_HISTO,
+	    ZPOOL_CONFIG_ZIL_WAKEUP_LAT_HISTO,
+	    NULL},
 };
 
 
@@ -363,14 +373,14 @@ get_usage(zpool_help_t idx)
 		return (gettext("\timport [-d dir] [-D]\n"
 		    "\timport [-o mntopts] [-o property=value] ... \n"
 		    "\t    [-d dir | -c cachefile] [-D] [-l] [-f] [-m] [-N] "
-		    "[-R root] [-F [-n]] -a\n"
+		    "[-R root] [-F [-n]] [-v] -a\n"
 		    "\timport [-o mntopts] [-o property=value] ... \n"
 		    "\t    [-d dir | -c cachefile] [-D] [-l] [-f] [-m] [-N] "
-		    "[-R root] [-F [-n]]\n"
+		    "[-R root] [-F [-n]] [-v]\n"
 		    "\t    [--rewind-to-checkpoint] <pool | id> [newpool]\n"));
 	case HELP_IOSTAT:
 		return (gettext("\tiostat [[[-c [script1,script2,...]"
-		    "[-lq]]|[-rw]] [-T d | u] [-ghHLpPvy]\n"
+		    "[-lq]]|[-rw]|[-Z]] [-T d | u] [-ghHLpPvy]\n"
 		    "\t    [[pool ...]|[pool vdev ...]|[vdev ...]]"
 		    " [[-n] interval [count]]\n"));
 	case HELP_LABELCLEAR:
@@ -3025,7 +3035,7 @@ zfs_force_import_required(nvlist_t *config)
  */
 static int
 do_import(nvlist_t *config, const char *newname, const char *mntopts,
-    nvlist_t *props, int flags)
+    nvlist_t *props, int flags, boolean_t progress)
 {
 	int ret = 0;
 	zpool_handle_t *zhp;
@@ -3120,7 +3130,7 @@ do_import(nvlist_t *config, const char *newname, const char *mntopts,
 
 	if (zpool_get_state(zhp) != POOL_STATE_UNAVAIL &&
 	    !(flags & ZFS_IMPORT_ONLY) &&
-	    zpool_enable_datasets(zhp, mntopts, 0) != 0) {
+	    zpool_enable_datasets_progress(zhp, mntopts, 0, progress) != 0) {
 		zpool_close(zhp);
 		return (1);
 	}
@@ -3133,7 +3143,7 @@ static int
 import_pools(nvlist_t *pools, nvlist_t *props, char *mntopts, int flags,
     char *orig_name, char *new_name,
     boolean_t do_destroyed, boolean_t pool_specified, boolean_t do_all,
-    importargs_t *import)
+    boolean_t progress, importargs_t *import)
 {
 	nvlist_t *config = NULL;
 	nvlist_t *found_config = NULL;
@@ -3170,7 +3180,7 @@ import_pools(nvlist_t *pools, nvlist_t *props, char *mntopts, int flags,
 
 			if (do_all) {
 				err |= do_import(config, NULL, mntopts,
-				    props, flags);
+				    props, flags, progress);
 			} else {
 				/*
 				 * If we're importing from cachefile, then
@@ -3230,7 +3240,7 @@ import_pools(nvlist_t *pools, nvlist_t *props, char *mntopts, int flags,
 			err = B_TRUE;
 		} else {
 			err |= do_import(found_config, new_name,
-			    mntopts, props, flags);
+			    mntopts, props, flags, progress);
 		}
 	}
 
@@ -3417,6 +3427,8 @@ zpool_do_checkpoint(int argc, char **argv)
  *	-s	Scan using the default search path, the libblkid cache will
  *		not be consulted.
  *
+ *	-v	Report progress while mounting datasets.
+ *
  *	--rewind-to-checkpoint
  *		Import the pool and revert back to the checkpoint.
  *
@@ -3448,6 +3460,7 @@ zpool_do_import(int argc, char **argv)
 	boolean_t do_scan = B_FALSE;
 	boolean_t pool_exists = B_FALSE;
 	boolean_t pool_specified = B_FALSE;
+	boolean_t progress = B_FALSE;
 	uint64_t txg = -1ULL;
 	char *cachefile = NULL;
 	importargs_t idata = { 0 };
@@ -3459,7 +3472,7 @@ zpool_do_import(int argc, char **argv)
 	};
 
 	/* check options */
-	while ((c = getopt_long(argc, argv, ":aCc:d:DEfFlmnNo:R:stT:VX",
+	while ((c = getopt_long(argc, argv, ":aCc:d:DEfFlmnNo:R:stT:vVX",
 	    long_options, NULL)) != -1) {
 		switch (c) {
 		case 'a':
@@ -3541,6 +3554,9 @@ zpool_do_import(int argc, char **argv)
 			}
 			rewind_policy = ZPOOL_DO_REWIND | ZPOOL_EXTREME_REWIND;
 			break;
+		case 'v':
+			progress = B_TRUE;
+			break;
 		case 'V':
 			flags |= ZFS_IMPORT_VERBATIM;
 			break;
@@ -3736,7 +3752,7 @@ zpool_do_import(int argc, char **argv)
 
 	err = import_pools(pools, props, mntopts, flags, argv[0],
 	    argc == 1 ? NULL : argv[1], do_destroyed, pool_specified,
-	    do_all, &idata);
+	    do_all, progress, &idata);
 
 	/*
 	 * If we're using the cachefile and we failed to import, then
@@ -3758,7 +3774,7 @@ zpool_do_import(int argc, char **argv)
 
 		err = import_pools(pools, props, mntopts, flags, argv[0],
 		    argc == 1 ? NULL : argv[1], do_destroyed, pool_specified,
-		    do_all, &idata);
+		    do_all, progress, &idata);
 	}
 
 error:
@@ -3849,6 +3865,7 @@ static const name_and_columns_t iostat_top_labels[][IOSTAT_MAX_LABELS] =
 	[IOS_RQ_HISTO] = {{"sync_read", 2}, {"sync_write", 2},
 	    {"async_read", 2}, {"async_write", 2}, {"scrub", 2},
 	    {"trim", 2}, {NULL}},
+	[IOS_ZIL_HISTO] = {{"zil_commit", 6}, {NULL}},
 };
 
 /* Shorthand - if "columns" field not set, default to 1 column */
@@ -3865,11 +3882,14 @@ static const name_and_columns_t iostat_bottom_labels[][IOSTAT_MAX_LABELS] =
 	    {"write"}, {"read"}, {"write"}, {"scrub"}, {"trim"}, {NULL}},
 	[IOS_RQ_HISTO] = {{"ind"}, {"agg"}, {"ind"}, {"agg"}, {"ind"}, {"agg"},
 	    {"ind"}, {"agg"}, {"ind"}, {"agg"}, {"ind"}, {"agg"}, {NULL}},
+	[IOS_ZIL_HISTO] = {{"queue"}, {"build"}, {"issue"}, {"disk"},
+	    {"flush"}, {"wake"}, {NULL}},
 };
 
 static const char *histo_to_title[] = {
 	[IOS_L_HISTO] = "latency",
 	[IOS_RQ_HISTO] = "req_size",
+	[IOS_ZIL_HISTO] = "latency",
 };
 
 /*
@@ -3925,6 +3945,7 @@ default_column_width(iostat_cbdata_t *cb, enum iostat_type type)
 		[IOS_QUEUES] = 6,   /* 1M queue entries */
 		[IOS_L_HISTO] = 10, /* 1B ns = 10sec */
 		[IOS_RQ_HISTO] = 6, /* 1M queue entries */
+		[IOS_ZIL_HISTO] = 10, /* 1B ns = 10sec */
 	};
 
 	if (cb->cb_literal)
@@ -4358,7 +4379,7 @@ print_iostat_histo(struct stat_array *nva, unsigned int len,
 
 	for (j = start_bucket; j < buckets; j++) {
 		/* Print histogram bucket label */
-		if (cb->cb_flags & IOS_L_HISTO_M) {
+		if (cb->cb_flags & (IOS_L_HISTO_M | IOS_ZIL_HISTO_M)) {
 			/* Ending range of this bucket */
 			val = (1UL << (j + 1)) - 1;
 			zfs_nicetime(val, buf, sizeof (buf));
@@ -5444,6 +5465,7 @@ get_namewidth_iostat(zpool_handle_t *zhp, void *data)
  *	-q	Display queue depths
  *	-w	Display latency histograms
  *	-r	Display request size histogram
+ *	-Z	Display ZIL commit latency histograms
  *	-T	Display a timestamp in date(1) or Unix format
  *	-n	Only print headers once
  *
@@ -5465,6 +5487,7 @@ zpool_do_iostat(int argc, char **argv)
 	zpool_list_t *list;
 	boolean_t verbose = B_FALSE;
 	boolean_t latency = B_FALSE, l_histo = B_FALSE, rq_histo = B_FALSE;
+	boolean_t zil_histo = B_FALSE;
 	boolean_t queues = B_FALSE, parsable = B_FALSE, scripted = B_FALSE;
 	boolean_t omit_since_boot = B_FALSE;
 	boolean_t guid = B_FALSE;
@@ -5476,12 +5499,12 @@ zpool_do_iostat(int argc, char **argv)
 
 	/* Used for printing error message */
 	const char flag_to_arg[] = {[IOS_LATENCY] = 'l', [IOS_QUEUES] = 'q',
-	    [IOS_L_HISTO] = 'w', [IOS_RQ_HISTO] = 'r'};
+	    [IOS_L_HISTO] = 'w', [IOS_RQ_HISTO] = 'r', [IOS_ZIL_HISTO] = 'Z'};
 
 	uint64_t unsupported_flags;
 
 	/* check options */
-	while ((c = getopt(argc, argv, "c:gLPT:vyhplqrwnH")) != -1) {
+	while ((c = getopt(argc, argv, "c:gLPT:vyhplqrwnHZ")) != -1) {
 		switch (c) {
 		case 'c':
 			if (cmd != NULL) {
@@ -5541,6 +5564,9 @@ zpool_do_iostat(int argc, char **argv)
 		case 'r':
 			rq_histo = B_TRUE;
 			break;
+		case 'Z':
+			zil_histo = B_TRUE;
+			break;
 		case 'y':
 			omit_since_boot = B_TRUE;
 			break;
@@ -5648,18 +5674,29 @@ zpool_do_iostat(int argc, char **argv)
 		return (1);
 	}
 
-	if ((l_histo || rq_histo) && (cmd != NULL || latency || queues)) {
+	if ((l_histo || rq_histo || zil_histo) &&
+	    (cmd != NULL || latency || queues)) {
+		pool_list_free(list);
+		(void) fprintf(stderr,
+		    gettext("[-r|-w|-Z] isn't allowed with [-c|-l|-q]\n"));
+		usage(B_FALSE);
+		return (1);
+	}
+
+	if (l_histo + rq_histo + zil_histo > 1) {
 		pool_list_free(list);
 		(void) fprintf(stderr,
-		    gettext("[-r|-w] isn't allowed with [-c|-l|-q]\n"));
+		    gettext("Only one of [-r|-w|-Z] can be passed at a "
+		    "time\n"));
 		usage(B_FALSE);
 		return (1);
 	}
 
-	if (l_histo && rq_histo) {
+	if (zil_histo && cb.cb_verbose) {
+		/* The ZIL commit latencies are only kept for the pool. */
 		pool_list_free(list);
 		(void) fprintf(stderr,
-		    gettext("Only one of [-r|-w] can be passed at a time\n"));
+		    gettext("-Z isn't allowed with -v or vdevs\n"));
 		usage(B_FALSE);
 		return (1);
 	}
@@ -5678,6 +5715,8 @@ zpool_do_iostat(int argc, char **argv)
 		cb.cb_flags = IOS_L_HISTO_M;
 	} else if (rq_histo) {
 		cb.cb_flags = IOS_RQ_HISTO_M;
+	} else if (zil_histo) {
+		cb.cb_flags = IOS_ZIL_HISTO_M;
 	} else {
 		cb.cb_flags = IOS_DEFAULT_M;
 		if (latency)
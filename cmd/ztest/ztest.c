@@ -366,6 +366,8 @@ ztest_func_t ztest_zil_remount;
 ztest_func_t ztest_dmu_read_write_zcopy;
 ztest_func_t ztest_dmu_objset_create_destroy;
 ztest_func_t ztest_dmu_prealloc;
+ztest_func_t ztest_arc_read_hits;
+ztest_func_t ztest_dmu_read_seq;
 ztest_func_t ztest_fzap;
 ztest_func_t ztest_dmu_snapshot_create_destroy;
 ztest_func_t ztest_dsl_prop_get_set;
@@ -422,6 +424,8 @@ ztest_info_t ztest_info[] = {
 #if 0
 	ZTI_INIT(ztest_dmu_prealloc, 1, &zopt_sometimes),
 #endif
+	ZTI_INIT(ztest_arc_read_hits, 1, &zopt_sometimes),
+	ZTI_INIT(ztest_dmu_read_seq, 1, &zopt_sometimes),
 	ZTI_INIT(ztest_fzap, 1, &zopt_sometimes),
 	ZTI_INIT(ztest_dmu_snapshot_create_destroy, 1, &zopt_sometimes),
 	ZTI_INIT(ztest_spa_create_destroy, 1, &zopt_sometimes),
@@ -5125,6 +5129,235 @@ ztest_dmu_prealloc(ztest_ds_t *zd, uint64_t id)
 	umem_free(od, sizeof (ztest_od_t));
 }
 
+/*
+ * Hammer arc_read() cache hits on a small set of blocks from several
+ * threads at once, verifying the returned data.  This exercises the ARC
+ * hash table locking under contention; with -VVVV the achieved hit rate
+ * is reported so changes to the lookup path can be compared.
+ */
+#define	ZTEST_ARC_READ_BLOCKS	8
+#define	ZTEST_ARC_READ_THREADS	8
+#define	ZTEST_ARC_READ_ITERS	2000
+
+typedef struct ztest_arc_read_arg {
+	spa_t		*zra_spa;
+	uint64_t	zra_objset;
+	uint64_t	zra_object;
+	uint64_t	zra_blocksize;
+	blkptr_t	zra_bp[ZTEST_ARC_READ_BLOCKS];
+	char		*zra_data;
+	uint64_t	zra_reads;
+	uint64_t	zra_errors;
+} ztest_arc_read_arg_t;
+
+static void
+ztest_arc_read_thread(void *arg)
+{
+	ztest_arc_read_arg_t *zra = arg;
+	uint64_t reads = 0, errors = 0;
+
+	for (int i = 0; i < ZTEST_ARC_READ_ITERS; i++) {
+		uint64_t b = ztest_random(ZTEST_ARC_READ_BLOCKS);
+		arc_flags_t aflags = ARC_FLAG_WAIT;
+		arc_buf_t *abuf = NULL;
+		zbookmark_phys_t zb;
+
+		SET_BOOKMARK(&zb, zra->zra_objset, zra->zra_object, 0, b);
+		if (arc_read(NULL, zra->zra_spa, &zra->zra_bp[b],
+		    arc_getbuf_func, &abuf, ZIO_PRIORITY_SYNC_READ,
+		    ZIO_FLAG_CANFAIL, &aflags, &zb) != 0 || abuf == NULL) {
+			errors++;
+			continue;
+		}
+
+		VERIFY3U(arc_buf_size(abuf), ==, zra->zra_blocksize);
+		VERIFY0(bcmp(abuf->b_data,
+		    zra->zra_data + b * zra->zra_blocksize,
+		    zra->zra_blocksize));
+		arc_buf_destroy(abuf, &abuf);
+		reads++;
+	}
+
+	atomic_add_64(&zra->zra_reads, reads);
+	atomic_add_64(&zra->zra_errors, errors);
+}
+
+void
+ztest_arc_read_hits(ztest_ds_t *zd, uint64_t id)
+{
+	objset_t *os = zd->zd_os;
+	ztest_arc_read_arg_t *zra;
+	ztest_od_t *od;
+	uint64_t *data;
+	uint64_t blocksize, b, w, words;
+	hrtime_t start, delta;
+	taskq_t *tq;
+	int t, nthreads;
+
+	od = umem_alloc(sizeof (ztest_od_t), UMEM_NOFAIL);
+	ztest_od_init(od, id, FTAG, 0, DMU_OT_UINT64_OTHER, 0, 0, 0);
+
+	if (ztest_object_init(zd, od, sizeof (ztest_od_t), B_TRUE) != 0) {
+		umem_free(od, sizeof (ztest_od_t));
+		return;
+	}
+
+	zra = umem_zalloc(sizeof (*zra), UMEM_NOFAIL);
+	blocksize = od->od_blocksize;
+	zra->zra_spa = dmu_objset_spa(os);
+	zra->zra_objset = dmu_objset_id(os);
+	zra->zra_object = od->od_object;
+	zra->zra_blocksize = blocksize;
+	zra->zra_data = umem_alloc(ZTEST_ARC_READ_BLOCKS * blocksize,
+	    UMEM_NOFAIL);
+
+	/*
+	 * Fill the blocks with data which is never all zeros so that every
+	 * one of them is allocated, then wait for it to reach stable storage.
+	 * Odd blocks are compressible, so that when compression is enabled
+	 * their hits also exercise the ARC's uncompressed copies.
+	 */
+	data = (uint64_t *)zra->zra_data;
+	words = blocksize / sizeof (*data);
+	for (w = 0; w < ZTEST_ARC_READ_BLOCKS * words; w++) {
+		if ((w / words) % 2 == 0 || w % 8 == 0)
+			data[w] = ztest_random(-1ULL);
+		else
+			data[w] = data[w - 1];
+	}
+
+	for (b = 0; b < ZTEST_ARC_READ_BLOCKS; b++) {
+		if (ztest_write(zd, od->od_object, b * blocksize, blocksize,
+		    zra->zra_data + b * blocksize) != 0)
+			goto out;
+	}
+	txg_wait_synced(dmu_objset_pool(os), 0);
+
+	/*
+	 * This thread is the only user of the object, so its block
+	 * pointers remain valid until the object is next recreated.
+	 */
+	for (b = 0; b < ZTEST_ARC_READ_BLOCKS; b++) {
+		dmu_buf_t *db;
+		blkptr_t *bp;
+
+		if (dmu_buf_hold(os, od->od_object, b * blocksize, FTAG,
+		    &db, DMU_READ_NO_PREFETCH) != 0)
+			goto out;
+		bp = dmu_buf_get_blkptr(db);
+		if (bp == NULL || BP_IS_HOLE(bp) || BP_IS_EMBEDDED(bp)) {
+			dmu_buf_rele(db, FTAG);
+			goto out;
+		}
+		zra->zra_bp[b] = *bp;
+		dmu_buf_rele(db, FTAG);
+	}
+
+	nthreads = MAX(2, MIN(boot_ncpus, ZTEST_ARC_READ_THREADS));
+	tq = taskq_create("ztest_arc_read", nthreads, maxclsyspri, nthreads,
+	    INT_MAX, TASKQ_PREPOPULATE);
+
+	start = gethrtime();
+	for (t = 0; t < nthreads; t++) {
+		VERIFY3U(taskq_dispatch(tq, ztest_arc_read_thread, zra,
+		    TQ_SLEEP), !=, TASKQID_INVALID);
+	}
+	taskq_wait(tq);
+	delta = MAX(gethrtime() - start, 1);
+	taskq_destroy(tq);
+
+	if (ztest_opts.zo_verbose >= 4) {
+		(void) printf("arc_read hits: %d threads, %llu reads, "
+		    "%llu errors, %llu reads/sec\n", nthreads,
+		    (u_longlong_t)zra->zra_reads,
+		    (u_longlong_t)zra->zra_errors,
+		    (u_longlong_t)(zra->zra_reads * NANOSEC / delta));
+	}
+
+out:
+	umem_free(zra->zra_data, ZTEST_ARC_READ_BLOCKS * blocksize);
+	umem_free(zra, sizeof (*zra));
+	umem_free(od, sizeof (ztest_od_t));
+}
+
+/*
+ * Repeatedly read a small, fully cached object sequentially in large
+ * chunks with dmu_read(), verifying the returned data.  Every read is
+ * served from the dbuf cache, so this measures the cost of holding and
+ * releasing arrays of dbufs; with -VVVV the achieved throughput is
+ * reported so changes to that path can be compared.
+ */
+#define	ZTEST_DMU_READ_BLOCKS	16
+#define	ZTEST_DMU_READ_CHUNK	(8 * SPA_OLD_MAXBLOCKSIZE)
+#define	ZTEST_DMU_READ_PASSES	64
+
+void
+ztest_dmu_read_seq(ztest_ds_t *zd, uint64_t id)
+{
+	objset_t *os = zd->zd_os;
+	ztest_od_t *od;
+	uint64_t *data;
+	char *buf, *readbuf;
+	uint64_t size, off, b, w, bytes = 0;
+	uint64_t blocksize = SPA_OLD_MAXBLOCKSIZE;
+	hrtime_t start, delta;
+	int pass;
+
+	od = umem_alloc(sizeof (ztest_od_t), UMEM_NOFAIL);
+	ztest_od_init(od, id, FTAG, 0, DMU_OT_UINT64_OTHER, blocksize, 0, 0);
+
+	if (ztest_object_init(zd, od, sizeof (ztest_od_t), B_TRUE) != 0) {
+		umem_free(od, sizeof (ztest_od_t));
+		return;
+	}
+
+	size = ZTEST_DMU_READ_BLOCKS * blocksize;
+	buf = umem_alloc(size, UMEM_NOFAIL);
+	readbuf = umem_alloc(ZTEST_DMU_READ_CHUNK, UMEM_NOFAIL);
+
+	data = (uint64_t *)buf;
+	for (w = 0; w < size / sizeof (*data); w++)
+		data[w] = ztest_random(-1ULL);
+
+	for (b = 0; b < ZTEST_DMU_READ_BLOCKS; b++) {
+		if (ztest_write(zd, od->od_object, b * blocksize, blocksize,
+		    buf + b * blocksize) != 0)
+			goto out;
+	}
+	txg_wait_synced(dmu_objset_pool(os), 0);
+
+	/* Warm the dbuf cache before timing the reads. */
+	for (off = 0; off < size; off += ZTEST_DMU_READ_CHUNK) {
+		if (dmu_read(os, od->od_object, off, ZTEST_DMU_READ_CHUNK,
+		    readbuf, DMU_READ_NO_PREFETCH) != 0)
+			goto out;
+	}
+
+	start = gethrtime();
+	for (pass = 0; pass < ZTEST_DMU_READ_PASSES; pass++) {
+		for (off = 0; off < size; off += ZTEST_DMU_READ_CHUNK) {
+			VERIFY0(dmu_read(os, od->od_object, off,
+			    ZTEST_DMU_READ_CHUNK, readbuf,
+			    DMU_READ_NO_PREFETCH));
+			VERIFY0(bcmp(readbuf, buf + off,
+			    ZTEST_DMU_READ_CHUNK));
+			bytes += ZTEST_DMU_READ_CHUNK;
+		}
+	}
+	delta = MAX(gethrtime() - start, 1);
+
+	if (ztest_opts.zo_verbose >= 4) {
+		(void) printf("dmu_read sequential: %llu bytes, "
+		    "%llu MB/sec\n", (u_longlong_t)bytes,
+		    (u_longlong_t)(bytes * NANOSEC / delta / (1024 * 1024)));
+	}
+
+out:
+	umem_free(readbuf, ZTEST_DMU_READ_CHUNK);
+	umem_free(buf, size);
+	umem_free(od, sizeof (ztest_od_t));
+}
+
 /*
  * Verify that zap_{create,destroy,add,remove,update} work as expected.
  */
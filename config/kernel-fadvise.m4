@@ -0,0 +1,47 @@
+dnl #
+dnl # Linux 4.19 API
+dnl # The fadvise callback was added to the file_operations structure,
+dnl # and generic_fadvise() was exported for it in Linux 5.3.
+dnl #
+AC_DEFUN([ZFS_AC_KERNEL_SRC_FADVISE], [
+	ZFS_LINUX_TEST_SRC([file_fadvise], [
+		#include <linux/fs.h>
+
+		int test_fadvise(struct file *file, loff_t offset,
+		    loff_t len, int advice) { return 0; }
+
+		static const struct file_operations
+		    fops __attribute__ ((unused)) = {
+			.fadvise = test_fadvise,
+		};
+	], [])
+
+	ZFS_LINUX_TEST_SRC([generic_fadvise], [
+		#include <linux/fs.h>
+	], [
+		struct file *fp __attribute__ ((unused)) = NULL;
+		int error __attribute__ ((unused));
+
+		error = generic_fadvise(fp, 0, 0, 0);
+	])
+])
+
+AC_DEFUN([ZFS_AC_KERNEL_FADVISE], [
+	AC_MSG_CHECKING([whether fops->fadvise() exists])
+	ZFS_LINUX_TEST_RESULT([file_fadvise], [
+		AC_MSG_RESULT(yes)
+		AC_DEFINE(HAVE_FILE_FADVISE, 1, [fops->fadvise() exists])
+	],[
+		AC_MSG_RESULT(no)
+	])
+
+	AC_MSG_CHECKING([whether generic_fadvise() is available])
+	ZFS_LINUX_TEST_RESULT_SYMBOL([generic_fadvise],
+	    [generic_fadvise], [mm/fadvise.c], [
+		AC_MSG_RESULT(yes)
+		AC_DEFINE(HAVE_GENERIC_FADVISE, 1,
+		    [generic_fadvise() is available])
+	],[
+		AC_MSG_RESULT(no)
+	])
+])
@@ -74,6 +74,18 @@ AC_DEFUN([ZFS_AC_KERNEL_SRC_VFS_IOV_ITER], [
 
 		bytes = copy_from_iter((void *)&buf, size, &iter);
 	])
+
+	ZFS_LINUX_TEST_SRC([iov_iter_get_pages], [
+		#include <linux/fs.h>
+		#include <linux/uio.h>
+	],[
+		struct iov_iter iter = { 0 };
+		struct page *pages[1];
+		size_t start;
+		ssize_t bytes __attribute__ ((unused));
+
+		bytes = iov_iter_get_pages(&iter, pages, PAGE_SIZE, 1, &start);
+	])
 ])
 
 AC_DEFUN([ZFS_AC_KERNEL_VFS_IOV_ITER], [
@@ -149,6 +161,18 @@ AC_DEFUN([ZFS_AC_KERNEL_VFS_IOV_ITER], [
 		enable_vfs_iov_iter="no"
 	])
 
+	dnl #
+	dnl # Optional, used to pin user pages for zero-copy direct writes.
+	dnl #
+	AC_MSG_CHECKING([whether iov_iter_get_pages() is available])
+	ZFS_LINUX_TEST_RESULT([iov_iter_get_pages], [
+		AC_MSG_RESULT(yes)
+		AC_DEFINE(HAVE_IOV_ITER_GET_PAGES, 1,
+		    [iov_iter_get_pages() is available])
+	],[
+		AC_MSG_RESULT(no)
+	])
+
 	dnl #
 	dnl # As of the 4.9 kernel support is provided for iovecs, kvecs,
 	dnl # bvecs and pipes in the iov_iter structure.  As long as the
@@ -89,6 +89,22 @@ blk_queue_set_write_cache(struct request_queue *q, bool wc, bool fua)
 #endif
 }
 
+/*
+ * Returns true when the queue has a volatile write cache which must be
+ * flushed.  A write-through queue, such as an NVMe device with power-loss
+ * protection or a device set to "write through" in the sysfs write_cache
+ * attribute, completes cache flushes without any work.
+ */
+static inline boolean_t
+blk_queue_has_write_cache(struct request_queue *q)
+{
+#if defined(HAVE_BLK_QUEUE_WRITE_CACHE)
+	return (test_bit(QUEUE_FLAG_WC, &q->queue_flags) ? B_TRUE : B_FALSE);
+#else
+	return ((q->flush_flags & REQ_FLUSH) ? B_TRUE : B_FALSE);
+#endif
+}
+
 static inline void
 blk_queue_set_read_ahead(struct request_queue *q, unsigned long ra_pages)
 {
@@ -46,6 +46,7 @@ typedef enum abd_flags {
 	ABD_FLAG_GANG_FREE	= 1 << 7, /* gang ABD is responsible for mem */
 	ABD_FLAG_ZEROS		= 1 << 8, /* ABD for zero-filled buffer */
 	ABD_FLAG_ALLOCD		= 1 << 9, /* we allocated the abd_t */
+	ABD_FLAG_FROM_PAGES	= 1 << 10, /* holds refs on pinned pages */
 } abd_flags_t;
 
 typedef struct abd {
@@ -212,6 +213,7 @@ void abd_fini(void);
 #if defined(__linux__) && defined(_KERNEL)
 unsigned int abd_bio_map_off(struct bio *, abd_t *, unsigned int, size_t);
 unsigned long abd_nr_pages_off(abd_t *, unsigned int, size_t);
+abd_t *abd_alloc_from_pages(struct page **, unsigned long, uint64_t);
 #endif
 
 #ifdef __cplusplus
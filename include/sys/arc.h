@@ -62,6 +62,7 @@ _NOTE(CONSTCOND) } while (0)
 typedef struct arc_buf_hdr arc_buf_hdr_t;
 typedef struct arc_buf arc_buf_t;
 typedef struct arc_prune arc_prune_t;
+typedef struct arc_dataset arc_dataset_t;
 
 /*
  * Because the ARC can store encrypted data, errors (not due to bugs) may arise
@@ -292,17 +293,35 @@ int arc_referenced(arc_buf_t *buf);
 int arc_read(zio_t *pio, spa_t *spa, const blkptr_t *bp,
     arc_read_done_func_t *done, void *priv, zio_priority_t priority,
     int flags, arc_flags_t *arc_flags, const zbookmark_phys_t *zb);
+int arc_read_dataset(zio_t *pio, spa_t *spa, const blkptr_t *bp,
+    arc_read_done_func_t *done, void *priv, zio_priority_t priority,
+    int flags, arc_flags_t *arc_flags, const zbookmark_phys_t *zb,
+    arc_dataset_t *ad);
 zio_t *arc_write(zio_t *pio, spa_t *spa, uint64_t txg,
     blkptr_t *bp, arc_buf_t *buf, boolean_t l2arc, const zio_prop_t *zp,
     arc_write_done_func_t *ready, arc_write_done_func_t *child_ready,
     arc_write_done_func_t *physdone, arc_write_done_func_t *done,
     void *priv, zio_priority_t priority, int zio_flags,
-    const zbookmark_phys_t *zb);
+    const zbookmark_phys_t *zb, arc_dataset_t *ad);
 
 arc_prune_t *arc_add_prune_callback(arc_prune_func_t *func, void *priv);
 void arc_remove_prune_callback(arc_prune_t *p);
 void arc_freed(spa_t *spa, const blkptr_t *bp);
 
+arc_dataset_t *arc_dataset_register(spa_t *spa, uint64_t objset);
+void arc_dataset_unregister(arc_dataset_t *ad);
+void arc_dataset_hold(arc_dataset_t *ad);
+void arc_dataset_rele(arc_dataset_t *ad);
+void arc_dataset_set_quota(arc_dataset_t *ad, uint64_t quota);
+void arc_dataset_set_reservation(arc_dataset_t *ad, uint64_t reservation);
+void arc_dataset_set_l2arc_admit(arc_dataset_t *ad, zfs_l2arc_admit_t admit);
+void arc_dataset_stats(arc_dataset_t *ad, uint64_t *size, uint64_t *hits,
+    uint64_t *misses);
+void arc_dataset_prefetch_update(arc_dataset_t *ad, int64_t streams,
+    int64_t distance);
+void arc_dataset_prefetch_stats(arc_dataset_t *ad, uint64_t *streams,
+    uint64_t *distance);
+
 void arc_flush(spa_t *spa, boolean_t retry);
 void arc_tempreserve_clear(uint64_t reserve);
 int arc_tempreserve_space(spa_t *spa, uint64_t reserve, uint64_t txg);
@@ -117,6 +117,49 @@ struct arc_write_callback {
 	arc_buf_t		*awcb_buf;
 };
 
+/*
+ * Per-dataset ARC accounting.  Buffers read or written on behalf of a
+ * registered objset are charged to it while they are cached in the MRU or
+ * MFU state.  The quota is a soft limit: while any dataset is above it,
+ * eviction prefers that dataset's buffers.  Buffers of a dataset which is
+ * within its reservation are passed over by eviction where possible.
+ *
+ * An arc_dataset_t is held by its registration and by every header
+ * charged to it, so it outlives the objset if buffers remain cached.
+ */
+struct arc_dataset {
+	avl_node_t	ad_node;
+	uint64_t	ad_spa;		/* spa_load_guid() of the pool */
+	uint64_t	ad_objset;	/* objset id */
+	uint64_t	ad_nregs;	/* registrations, arc_dataset_lock */
+	uint64_t	ad_refcnt;	/* registrations and charged headers */
+	uint64_t	ad_quota;	/* soft limit in bytes, 0 if none */
+	uint64_t	ad_reservation;	/* guaranteed bytes, 0 if none */
+	uint64_t	ad_size;	/* bytes charged by MRU/MFU headers */
+	uint64_t	ad_hits;
+	uint64_t	ad_misses;
+	zfs_l2arc_admit_t ad_l2arc_admit; /* l2arc_admit property */
+	/* predictive prefetch streams and the sum of their distances */
+	uint64_t	ad_pf_streams;
+	uint64_t	ad_pf_distance;
+};
+
+/*
+ * An uncompressed copy of a frequently read, compressed MRU/MFU buffer,
+ * kept so that filling new uncompressed bufs for the header is a copy
+ * rather than a decompression.  The copy is attached and detached under
+ * the header's hash lock; uc_node and the list of copies are protected by
+ * arc_ucache_lock.
+ */
+typedef struct arc_ucache {
+	list_node_t	uc_node;
+	arc_buf_hdr_t	*uc_hdr;
+	void		*uc_data;
+	uint64_t	uc_size;
+	arc_buf_contents_t uc_type;
+	boolean_t	uc_referenced;	/* hit since last eviction scan */
+} arc_ucache_t;
+
 /*
  * ARC buffers are separated into multiple structs as a memory saving measure:
  *   - Common fields struct, always defined, and embedded within it:
@@ -157,6 +200,8 @@ typedef struct l1arc_buf_hdr {
 	/* for waiting on writes to complete */
 	kcondvar_t		b_cv;
 	uint8_t			b_byteswap;
+	/* times the data was decompressed to fill a buf, updated atomically */
+	uint32_t		b_decomp_cnt;
 
 
 	/* protected by arc state mutex */
@@ -176,6 +221,12 @@ typedef struct l1arc_buf_hdr {
 
 	arc_callback_t		*b_acb;
 	abd_t			*b_pabd;
+
+	/* dataset charged for this buffer, see arc_dataset_t */
+	arc_dataset_t		*b_dataset;
+
+	/* uncompressed copy of a compressed buffer, see arc_ucache_t */
+	arc_ucache_t		*b_ucache;
 } l1arc_buf_hdr_t;
 
 typedef enum l2arc_dev_hdr_flags_t {
@@ -379,6 +430,7 @@ typedef struct l2arc_dev {
 	kmutex_t		l2ad_mtx;	/* lock for buffer list */
 	list_t			l2ad_buflist;	/* buffer list */
 	list_node_t		l2ad_node;	/* device list node */
+	uint_t			l2ad_id;	/* index in l2arc_dev_table */
 	zfs_refcount_t		l2ad_alloc;	/* allocated bytes */
 	/*
 	 * Persistence-related stuff
@@ -411,6 +463,21 @@ typedef struct l2arc_dev {
 	 */
 	zfs_refcount_t		l2ad_lb_count;
 	boolean_t		l2ad_trim_all; /* TRIM whole device */
+	/*
+	 * Progress of an ongoing rebuild, reported in arcstats. The start
+	 * time is zero when no rebuild is running.
+	 */
+	hrtime_t		l2ad_rebuild_start;
+	uint64_t		l2ad_rebuild_lb_total; /* log blocks to read */
+	uint64_t		l2ad_rebuild_lb_done; /* log blocks restored */
+	uint64_t		l2ad_rebuild_asize; /* restored payload */
+	/*
+	 * Arcstat snapshots taken by the previous adaptive feed pass
+	 * to this device, see l2arc_write_size_adaptive().
+	 */
+	uint64_t		l2ad_feed_evicted;
+	uint64_t		l2ad_feed_hits;
+	uint64_t		l2ad_feed_misses;
 } l2arc_dev_t;
 
 /*
@@ -445,13 +512,32 @@ typedef struct arc_buf_hdr_crypt {
 
 typedef struct l2arc_buf_hdr {
 	/* protected by arc_buf_hdr mutex */
-	l2arc_dev_t		*b_dev;		/* L2ARC device */
-	uint64_t		b_daddr;	/* disk address, offset byte */
-	uint32_t		b_hits;
-	arc_state_type_t	b_arcs_state;
+	uint64_t		b_l2prop;	/* see L2HDR_* macros */
 	list_node_t		b_l2node;
 } l2arc_buf_hdr_t;
 
+/*
+ * Since there can be hundreds of millions of L2ARC-only headers, the
+ * device, disk address and ARC state of an L2ARC buffer are packed into
+ * b_l2prop rather than kept as separate fields:
+ *	* disk address, in units of SPA_MINBLOCKSIZE (48 bits)
+ *	* ARC state of the buffer when it was written (4 bits)
+ *	* index of the device in l2arc_dev_table (12 bits)
+ */
+#define	L2HDR_GET_DADDR(l2hdr)	\
+	BF64_GET_SB((l2hdr)->b_l2prop, 0, 48, SPA_MINBLOCKSHIFT, 0)
+#define	L2HDR_SET_DADDR(l2hdr, x)	\
+	BF64_SET_SB((l2hdr)->b_l2prop, 0, 48, SPA_MINBLOCKSHIFT, 0, x)
+#define	L2HDR_GET_STATE(l2hdr)	\
+	((arc_state_type_t)BF64_GET((l2hdr)->b_l2prop, 48, 4))
+#define	L2HDR_SET_STATE(l2hdr, x)	\
+	BF64_SET((l2hdr)->b_l2prop, 48, 4, x)
+#define	L2HDR_GET_DEVID(l2hdr)	BF64_GET((l2hdr)->b_l2prop, 52, 12)
+#define	L2HDR_SET_DEVID(l2hdr, x)	BF64_SET((l2hdr)->b_l2prop, 52, 12, x)
+
+/* Maximum number of L2ARC devices, limited by the width of the index */
+#define	L2ARC_DEV_MAX		(1 << 12)
+
 typedef struct l2arc_write_callback {
 	l2arc_dev_t	*l2wcb_dev;		/* device info */
 	arc_buf_hdr_t	*l2wcb_head;		/* head of write buflist */
@@ -781,6 +867,14 @@ typedef struct arc_stats {
 	kstat_named_t arcstat_l2_psize;
 	/* Not updated directly; only synced in arc_kstat_update. */
 	kstat_named_t arcstat_l2_hdr_size;
+	/*
+	 * Number of buffers cached in the L2ARC, and the header memory
+	 * they need per MiB of L2ARC data once they are only in the L2ARC.
+	 * The latter is computed in arc_kstat_update and is meant to help
+	 * size the RAM needed for a given L2ARC capacity.
+	 */
+	kstat_named_t arcstat_l2_hdrs;
+	kstat_named_t arcstat_l2_hdr_bytes_per_mib;
 	/*
 	 * Number of L2ARC log blocks written. These are used for restoring the
 	 * L2ARC. Updated during writing of L2ARC log blocks.
@@ -850,6 +944,21 @@ typedef struct arc_stats {
 	 * log block may hold up to L2ARC_LOG_BLK_MAX_ENTRIES buffers.
 	 */
 	kstat_named_t arcstat_l2_rebuild_log_blks;
+	/* Number of L2ARC devices currently being rebuilt. */
+	kstat_named_t arcstat_l2_rebuild_active;
+	/* Total time spent in completed L2ARC rebuilds, in milliseconds. */
+	kstat_named_t arcstat_l2_rebuild_time_ms;
+	/*
+	 * Aligned size of L2ARC data restored per second by the ongoing
+	 * rebuilds, combined.
+	 */
+	kstat_named_t arcstat_l2_rebuild_rate;
+	/*
+	 * Estimated number of seconds until the last ongoing L2ARC rebuild
+	 * completes, based on the rate at which each device has restored
+	 * its log blocks so far.
+	 */
+	kstat_named_t arcstat_l2_rebuild_eta_secs;
 	kstat_named_t arcstat_memory_throttle_count;
 	kstat_named_t arcstat_memory_direct_count;
 	kstat_named_t arcstat_memory_indirect_count;
@@ -874,6 +983,102 @@ typedef struct arc_stats {
 	kstat_named_t arcstat_raw_size;
 	kstat_named_t arcstat_cached_only_in_progress;
 	kstat_named_t arcstat_abd_chunk_waste_size;
+	/*
+	 * Hits and misses counted while the access-frequency (LFU) filter
+	 * is enabled, so the policy can be compared against classic ARC.
+	 */
+	kstat_named_t arcstat_lfu_hits;
+	kstat_named_t arcstat_lfu_misses;
+	/*
+	 * Number of promotions to the MFU state allowed or refused by the
+	 * access-frequency filter.
+	 */
+	kstat_named_t arcstat_lfu_admitted;
+	kstat_named_t arcstat_lfu_rejected;
+	/*
+	 * Number of headers skipped during eviction because the filter
+	 * considered them frequently used, and number of evicted headers
+	 * which had been accessed only once.
+	 */
+	kstat_named_t arcstat_lfu_evict_protected;
+	kstat_named_t arcstat_lfu_evict_onehit;
+	/* Number of times the filter's counters were aged. */
+	kstat_named_t arcstat_lfu_sketch_resets;
+	/* Number of locks protecting the buffer hash table. */
+	kstat_named_t arcstat_hash_locks;
+	/*
+	 * Number of hash lock acquisitions on the lookup paths which found
+	 * the lock already held, and the total time in nanoseconds spent
+	 * waiting for it in those cases.
+	 */
+	kstat_named_t arcstat_hash_lock_contended;
+	kstat_named_t arcstat_hash_lock_wait_ns;
+	/*
+	 * Number of hits on buffers held by the dbuf layer which were
+	 * accounted without taking the hash lock.
+	 */
+	kstat_named_t arcstat_access_lockless;
+	/*
+	 * Number of headers passed over by eviction to honor a dataset's
+	 * ARC reservation or to evict over-quota datasets first, and the
+	 * number of datasets found over their ARC quota.
+	 */
+	kstat_named_t arcstat_dataset_evict_protected;
+	kstat_named_t arcstat_dataset_over_quota;
+	/*
+	 * Number of threads evicting the sublists of an ARC state in
+	 * parallel, and the number of eviction scans that were split
+	 * between them.
+	 */
+	kstat_named_t arcstat_evict_threads;
+	kstat_named_t arcstat_evict_parallel_scans;
+	/*
+	 * Number of per-sublist eviction tasks run by the eviction threads,
+	 * the bytes they evicted and the total time they spent doing so;
+	 * evict_parallel_bytes / evict_parallel_time_ns is the per-thread
+	 * eviction throughput.
+	 */
+	kstat_named_t arcstat_evict_parallel_tasks;
+	kstat_named_t arcstat_evict_parallel_bytes;
+	kstat_named_t arcstat_evict_parallel_time_ns;
+	/*
+	 * Bytes decompressed when filling uncompressed bufs from compressed
+	 * headers, and the time spent doing so.
+	 */
+	kstat_named_t arcstat_decompress_bytes;
+	kstat_named_t arcstat_decompress_time_ns;
+	/*
+	 * Size of the uncompressed copies kept for hot compressed buffers,
+	 * the number of bufs filled from them instead of decompressing, and
+	 * the number of copies dropped to relieve memory pressure or to stay
+	 * within zfs_arc_ucache_percent.
+	 */
+	kstat_named_t arcstat_ucache_size;
+	kstat_named_t arcstat_ucache_hits;
+	kstat_named_t arcstat_ucache_evictions;
+	/*
+	 * Bytes which did not need to be decompressed thanks to the
+	 * uncompressed copies, and the decompression time this is estimated
+	 * to have saved based on the measured decompression rate.
+	 */
+	kstat_named_t arcstat_decompress_saved_bytes;
+	kstat_named_t arcstat_decompress_saved_ns;
+	/*
+	 * Bytes written to the L2ARC and L2ARC hits, broken down by the
+	 * l2arc_admit policy of the dataset the buffers belong to. Buffers
+	 * without a dataset (the MOS and snapshots) count under "all".
+	 */
+	kstat_named_t arcstat_l2_admit_all_write_bytes;
+	kstat_named_t arcstat_l2_admit_all_hits;
+	kstat_named_t arcstat_l2_admit_mfu_write_bytes;
+	kstat_named_t arcstat_l2_admit_mfu_hits;
+	kstat_named_t arcstat_l2_admit_reread_write_bytes;
+	kstat_named_t arcstat_l2_admit_reread_hits;
+	/*
+	 * Number of bytes the most recent L2ARC feed pass aimed to write
+	 * to each cache device.
+	 */
+	kstat_named_t arcstat_l2_feed_size;
 } arc_stats_t;
 
 typedef struct arc_evict_waiter {
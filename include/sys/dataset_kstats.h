@@ -28,6 +28,7 @@
 #define	_SYS_DATASET_KSTATS_H
 
 #include <sys/aggsum.h>
+#include <sys/arc.h>
 #include <sys/dmu.h>
 #include <sys/kstat.h>
 
@@ -56,11 +57,25 @@ typedef struct dataset_kstat_values {
 	 * entry is removed from the unlinked set
 	 */
 	kstat_named_t dkv_nunlinked;
+	/*
+	 * Bytes of ARC memory charged to the dataset, and ARC hits and
+	 * misses on its buffers.
+	 */
+	kstat_named_t dkv_arc_size;
+	kstat_named_t dkv_arc_hits;
+	kstat_named_t dkv_arc_misses;
+	/*
+	 * Predictive prefetch streams of the dataset's objects, and the sum
+	 * of their current prefetch distances in bytes.
+	 */
+	kstat_named_t dkv_prefetch_streams;
+	kstat_named_t dkv_prefetch_distance;
 } dataset_kstat_values_t;
 
 typedef struct dataset_kstats {
 	dataset_aggsum_stats_t dk_aggsums;
 	kstat_t *dk_kstats;
+	arc_dataset_t *dk_arc_dataset;
 } dataset_kstats_t;
 
 void dataset_kstats_create(dataset_kstats_t *, objset_t *);
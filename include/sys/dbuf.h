@@ -55,6 +55,7 @@ extern "C" {
 #define	DB_RF_NEVERWAIT		(1 << 4)
 #define	DB_RF_CACHED		(1 << 5)
 #define	DB_RF_NO_DECRYPT	(1 << 6)
+#define	DB_RF_NO_DIRECT		(1 << 7)
 
 /*
  * The simplified state transition diagram for dbufs looks like:
@@ -172,6 +173,22 @@ typedef struct dbuf_dirty_record {
 			boolean_t dr_nopwrite;
 			boolean_t dr_has_raw_params;
 
+			/*
+			 * If the block was partially overwritten without
+			 * being read (see dmu_buf_will_dirty_range()),
+			 * the byte ranges of dr_data that hold valid data.
+			 * The rest is filled in from the previous version
+			 * of the block by dbuf_partial_fill().
+			 */
+			struct range_tree *dr_partial;
+
+			/*
+			 * dr_overridden_by was written by dmu_write_direct()
+			 * and dr_data is NULL; the dbuf is in the DB_NOFILL
+			 * state until it is read or refilled.
+			 */
+			boolean_t dr_direct;
+
 			/*
 			 * If dr_has_raw_params is set, the following crypt
 			 * params will be set on the BP that's written.
@@ -318,16 +335,39 @@ typedef struct dmu_buf_impl {
 	 */
 	uint8_t db_pending_evict;
 
+	/*
+	 * Written by direct I/O: once the refcount drops to 0, evict this
+	 * dbuf and its ARC buffer instead of caching them.
+	 */
+	uint8_t db_uncached;
+
+	/*
+	 * dbuf_partial_fill() is reading the previous version of this
+	 * block to complete a partially overwritten dirty record, or
+	 * dbuf_read() is reading a block written by dmu_write_direct().
+	 */
+	uint8_t db_partial_filling;
+
 	uint8_t db_dirtycnt;
 } dmu_buf_impl_t;
 
-/* Note: the dbuf hash table is exposed only for the mdb module */
-#define	DBUF_MUTEXES 8192
-#define	DBUF_HASH_MUTEX(h, idx) (&(h)->hash_mutexes[(idx) & (DBUF_MUTEXES-1)])
+/*
+ * Note: the dbuf hash table is exposed only for the mdb module.
+ *
+ * The hash table locks are striped over the table.  At least DBUF_RWLOCKS
+ * locks are used, and more on systems with many CPUs.  Lookups take them
+ * as readers so that concurrent hits on the same chain do not serialize;
+ * inserts and removals take them as writers.
+ */
+#define	DBUF_RWLOCKS		8192
+#define	DBUF_RWLOCKS_PER_CPU	256
+#define	DBUF_HASH_RWLOCK(h, idx) \
+	(&(h)->hash_rwlocks[(idx) & (h)->hash_rwlock_mask])
 typedef struct dbuf_hash_table {
 	uint64_t hash_table_mask;
 	dmu_buf_impl_t **hash_table;
-	kmutex_t hash_mutexes[DBUF_MUTEXES];
+	uint64_t hash_rwlock_mask;
+	krwlock_t *hash_rwlocks;
 } dbuf_hash_table_t;
 
 typedef void (*dbuf_prefetch_fn)(void *, boolean_t);
@@ -346,6 +386,8 @@ dmu_buf_impl_t *dbuf_hold_level(struct dnode *dn, int level, uint64_t blkid,
 int dbuf_hold_impl(struct dnode *dn, uint8_t level, uint64_t blkid,
     boolean_t fail_sparse, boolean_t fail_uncached,
     void *tag, dmu_buf_impl_t **dbp);
+int dbuf_hold_array(struct dnode *dn, uint64_t blkid, uint64_t nblks,
+    void *tag, dmu_buf_t **dbp);
 
 int dbuf_prefetch_impl(struct dnode *dn, int64_t level, uint64_t blkid,
     zio_priority_t prio, arc_flags_t aflags, dbuf_prefetch_fn cb,
@@ -368,7 +410,12 @@ int dbuf_read(dmu_buf_impl_t *db, zio_t *zio, uint32_t flags);
 void dmu_buf_will_not_fill(dmu_buf_t *db, dmu_tx_t *tx);
 void dmu_buf_will_fill(dmu_buf_t *db, dmu_tx_t *tx);
 void dmu_buf_fill_done(dmu_buf_t *db, dmu_tx_t *tx);
+int dbuf_partial_fill(dmu_buf_impl_t *db, uint64_t txg, enum zio_flag flags);
+void dbuf_partial_discard(dbuf_dirty_record_t *dr);
 void dbuf_assign_arcbuf(dmu_buf_impl_t *db, arc_buf_t *buf, dmu_tx_t *tx);
+boolean_t dbuf_direct_ok(dmu_buf_impl_t *db, dmu_tx_t *tx);
+boolean_t dbuf_assign_direct(dmu_buf_impl_t *db, const blkptr_t *bp,
+    uint8_t copies, dmu_tx_t *tx);
 dbuf_dirty_record_t *dbuf_dirty(dmu_buf_impl_t *db, dmu_tx_t *tx);
 dbuf_dirty_record_t *dbuf_dirty_lightweight(dnode_t *dn, uint64_t blkid,
     dmu_tx_t *tx);
@@ -440,7 +487,17 @@ dbuf_find_dirty_eq(dmu_buf_impl_t *db, uint64_t txg)
 #define	DBUF_IS_CACHEABLE(_db)						\
 	((_db)->db_objset->os_primary_cache == ZFS_CACHE_ALL ||		\
 	(dbuf_is_metadata(_db) &&					\
-	((_db)->db_objset->os_primary_cache == ZFS_CACHE_METADATA)))
+	((_db)->db_objset->os_primary_cache == ZFS_CACHE_METADATA ||	\
+	(_db)->db_objset->os_primary_cache == ZFS_CACHE_UNCACHED)))
+
+/*
+ * Data buffers of a primarycache=uncached dataset are read and prefetched
+ * through the ARC as usual, but are evicted as soon as the last hold on
+ * the dbuf is released.
+ */
+#define	DBUF_IS_UNCACHED(_db)						\
+	((_db)->db_objset->os_primary_cache == ZFS_CACHE_UNCACHED &&	\
+	!dbuf_is_metadata(_db))
 
 #define	DBUF_IS_L2CACHEABLE(_db)					\
 	((_db)->db_objset->os_secondary_cache == ZFS_CACHE_ALL ||	\
@@ -75,6 +75,7 @@ struct zio_prop;
 struct sa_handle;
 struct dsl_crypto_params;
 struct locked_range;
+struct abd;
 
 typedef struct objset objset_t;
 typedef struct dmu_tx dmu_tx_t;
@@ -564,6 +565,17 @@ int dmu_buf_hold_by_dnode(dnode_t *dn, uint64_t offset,
 int dmu_buf_hold_array_by_dnode(dnode_t *dn, uint64_t offset,
     uint64_t length, boolean_t read, void *tag, int *numbufsp,
     dmu_buf_t ***dbpp, uint32_t flags);
+
+/*
+ * Called once the blocks of an asynchronous read are available, or with
+ * the error which prevented one of them from being read.  The dbufs stay
+ * held until the callback returns.
+ */
+typedef void dmu_read_done_func_t(void *arg, dmu_buf_t **dbp, int numbufs,
+    int error);
+int dmu_read_async_dnode(dnode_t *dn, uint64_t offset, uint64_t length,
+    void *tag, int *numbufsp, dmu_buf_t ***dbpp, dmu_read_done_func_t *done,
+    void *arg, uint32_t flags);
 /*
  * Add a reference to a dmu buffer that has already been held via
  * dmu_buf_hold() in the current context.
@@ -742,6 +754,13 @@ struct blkptr *dmu_buf_get_blkptr(dmu_buf_t *db);
  * (ie. you've called dmu_tx_hold_object(tx, db->db_object)).
  */
 void dmu_buf_will_dirty(dmu_buf_t *db, dmu_tx_t *tx);
+/*
+ * Like dmu_buf_will_dirty(), when only the range [off, off + len) of the
+ * buffer will be modified.  The old contents of a large level-0 block
+ * that is not cached are then only read if and when they are needed.
+ */
+void dmu_buf_will_dirty_range(dmu_buf_t *db, uint64_t off, uint64_t len,
+    dmu_tx_t *tx);
 boolean_t dmu_buf_is_dirty(dmu_buf_t *db, dmu_tx_t *tx);
 void dmu_buf_set_crypt_params(dmu_buf_t *db_fake, boolean_t byteorder,
     const uint8_t *salt, const uint8_t *iv, const uint8_t *mac, dmu_tx_t *tx);
@@ -833,6 +852,7 @@ int dmu_free_long_object(objset_t *os, uint64_t object);
 #define	DMU_READ_PREFETCH	0 /* prefetch */
 #define	DMU_READ_NO_PREFETCH	1 /* don't prefetch */
 #define	DMU_READ_NO_DECRYPT	2 /* don't decrypt */
+#define	DMU_READ_NO_DIRECT	4 /* don't read dmu_write_direct() blocks */
 int dmu_read(objset_t *os, uint64_t object, uint64_t offset, uint64_t size,
 	void *buf, uint32_t flags);
 int dmu_read_by_dnode(dnode_t *dn, uint64_t offset, uint64_t size, void *buf,
@@ -847,6 +867,8 @@ void dmu_prealloc(objset_t *os, uint64_t object, uint64_t offset, uint64_t size,
 int dmu_read_uio(objset_t *os, uint64_t object, zfs_uio_t *uio, uint64_t size);
 int dmu_read_uio_dbuf(dmu_buf_t *zdb, zfs_uio_t *uio, uint64_t size);
 int dmu_read_uio_dnode(dnode_t *dn, zfs_uio_t *uio, uint64_t size);
+int dmu_read_uio_dnode_nowait(dnode_t *dn, zfs_uio_t *uio, uint64_t size);
+int dmu_read_uio_direct(dnode_t *dn, zfs_uio_t *uio, uint64_t size);
 int dmu_write_uio(objset_t *os, uint64_t object, zfs_uio_t *uio, uint64_t size,
 	dmu_tx_t *tx);
 int dmu_write_uio_dbuf(dmu_buf_t *zdb, zfs_uio_t *uio, uint64_t size,
@@ -860,6 +882,10 @@ int dmu_assign_arcbuf_by_dnode(dnode_t *dn, uint64_t offset,
     struct arc_buf *buf, dmu_tx_t *tx);
 int dmu_assign_arcbuf_by_dbuf(dmu_buf_t *handle, uint64_t offset,
     struct arc_buf *buf, dmu_tx_t *tx);
+int dmu_assign_arcbuf_direct(dmu_buf_t *handle, uint64_t offset,
+    struct arc_buf *buf, dmu_tx_t *tx);
+int dmu_write_direct(dnode_t *dn, uint64_t offset, struct abd *data,
+    dmu_tx_t *tx);
 #define	dmu_assign_arcbuf	dmu_assign_arcbuf_by_dbuf
 extern int zfs_prefetch_disable;
 extern int zfs_max_recordsize;
@@ -870,6 +896,17 @@ extern int zfs_max_recordsize;
 void dmu_prefetch(objset_t *os, uint64_t object, int64_t level, uint64_t offset,
 	uint64_t len, enum zio_priority pri);
 
+/*
+ * Access pattern hints for the predictive prefetcher of an object.
+ */
+typedef enum dmu_prefetch_hint {
+	DMU_PREFETCH_NORMAL,		/* detect streams */
+	DMU_PREFETCH_RANDOM,		/* no predictive prefetch */
+	DMU_PREFETCH_SEQUENTIAL		/* prefetch as far ahead as allowed */
+} dmu_prefetch_hint_t;
+
+void dmu_prefetch_hint(dmu_buf_t *db, dmu_prefetch_hint_t hint);
+
 typedef struct dmu_object_info {
 	/* All sizes are in bytes unless otherwise indicated. */
 	uint32_t doi_data_block_size;
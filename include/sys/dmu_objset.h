@@ -99,6 +99,7 @@ struct objset {
 	arc_buf_t *os_phys_buf;
 	objset_phys_t *os_phys;
 	boolean_t os_encrypted;
+	arc_dataset_t *os_arc_dataset;	/* NULL for snapshots and the MOS */
 
 	/*
 	 * The following "special" dnodes have no parent, are exempt
@@ -125,6 +126,8 @@ struct objset {
 	zfs_logbias_op_t os_logbias;
 	zfs_cache_type_t os_primary_cache;
 	zfs_cache_type_t os_secondary_cache;
+	uint64_t os_prefetch_distance;	/* 0 for zfetch_max_distance */
+	zfs_direct_t os_direct;
 	zfs_sync_type_t os_sync;
 	zfs_redundant_metadata_type_t os_redundant_metadata;
 	uint64_t os_recordsize;
@@ -170,6 +173,9 @@ struct objset {
 	uint64_t *os_obj_next_percpu;
 	int os_obj_next_percpu_len;
 
+	/* Recently held dnodes, see dnode_hold_impl() */
+	dnode_hold_cache_t os_dnode_hold_cache;
+
 	/* Protected by os_lock */
 	kmutex_t os_lock;
 	multilist_t *os_dirty_dnodes[TXG_SIZE];
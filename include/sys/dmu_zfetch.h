@@ -31,6 +31,7 @@
 #define	_DMU_ZFETCH_H
 
 #include <sys/zfs_context.h>
+#include <sys/dmu.h>
 
 #ifdef	__cplusplus
 extern "C" {
@@ -45,12 +46,29 @@ typedef struct zfetch {
 	list_t		zf_stream;	/* list of zstream_t's */
 	struct dnode	*zf_dnode;	/* dnode that owns this zfetch */
 	int		zf_numstreams;	/* number of zstream_t's */
+	uint64_t	zf_lastmiss;	/* blkid of last unmatched access */
+	int64_t		zf_lastdelta;	/* distance to the one before it */
+	dmu_prefetch_hint_t zf_hint;	/* access pattern hint */
 } zfetch_t;
 
 typedef struct zstream {
 	uint64_t	zs_blkid;	/* expect next access at this blkid */
+
+	/*
+	 * Blocks between the starts of consecutive accesses of a strided
+	 * or backward stream, which may be negative, and the length of
+	 * each access.  Zero for forward sequential streams.  For strided
+	 * streams zs_pf_blkid1 and zs_pf_blkid hold the first and one past
+	 * the last access start to prefetch, stepping by zs_stride.
+	 */
+	int64_t		zs_stride;
+	uint64_t	zs_nblks;
+
 	uint64_t	zs_pf_blkid1;	/* first block to prefetch */
 	uint64_t	zs_pf_blkid;	/* block to prefetch up to */
+	uint32_t	zs_pf_dist;	/* data prefetch distance in bytes */
+	uint32_t	zs_pf_hits;	/* hits since zs_pf_dist changed */
+	boolean_t	zs_late;	/* reads missed since the last hit */
 
 	/*
 	 * We will next prefetch the L1 indirect block of this level-0
@@ -76,6 +94,7 @@ void		zfetch_fini(void);
 
 void		dmu_zfetch_init(zfetch_t *, struct dnode *);
 void		dmu_zfetch_fini(zfetch_t *);
+void		dmu_zfetch_set_hint(zfetch_t *, dmu_prefetch_hint_t);
 zstream_t	*dmu_zfetch_prepare(zfetch_t *, uint64_t, uint64_t, boolean_t,
     boolean_t);
 void		dmu_zfetch_run(zstream_t *, boolean_t, boolean_t);
@@ -403,6 +403,23 @@ typedef struct dnode_children {
 	dnode_handle_t dnc_children[];	/* sized dynamically */
 } dnode_children_t;
 
+/*
+ * Each objset caches a small, direct-mapped table of dnodes recently held
+ * by dnode_hold(), indexed by object number.  Every cached dnode carries a
+ * hold of the cache, so it cannot move or be evicted, and a hit only needs
+ * the entry's striped lock to add another hold.  Misses fall back to the
+ * meta dnode dbuf and dnode_children_t.  Entries are dropped when their
+ * object is freed, and all of them when the objset's dbufs are evicted or
+ * the ARC asks its prune callbacks to release metadata.
+ */
+#define	DNODE_HOLD_CACHE_LOCKS	64
+typedef struct dnode_hold_cache {
+	uint64_t	dhc_mask;	/* entries - 1, dhc_dnodes NULL if 0 */
+	dnode_t		**dhc_dnodes;
+	struct arc_prune *dhc_prune;	/* releases entries under pressure */
+	kmutex_t	dhc_locks[DNODE_HOLD_CACHE_LOCKS];
+} dnode_hold_cache_t;
+
 typedef struct free_range {
 	avl_node_t fr_node;
 	uint64_t fr_blkid;
@@ -412,6 +429,9 @@ typedef struct free_range {
 void dnode_special_open(struct objset *dd, dnode_phys_t *dnp,
     uint64_t object, dnode_handle_t *dnh);
 void dnode_special_close(dnode_handle_t *dnh);
+void dnode_hold_cache_init(dnode_hold_cache_t *dhc);
+void dnode_hold_cache_fini(dnode_hold_cache_t *dhc);
+void dnode_hold_cache_purge(dnode_hold_cache_t *dhc);
 
 void dnode_setbonuslen(dnode_t *dn, int newsize, dmu_tx_t *tx);
 void dnode_setbonus_type(dnode_t *dn, dmu_object_type_t, dmu_tx_t *tx);
@@ -458,11 +478,17 @@ void dnode_free_interior_slots(dnode_t *dn);
 #define	DNODE_IS_CACHEABLE(_dn)						\
 	((_dn)->dn_objset->os_primary_cache == ZFS_CACHE_ALL ||		\
 	(DMU_OT_IS_METADATA((_dn)->dn_type) &&				\
-	(_dn)->dn_objset->os_primary_cache == ZFS_CACHE_METADATA))
+	((_dn)->dn_objset->os_primary_cache == ZFS_CACHE_METADATA ||	\
+	(_dn)->dn_objset->os_primary_cache == ZFS_CACHE_UNCACHED)))
+
+#define	DNODE_IS_UNCACHED(_dn)						\
+	((_dn)->dn_objset->os_primary_cache == ZFS_CACHE_UNCACHED &&	\
+	!DMU_OT_IS_METADATA((_dn)->dn_type))
 
 #define	DNODE_META_IS_CACHEABLE(_dn)					\
 	((_dn)->dn_objset->os_primary_cache == ZFS_CACHE_ALL ||		\
-	(_dn)->dn_objset->os_primary_cache == ZFS_CACHE_METADATA)
+	(_dn)->dn_objset->os_primary_cache == ZFS_CACHE_METADATA ||	\
+	(_dn)->dn_objset->os_primary_cache == ZFS_CACHE_UNCACHED)
 
 /*
  * Used for dnodestats kstat.
@@ -542,6 +568,25 @@ typedef struct dnode_stats {
 	 * a range of dnode slots which would overflow the dnode_phys_t.
 	 */
 	kstat_named_t dnode_hold_free_overflow;
+	/*
+	 * Number of times dnode_hold(..., DNODE_MUST_BE_ALLOCATED) found
+	 * the requested dnode in the objset's dnode hold cache.
+	 */
+	kstat_named_t dnode_hold_cache_hits;
+	/*
+	 * Number of times dnode_hold(..., DNODE_MUST_BE_ALLOCATED) did not
+	 * find the requested dnode in the objset's dnode hold cache.
+	 */
+	kstat_named_t dnode_hold_cache_misses;
+	/*
+	 * Number of dnode hold cache entries replaced by another dnode.
+	 */
+	kstat_named_t dnode_hold_cache_replaced;
+	/*
+	 * Number of dnode hold cache entries dropped because their object
+	 * was freed, the objset's dbufs were evicted or the ARC was pruned.
+	 */
+	kstat_named_t dnode_hold_cache_dropped;
 	/*
 	 * Number of times dnode_free_interior_slots() needed to retry
 	 * acquiring a slot zrl lock due to contention.
@@ -186,6 +186,11 @@ typedef enum {
 	ZFS_PROP_IVSET_GUID,		/* not exposed to the user */
 	ZFS_PROP_REDACTED,
 	ZFS_PROP_REDACT_SNAPS,
+	ZFS_PROP_ARC_QUOTA,
+	ZFS_PROP_ARC_RESERVATION,
+	ZFS_PROP_L2ARC_ADMIT,
+	ZFS_PROP_PREFETCH_DISTANCE,
+	ZFS_PROP_DIRECT,
 	ZFS_NUM_PROPS
 } zfs_prop_t;
 
@@ -396,9 +401,22 @@ typedef enum zfs_smb_acl_op {
 typedef enum zfs_cache_type {
 	ZFS_CACHE_NONE = 0,
 	ZFS_CACHE_METADATA = 1,
-	ZFS_CACHE_ALL = 2
+	ZFS_CACHE_ALL = 2,
+	ZFS_CACHE_UNCACHED = 3
 } zfs_cache_type_t;
 
+typedef enum zfs_l2arc_admit {
+	ZFS_L2ARC_ADMIT_ALL = 0,
+	ZFS_L2ARC_ADMIT_MFU = 1,
+	ZFS_L2ARC_ADMIT_REREAD = 2
+} zfs_l2arc_admit_t;
+
+typedef enum zfs_direct {
+	ZFS_DIRECT_DISABLED = 0,
+	ZFS_DIRECT_STANDARD = 1,
+	ZFS_DIRECT_ALWAYS = 2
+} zfs_direct_t;
+
 typedef enum {
 	ZFS_SYNC_STANDARD = 0,
 	ZFS_SYNC_ALWAYS = 1,
@@ -678,6 +696,18 @@ typedef struct zpool_load_policy {
 /* Number of slow IOs */
 #define	ZPOOL_CONFIG_VDEV_SLOW_IOS		"vdev_slow_ios"
 
+/* Number of cache flushes issued and skipped */
+#define	ZPOOL_CONFIG_VDEV_FLUSH_ISSUED		"vdev_flush_issued"
+#define	ZPOOL_CONFIG_VDEV_FLUSH_SKIPPED		"vdev_flush_skipped"
+
+/* ZIL commit latency histograms by phase, on the root vdev only */
+#define	ZPOOL_CONFIG_ZIL_QUEUE_LAT_HISTO	"zil_queue_lat_histo"
+#define	ZPOOL_CONFIG_ZIL_BUILD_LAT_HISTO	"zil_build_lat_histo"
+#define	ZPOOL_CONFIG_ZIL_ISSUE_LAT_HISTO	"zil_issue_lat_histo"
+#define	ZPOOL_CONFIG_ZIL_DEVICE_LAT_HISTO	"zil_device_lat_histo"
+#define	ZPOOL_CONFIG_ZIL_FLUSH_LAT_HISTO	"zil_flush_lat_histo"
+#define	ZPOOL_CONFIG_ZIL_WAKEUP_LAT_HISTO	"zil_wakeup_lat_histo"
+
 /* vdev enclosure sysfs path */
 #define	ZPOOL_CONFIG_VDEV_ENC_SYSFS_PATH	"vdev_enc_sysfs_path"
 
@@ -1159,6 +1189,10 @@ typedef struct vdev_stat_ex {
 	uint64_t vsx_agg_histo[ZIO_PRIORITY_NUM_QUEUEABLE]
 	    [VDEV_RQ_HISTO_BUCKETS];
 
+	/* Cache flushes issued, and skipped for lack of a write cache */
+	uint64_t vsx_flush_issued;
+	uint64_t vsx_flush_skipped;
+
 } vdev_stat_ex_t;
 
 /*
@@ -920,6 +920,7 @@ typedef struct spa_stats {
 	spa_history_list_t	mmp_history;
 	spa_history_kstat_t	state;		/* pool state */
 	spa_history_kstat_t	iostats;
+	spa_history_kstat_t	zil_commit_histogram;
 } spa_stats_t;
 
 typedef enum txg_state {
@@ -958,6 +959,8 @@ typedef struct spa_iostats {
 	kstat_named_t	simple_trim_bytes_skipped;
 	kstat_named_t	simple_trim_extents_failed;
 	kstat_named_t	simple_trim_bytes_failed;
+	kstat_named_t	flush_issued;
+	kstat_named_t	flush_skipped;
 } spa_iostats_t;
 
 extern void spa_stats_init(spa_t *spa);
@@ -971,6 +974,8 @@ extern txg_stat_t *spa_txg_history_init_io(spa_t *, uint64_t,
     struct dsl_pool *);
 extern void spa_txg_history_fini_io(spa_t *, txg_stat_t *);
 extern void spa_tx_assign_add_nsecs(spa_t *spa, uint64_t nsecs);
+extern void spa_zil_commit_add_nsecs(spa_t *spa, const hrtime_t *nsecs);
+extern uint64_t *spa_zil_commit_histo(spa_t *spa, int phase);
 extern int spa_mmp_history_set_skip(spa_t *spa, uint64_t mmp_kstat_id);
 extern int spa_mmp_history_set(spa_t *spa, uint64_t mmp_kstat_id, int io_error,
     hrtime_t duration);
@@ -981,6 +986,7 @@ extern void spa_iostats_trim_add(spa_t *spa, trim_type_t type,
     uint64_t extents_written, uint64_t bytes_written,
     uint64_t extents_skipped, uint64_t bytes_skipped,
     uint64_t extents_failed, uint64_t bytes_failed);
+extern void spa_iostats_flush_add(spa_t *spa, boolean_t issued);
 extern void spa_import_progress_add(spa_t *spa);
 extern void spa_import_progress_remove(uint64_t spa_guid);
 extern int spa_import_progress_set_mmp_check(uint64_t pool_guid,
@@ -120,6 +120,7 @@ extern metaslab_group_t *vdev_get_mg(vdev_t *vd, metaslab_class_t *mc);
 extern void vdev_get_stats(vdev_t *vd, vdev_stat_t *vs);
 extern void vdev_clear_stats(vdev_t *vd);
 extern void vdev_stat_update(zio_t *zio, uint64_t psize);
+extern void vdev_stat_flush(vdev_t *vd, boolean_t issued);
 extern void vdev_scan_stat_init(vdev_t *vd);
 extern void vdev_propagate_state(vdev_t *vd);
 extern void vdev_set_state(vdev_t *vd, boolean_t isopen, vdev_state_t state,
@@ -74,6 +74,7 @@ int64_t zfs_refcount_add(zfs_refcount_t *, const void *);
 int64_t zfs_refcount_remove(zfs_refcount_t *, const void *);
 int64_t zfs_refcount_add_many(zfs_refcount_t *, uint64_t, const void *);
 int64_t zfs_refcount_remove_many(zfs_refcount_t *, uint64_t, const void *);
+boolean_t zfs_refcount_add_if_nonzero(zfs_refcount_t *, const void *);
 void zfs_refcount_transfer(zfs_refcount_t *, zfs_refcount_t *);
 void zfs_refcount_transfer_ownership(zfs_refcount_t *, const void *,
     const void *);
@@ -114,6 +115,21 @@ typedef struct refcount {
 #define	zfs_refcount_held(rc, holder)			((rc)->rc_count > 0)
 #define	zfs_refcount_not_held(rc, holder)		(B_TRUE)
 
+static inline boolean_t
+zfs_refcount_add_if_nonzero(zfs_refcount_t *rc, const void *holder)
+{
+	uint64_t count;
+
+	(void) holder;
+	do {
+		count = rc->rc_count;
+		if (count == 0)
+			return (B_FALSE);
+	} while (atomic_cas_64(&rc->rc_count, count, count + 1) != count);
+
+	return (B_TRUE);
+}
+
 #define	zfs_refcount_init()
 #define	zfs_refcount_fini()
 
@@ -100,7 +100,7 @@ typedef struct zil_chain {
  * ziltest is by and large an ugly hack, but very useful in
  * checking replay without tedious work.
  * When running ziltest we want to keep all itx's and so maintain
- * a single list in the zl_itxg[] that uses a high txg: ZILTEST_TXG
+ * a single set of lists in the zl_itxg[] that uses a high txg: ZILTEST_TXG
  * We subtract TXG_CONCURRENT_STATES to allow for common code.
  */
 #define	ZILTEST_TXG (UINT64_MAX - TXG_CONCURRENT_STATES)
@@ -400,6 +400,7 @@ typedef struct itx {
 	size_t		itx_size;	/* allocated itx structure size */
 	uint64_t	itx_oid;	/* object id */
 	uint64_t	itx_gen;	/* gen number for zfs_get_data */
+	uint64_t	itx_seq;	/* order of zil_itx_assign() calls */
 	lr_t		itx_lr;		/* common part of log record */
 	/* followed by type-specific part of lr_xx_t and its immediate data */
 } itx_t;
@@ -458,6 +459,20 @@ typedef struct zil_stats {
 
 extern zil_stats_t zil_stats;
 
+/*
+ * The phases of a zil_commit(), in order, for the per-pool ZIL commit
+ * latency histograms (see spa_zil_commit_add_nsecs()).
+ */
+typedef enum zil_commit_phase {
+	ZIL_COMMIT_QUEUE,	/* assigning the commit itx, zl_issuer_lock */
+	ZIL_COMMIT_BUILD,	/* committing itxs to lwbs */
+	ZIL_COMMIT_ISSUE,	/* waiting for the lwb to be issued */
+	ZIL_COMMIT_DEVICE,	/* lwb write */
+	ZIL_COMMIT_FLUSH,	/* vdev write cache flushes */
+	ZIL_COMMIT_WAKEUP,	/* waking up the committing thread */
+	ZIL_COMMIT_PHASES
+} zil_commit_phase_t;
+
 #define	ZIL_STAT_INCR(stat, val) \
     atomic_add_64(&zil_stats.stat.value.ui64, (val));
 #define	ZIL_STAT_BUMP(stat) \
@@ -107,6 +107,7 @@ typedef struct lwb {
 	avl_tree_t	lwb_vdev_tree;	/* vdevs to flush after lwb write */
 	kmutex_t	lwb_vdev_lock;	/* protects lwb_vdev_tree */
 	hrtime_t	lwb_issued_timestamp; /* when was the lwb issued? */
+	hrtime_t	lwb_written_timestamp; /* when was the lwb written? */
 } lwb_t;
 
 /*
@@ -132,6 +133,8 @@ typedef struct zil_commit_waiter {
 	lwb_t		*zcw_lwb;	/* back pointer to lwb when linked */
 	boolean_t	zcw_done;	/* B_TRUE when "done", else B_FALSE */
 	int		zcw_zio_error;	/* contains the zio io_error value */
+	/* start of each zil_commit_phase_t, and when it was woken up */
+	hrtime_t	zcw_phase_ts[ZIL_COMMIT_PHASES + 1];
 } zil_commit_waiter_t;
 
 /*
@@ -140,13 +143,28 @@ typedef struct zil_commit_waiter {
 typedef struct itxs {
 	list_t		i_sync_list;	/* list of synchronous itxs */
 	avl_tree_t	i_async_tree;	/* tree of foids for async itxs */
+	struct itxs	*i_next;	/* zil_clean() chain of detached itxs */
 } itxs_t;
 
+/*
+ * Each txg has zl_itxg_count of these, and zil_itx_assign() picks one by
+ * CPU so that concurrent callers rarely contend on the same itxg_lock. The
+ * itxs on each list are kept in itx_seq order so that zil_get_commit_list()
+ * can merge them back into the order in which they were assigned.
+ *
+ * The itxg_has_sync and itxg_has_async hints are set under itxg_lock when
+ * an itx is added, and cleared under it once the list or tree is empty.
+ * zil_commit() reads them without the lock to skip the many itxgs which
+ * hold nothing, so an itx may be missed only while its zil_itx_assign()
+ * is still in progress.
+ */
 typedef struct itxg {
 	kmutex_t	itxg_lock;	/* lock for this structure */
 	uint64_t	itxg_txg;	/* txg for this chain */
 	itxs_t		*itxg_itxs;	/* sync and async itxs */
-} itxg_t;
+	boolean_t	itxg_has_sync;	/* i_sync_list may be non-empty */
+	boolean_t	itxg_has_async;	/* i_async_tree may be non-empty */
+} ____cacheline_aligned itxg_t;
 
 /* for async nodes we build up an AVL tree of lists of async itxs per file */
 typedef struct itx_async_node {
@@ -197,9 +215,12 @@ struct zilog {
 	uint64_t	zl_parse_lr_seq; /* highest lr seq on last parse */
 	uint64_t	zl_parse_blk_count; /* number of blocks parsed */
 	uint64_t	zl_parse_lr_count; /* number of log records parsed */
-	itxg_t		zl_itxg[TXG_SIZE]; /* intent log txg chains */
+	itxg_t		*zl_itxg[TXG_SIZE]; /* per-CPU intent log txg chains */
+	uint_t		zl_itxg_count;	/* number of itxgs per txg */
+	uint64_t	zl_itx_seq;	/* last itx_seq assigned */
 	list_t		zl_itx_commit_list; /* itx list to be committed */
 	uint64_t	zl_cur_used;	/* current commit log size used */
+	uint64_t	zl_committers;	/* threads in zil_commit_impl() */
 	list_t		zl_lwb_list;	/* in-flight log write list */
 	avl_tree_t	zl_bp_tree;	/* track bps during log parse */
 	clock_t		zl_replay_time;	/* lbolt of when replay started */
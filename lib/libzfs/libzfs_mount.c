@@ -82,6 +82,8 @@
 #include <sys/stat.h>
 #include <sys/vfs.h>
 #include <sys/dsl_crypt.h>
+#include <pthread.h>
+#include <time.h>
 
 #include <libzfs.h>
 
@@ -1274,8 +1276,39 @@ typedef struct mount_state {
 	int		ms_mntstatus;
 	int		ms_mntflags;
 	const char	*ms_mntopts;
+	/*
+	 * When ms_progress is set, the count of filesystems mounted so far
+	 * is printed as they are mounted; ms_lock protects the fields below.
+	 */
+	boolean_t	ms_progress;
+	pthread_mutex_t	ms_lock;
+	size_t		ms_done;
+	size_t		ms_total;
+	time_t		ms_reported;
 } mount_state_t;
 
+/*
+ * Reports mount progress in the form "(current/total)", at most once a
+ * second until the last filesystem is mounted.
+ */
+static void
+zfs_mount_progress(mount_state_t *ms)
+{
+	time_t now = time(NULL);
+
+	pthread_mutex_lock(&ms->ms_lock);
+	ms->ms_done++;
+	if (ms->ms_done == ms->ms_total || now > ms->ms_reported) {
+		(void) printf("\r%s: (%zu/%zu)%s",
+		    dgettext(TEXT_DOMAIN, "Mounting ZFS filesystems"),
+		    ms->ms_done, ms->ms_total,
+		    ms->ms_done == ms->ms_total ? "\n" : "");
+		(void) fflush(stdout);
+		ms->ms_reported = now;
+	}
+	pthread_mutex_unlock(&ms->ms_lock);
+}
+
 static int
 zfs_mount_one(zfs_handle_t *zhp, void *arg)
 {
@@ -1286,12 +1319,13 @@ zfs_mount_one(zfs_handle_t *zhp, void *arg)
 	 * don't attempt to mount encrypted datasets with
 	 * unloaded keys
 	 */
-	if (zfs_prop_get_int(zhp, ZFS_PROP_KEYSTATUS) ==
-	    ZFS_KEYSTATUS_UNAVAILABLE)
-		return (0);
-
-	if (zfs_mount(zhp, ms->ms_mntopts, ms->ms_mntflags) != 0)
+	if (zfs_prop_get_int(zhp, ZFS_PROP_KEYSTATUS) !=
+	    ZFS_KEYSTATUS_UNAVAILABLE &&
+	    zfs_mount(zhp, ms->ms_mntopts, ms->ms_mntflags) != 0)
 		ret = ms->ms_mntstatus = -1;
+
+	if (ms->ms_progress)
+		zfs_mount_progress(ms);
 	return (ret);
 }
 
@@ -1428,11 +1462,13 @@ zfs_foreach_mountpoint(libzfs_handle_t *hdl, zfs_handle_t **handles,
 
 /*
  * Mount and share all datasets within the given pool.  This assumes that no
- * datasets within the pool are currently mounted.
+ * datasets within the pool are currently mounted.  If 'progress' is set, the
+ * number of filesystems mounted is reported on stdout as they are mounted;
+ * this is where their intent logs are replayed, which can take some time.
  */
-#pragma weak zpool_mount_datasets = zpool_enable_datasets
 int
-zpool_enable_datasets(zpool_handle_t *zhp, const char *mntopts, int flags)
+zpool_enable_datasets_progress(zpool_handle_t *zhp, const char *mntopts,
+    int flags, boolean_t progress)
 {
 	get_all_cb_t cb = { 0 };
 	mount_state_t ms = { 0 };
@@ -1457,8 +1493,12 @@ zpool_enable_datasets(zpool_handle_t *zhp, const char *mntopts, int flags)
 	 */
 	ms.ms_mntopts = mntopts;
 	ms.ms_mntflags = flags;
+	ms.ms_progress = progress;
+	ms.ms_total = cb.cb_used;
+	(void) pthread_mutex_init(&ms.ms_lock, NULL);
 	zfs_foreach_mountpoint(zhp->zpool_hdl, cb.cb_handles, cb.cb_used,
 	    zfs_mount_one, &ms, B_TRUE);
+	(void) pthread_mutex_destroy(&ms.ms_lock);
 	if (ms.ms_mntstatus != 0)
 		ret = ms.ms_mntstatus;
 
@@ -1483,6 +1523,13 @@ out:
 	return (ret);
 }
 
+#pragma weak zpool_mount_datasets = zpool_enable_datasets
+int
+zpool_enable_datasets(zpool_handle_t *zhp, const char *mntopts, int flags)
+{
+	return (zpool_enable_datasets_progress(zhp, mntopts, flags, B_FALSE));
+}
+
 static int
 mountpoint_compare(const void *a, const void *b)
 {
@@ -99,6 +99,16 @@ zfs_uioskip(zfs_uio_t *uio, size_t n)
 	zfs_uio_segflg(uio) = segflg;
 }
 
+/*
+ * Pinning user pages into an ABD is not implemented on FreeBSD; callers
+ * fall back to copying the data.
+ */
+struct abd *
+zfs_uio_pin_abd(zfs_uio_t *uio, size_t n)
+{
+	return (NULL);
+}
+
 int
 zfs_uio_fault_move(void *p, size_t n, zfs_uio_rw_t dir, zfs_uio_t *uio)
 {
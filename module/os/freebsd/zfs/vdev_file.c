@@ -255,6 +255,7 @@ vdev_file_io_start(zio_t *zio)
 
 		switch (zio->io_cmd) {
 		case DKIOCFLUSHWRITECACHE:
+			vdev_stat_flush(vd, B_TRUE);
 			zio->io_error = zfs_file_fsync(vf->vf_file,
 			    O_SYNC|O_DSYNC);
 			break;
@@ -1085,6 +1085,7 @@ vdev_geom_io_start(zio_t *zio)
 					zio->io_error = SET_ERROR(ENOTSUP);
 					break;
 				}
+				vdev_stat_flush(vd, B_TRUE);
 				goto sendreq;
 			default:
 				zio->io_error = SET_ERROR(ENOTSUP);
@@ -424,6 +424,14 @@ abd_free_chunks(abd_t *abd)
 	int nr_pages = ABD_SCATTER(abd).abd_nents;
 	int order, i = 0;
 
+	if (abd->abd_flags & ABD_FLAG_FROM_PAGES) {
+		abd_for_each_sg(abd, sg, nr_pages, i) {
+			put_page(sg_page(sg));
+		}
+		abd_free_sg_table(abd);
+		return;
+	}
+
 	if (abd->abd_flags & ABD_FLAG_MULTI_ZONE)
 		ABDSTAT_BUMPDOWN(abdstat_scatter_page_multi_zone);
 
@@ -625,6 +633,11 @@ void
 abd_update_scatter_stats(abd_t *abd, abd_stats_op_t op)
 {
 	ASSERT(op == ABDSTAT_INCR || op == ABDSTAT_DECR);
+
+	/* Pages pinned by abd_alloc_from_pages() are not ours to account. */
+	if (abd->abd_flags & ABD_FLAG_FROM_PAGES)
+		return;
+
 	int waste = P2ROUNDUP(abd->abd_size, PAGESIZE) - abd->abd_size;
 	if (op == ABDSTAT_INCR) {
 		ABDSTAT_BUMP(abdstat_scatter_cnt);
@@ -1057,6 +1070,45 @@ abd_bio_map_off(struct bio *bio, abd_t *abd,
 	return (io_size);
 }
 
+/*
+ * Build a scatter ABD of @size bytes over pages which the caller has pinned,
+ * starting @offset bytes into the first page.  The ABD takes over the page
+ * references and drops them when it is freed with abd_free().
+ */
+abd_t *
+abd_alloc_from_pages(struct page **pages, unsigned long offset, uint64_t size)
+{
+	struct scatterlist *sg = NULL;
+	struct sg_table table;
+	gfp_t gfp = __GFP_NOWARN | GFP_NOIO;
+	int nr_pages = DIV_ROUND_UP(offset + size, PAGESIZE);
+	int i = 0;
+
+	ASSERT3U(offset, <, PAGESIZE);
+	VERIFY3U(size, <=, SPA_MAXBLOCKSIZE);
+
+	while (sg_alloc_table(&table, nr_pages, gfp)) {
+		ABDSTAT_BUMP(abdstat_scatter_sg_table_retry);
+		schedule_timeout_interruptible(1);
+	}
+	ASSERT3U(table.nents, ==, nr_pages);
+
+	abd_t *abd = abd_alloc_struct(size);
+	abd->abd_flags |= ABD_FLAG_OWNER | ABD_FLAG_FROM_PAGES;
+	abd->abd_size = size;
+	ABD_SCATTER(abd).abd_offset = offset;
+	ABD_SCATTER(abd).abd_sgl = table.sgl;
+	ABD_SCATTER(abd).abd_nents = nr_pages;
+	if (nr_pages > 1)
+		abd->abd_flags |= ABD_FLAG_MULTI_CHUNK;
+
+	abd_for_each_sg(abd, sg, nr_pages, i) {
+		sg_set_page(sg, pages[i], PAGESIZE, 0);
+	}
+
+	return (abd);
+}
+
 /* Tunable Parameters */
 module_param(zfs_abd_scatter_enabled, int, 0644);
 MODULE_PARM_DESC(zfs_abd_scatter_enabled,
@@ -736,8 +736,20 @@ vdev_disk_io_start(zio_t *zio)
 				break;
 			}
 
+			/*
+			 * The write cache can be switched on and off through
+			 * /sys/block/<dev>/queue/write_cache at any time, so
+			 * check the queue on every flush rather than at open.
+			 */
+			if (!blk_queue_has_write_cache(
+			    bdev_get_queue(vd->vd_bdev))) {
+				vdev_stat_flush(v, B_FALSE);
+				break;
+			}
+
 			error = vdev_disk_io_flush(vd->vd_bdev, zio);
 			if (error == 0) {
+				vdev_stat_flush(v, B_TRUE);
 				rw_exit(&vd->vd_lock);
 				return;
 			}
@@ -256,6 +256,8 @@ vdev_file_io_start(zio_t *zio)
 			if (zfs_nocacheflush)
 				break;
 
+			vdev_stat_flush(vd, B_TRUE);
+
 			/*
 			 * We cannot safely call vfs_fsync() when PF_FSTRANS
 			 * is set in the current context.  Filesystems like
@@ -45,6 +45,7 @@
 #include <sys/uio_impl.h>
 #include <sys/sysmacros.h>
 #include <sys/strings.h>
+#include <sys/abd.h>
 #include <linux/kmap_compat.h>
 #include <linux/uaccess.h>
 
@@ -327,4 +328,68 @@ zfs_uioskip(zfs_uio_t *uio, size_t n)
 }
 EXPORT_SYMBOL(zfs_uioskip);
 
+/*
+ * Pin the user pages backing the next n bytes of the uio and return a
+ * scatter ABD built directly over them, or NULL if they can not all be
+ * pinned from a single user buffer.  The uio is not advanced.  The pages
+ * stay pinned until the caller frees the ABD with abd_free().
+ */
+struct abd *
+zfs_uio_pin_abd(zfs_uio_t *uio, size_t n)
+{
+	struct page **pages;
+	unsigned long offset;
+	int max_pages, nr_pages, pinned = 0;
+	struct abd *abd = NULL;
+
+	if (n == 0 || n > uio->uio_resid)
+		return (NULL);
+
+	if (uio->uio_segflg == UIO_USERSPACE) {
+		const struct iovec *iov = uio->uio_iov;
+		unsigned long addr;
+
+		if (iov->iov_len - uio->uio_skip < n)
+			return (NULL);
+
+		addr = (unsigned long)iov->iov_base + uio->uio_skip;
+		offset = offset_in_page(addr);
+		nr_pages = max_pages = DIV_ROUND_UP(offset + n, PAGESIZE);
+		pages = kmem_alloc(max_pages * sizeof (struct page *),
+		    KM_SLEEP);
+		pinned = get_user_pages_fast(addr & PAGE_MASK, nr_pages, 0,
+		    pages);
+#if defined(HAVE_VFS_IOV_ITER) && defined(HAVE_IOV_ITER_GET_PAGES)
+	} else if (uio->uio_segflg == UIO_ITER && uio->uio_skip == 0 &&
+	    iter_is_iovec(uio->uio_iter)) {
+		size_t start = 0;
+		ssize_t bytes;
+
+		max_pages = DIV_ROUND_UP(n, PAGESIZE) + 1;
+		pages = kmem_alloc(max_pages * sizeof (struct page *),
+		    KM_SLEEP);
+		bytes = iov_iter_get_pages(uio->uio_iter, pages, n, max_pages,
+		    &start);
+		offset = start;
+		if (bytes > 0)
+			pinned = DIV_ROUND_UP(start + bytes, PAGESIZE);
+		/* A short pin is released below. */
+		nr_pages = (bytes == n) ? pinned : -1;
+#endif
+	} else {
+		return (NULL);
+	}
+
+	if (pinned == nr_pages)
+		abd = abd_alloc_from_pages(pages, offset, n);
+
+	for (int i = 0; abd == NULL && i < pinned; i++)
+		put_page(pages[i]);
+
+	kmem_free(pages, max_pages * sizeof (struct page *));
+
+	return (abd);
+}
+EXPORT_SYMBOL(zfs_uio_pin_abd);
+
 #endif /* _KERNEL */
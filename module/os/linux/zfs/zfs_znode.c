@@ -678,6 +678,7 @@ zfs_mknode(znode_t *dzp, vattr_t *vap, dmu_tx_t *tx, cred_t *cr,
 	int		cnt = 0;
 	zfs_acl_locator_cb_t locate = { 0 };
 	znode_hold_t	*zh;
+	dnode_t		*dn = NULL;
 
 	if (zfsvfs->z_replay) {
 		obj = vap->va_nodeid;
@@ -724,14 +725,24 @@ zfs_mknode(znode_t *dzp, vattr_t *vap, dmu_tx_t *tx, cred_t *cr,
 			    DMU_OT_PLAIN_FILE_CONTENTS, 0,
 			    obj_type, bonuslen, dnodesize, tx));
 		} else {
-			obj = dmu_object_alloc_dnsize(zfsvfs->z_os,
-			    DMU_OT_PLAIN_FILE_CONTENTS, 0,
-			    obj_type, bonuslen, dnodesize, tx);
+			obj = dmu_object_alloc_hold(zfsvfs->z_os,
+			    DMU_OT_PLAIN_FILE_CONTENTS, 0, 0,
+			    obj_type, bonuslen, dnodesize, &dn, FTAG, tx);
 		}
 	}
 
 	zh = zfs_znode_hold_enter(zfsvfs, obj);
-	VERIFY0(sa_buf_hold(zfsvfs->z_os, obj, NULL, &db));
+	if (dn != NULL) {
+		/*
+		 * Hold the bonus buffer through the dnode returned by the
+		 * allocator rather than looking the new object up again.
+		 */
+		VERIFY0(dmu_bonus_hold_by_dnode(dn, NULL, &db,
+		    DMU_READ_NO_PREFETCH));
+		dnode_rele(dn, FTAG);
+	} else {
+		VERIFY0(sa_buf_hold(zfsvfs->z_os, obj, NULL, &db));
+	}
 
 	/*
 	 * If this is the root, fix up the half-initialized parent pointer
@@ -27,6 +27,9 @@
 #ifdef CONFIG_COMPAT
 #include <linux/compat.h>
 #endif
+#ifdef HAVE_FILE_FADVISE
+#include <linux/fadvise.h>
+#endif
 #include <sys/file.h>
 #include <sys/dmu_objset.h>
 #include <sys/zfs_znode.h>
@@ -51,6 +54,14 @@ zpl_open(struct inode *ip, struct file *filp)
 	if (error)
 		return (error);
 
+#if defined(IOCB_NOWAIT) && defined(FMODE_NOWAIT)
+	/*
+	 * Accept RWF_NOWAIT reads; see zpl_iter_read().  NOWAIT writes are
+	 * still refused by zpl_iter_write().
+	 */
+	filp->f_mode |= FMODE_NOWAIT;
+#endif
+
 	crhold(cr);
 	cookie = spl_fstrans_mark();
 	error = -zfs_open(ip, filp->f_mode, filp->f_flags, cr);
@@ -268,7 +279,20 @@ zpl_iter_read(struct kiocb *kiocb, struct iov_iter *to)
 	crhold(cr);
 	cookie = spl_fstrans_mark();
 
-	int error = -zfs_read(ITOZ(filp->f_mapping->host), &uio,
+	int error;
+#if defined(IOCB_NOWAIT)
+	/*
+	 * Serve IOCB_NOWAIT reads (io_uring, RWF_NOWAIT) from cache only.
+	 * Uncached blocks are prefetched and -EAGAIN is returned,
+	 * so the caller retries from a context which may block instead of
+	 * tying up its submitting thread for the I/O.
+	 */
+	if (kiocb->ki_flags & IOCB_NOWAIT) {
+		error = -zfs_read_nowait(ITOZ(filp->f_mapping->host), &uio,
+		    filp->f_flags | zfs_io_flags(kiocb), cr);
+	} else
+#endif
+	error = -zfs_read(ITOZ(filp->f_mapping->host), &uio,
 	    filp->f_flags | zfs_io_flags(kiocb), cr);
 
 	spl_fstrans_unmark(cookie);
@@ -321,6 +345,16 @@ zpl_iter_write(struct kiocb *kiocb, struct iov_iter *from)
 	size_t count = 0;
 	ssize_t ret;
 
+#if defined(IOCB_NOWAIT)
+	/*
+	 * Writes may always block.  Fail NOWAIT writes as they were before
+	 * FMODE_NOWAIT was set for reads, so that callers fall back rather
+	 * than retrying forever; io_uring turns this into a blocking retry.
+	 */
+	if (kiocb->ki_flags & IOCB_NOWAIT)
+		return (-EOPNOTSUPP);
+#endif
+
 	ret = zpl_generic_write_checks(kiocb, from, &count);
 	if (ret)
 		return (ret);
@@ -800,6 +834,74 @@ zpl_fallocate(struct file *filp, int mode, loff_t offset, loff_t len)
 	    mode, offset, len);
 }
 
+#ifdef HAVE_FILE_FADVISE
+/*
+ * WILLNEED and SEQUENTIAL prefetch the given range through dmu_prefetch(),
+ * which caps it at dmu_prefetch_max.  RANDOM, SEQUENTIAL and NORMAL are
+ * passed to the predictive prefetcher of the object, so that RANDOM turns
+ * it off and SEQUENTIAL makes it prefetch as far ahead as it may.  The
+ * generic handler still runs to keep the page cache state of mapped files
+ * in step, which is also how madvise(MADV_WILLNEED) on a mapping gets here.
+ */
+static int
+zpl_fadvise(struct file *filp, loff_t offset, loff_t len, int advice)
+{
+	struct inode *ip = file_inode(filp);
+	znode_t *zp = ITOZ(ip);
+	zfsvfs_t *zfsvfs = ITOZSB(ip);
+	loff_t pf_len;
+	int error = 0;
+
+	if (S_ISFIFO(ip->i_mode))
+		return (-ESPIPE);
+
+	if (offset < 0 || len < 0)
+		return (-EINVAL);
+
+	ZPL_ENTER(zfsvfs);
+	ZPL_VERIFY_ZP(zp);
+
+	switch (advice) {
+	case POSIX_FADV_SEQUENTIAL:
+	case POSIX_FADV_WILLNEED:
+		if (advice == POSIX_FADV_SEQUENTIAL) {
+			dmu_prefetch_hint(sa_get_db(zp->z_sa_hdl),
+			    DMU_PREFETCH_SEQUENTIAL);
+		}
+		/* A zero length runs to the end of the file. */
+		pf_len = (len == 0) ? i_size_read(ip) - offset : len;
+		if (pf_len > 0) {
+			dmu_prefetch(zfsvfs->z_os, zp->z_id, 0, offset, pf_len,
+			    ZIO_PRIORITY_ASYNC_READ);
+		}
+		break;
+	case POSIX_FADV_RANDOM:
+		dmu_prefetch_hint(sa_get_db(zp->z_sa_hdl),
+		    DMU_PREFETCH_RANDOM);
+		break;
+	case POSIX_FADV_NORMAL:
+		dmu_prefetch_hint(sa_get_db(zp->z_sa_hdl),
+		    DMU_PREFETCH_NORMAL);
+		break;
+	case POSIX_FADV_DONTNEED:
+	case POSIX_FADV_NOREUSE:
+		break;
+	default:
+		error = -EINVAL;
+		break;
+	}
+
+	ZPL_EXIT(zfsvfs);
+
+#ifdef HAVE_GENERIC_FADVISE
+	if (error == 0)
+		error = generic_fadvise(filp, offset, len, advice);
+#endif
+
+	return (error);
+}
+#endif /* HAVE_FILE_FADVISE */
+
 #define	ZFS_FL_USER_VISIBLE	(FS_FL_USER_VISIBLE | ZFS_PROJINHERIT_FL)
 #define	ZFS_FL_USER_MODIFIABLE	(FS_FL_USER_MODIFIABLE | ZFS_PROJINHERIT_FL)
 
@@ -1039,6 +1141,9 @@ const struct file_operations zpl_file_operations = {
 	.aio_fsync	= zpl_aio_fsync,
 #endif
 	.fallocate	= zpl_fallocate,
+#ifdef HAVE_FILE_FADVISE
+	.fadvise	= zpl_fadvise,
+#endif
 	.unlocked_ioctl	= zpl_ioctl,
 #ifdef CONFIG_COMPAT
 	.compat_ioctl	= zpl_compat_ioctl,
@@ -342,6 +342,28 @@ zfs_prop_init(void)
 		{ NULL }
 	};
 
+	static zprop_index_t primary_cache_table[] = {
+		{ "none",	ZFS_CACHE_NONE },
+		{ "metadata",	ZFS_CACHE_METADATA },
+		{ "all",	ZFS_CACHE_ALL },
+		{ "uncached",	ZFS_CACHE_UNCACHED },
+		{ NULL }
+	};
+
+	static zprop_index_t l2arc_admit_table[] = {
+		{ "all",	ZFS_L2ARC_ADMIT_ALL },
+		{ "mfu",	ZFS_L2ARC_ADMIT_MFU },
+		{ "reread",	ZFS_L2ARC_ADMIT_REREAD },
+		{ NULL }
+	};
+
+	static zprop_index_t direct_table[] = {
+		{ "disabled",	ZFS_DIRECT_DISABLED },
+		{ "standard",	ZFS_DIRECT_STANDARD },
+		{ "always",	ZFS_DIRECT_ALWAYS },
+		{ NULL }
+	};
+
 	static zprop_index_t sync_table[] = {
 		{ "standard",	ZFS_SYNC_STANDARD },
 		{ "always",	ZFS_SYNC_ALWAYS },
@@ -448,11 +470,19 @@ zfs_prop_init(void)
 	zprop_register_index(ZFS_PROP_PRIMARYCACHE, "primarycache",
 	    ZFS_CACHE_ALL, PROP_INHERIT,
 	    ZFS_TYPE_FILESYSTEM | ZFS_TYPE_SNAPSHOT | ZFS_TYPE_VOLUME,
-	    "all | none | metadata", "PRIMARYCACHE", cache_table);
+	    "all | none | metadata | uncached", "PRIMARYCACHE",
+	    primary_cache_table);
 	zprop_register_index(ZFS_PROP_SECONDARYCACHE, "secondarycache",
 	    ZFS_CACHE_ALL, PROP_INHERIT,
 	    ZFS_TYPE_FILESYSTEM | ZFS_TYPE_SNAPSHOT | ZFS_TYPE_VOLUME,
 	    "all | none | metadata", "SECONDARYCACHE", cache_table);
+	zprop_register_index(ZFS_PROP_L2ARC_ADMIT, "l2arc_admit",
+	    ZFS_L2ARC_ADMIT_ALL, PROP_INHERIT,
+	    ZFS_TYPE_FILESYSTEM | ZFS_TYPE_VOLUME,
+	    "all | mfu | reread", "L2ADMIT", l2arc_admit_table);
+	zprop_register_index(ZFS_PROP_DIRECT, "direct", ZFS_DIRECT_STANDARD,
+	    PROP_INHERIT, ZFS_TYPE_FILESYSTEM | ZFS_TYPE_SNAPSHOT,
+	    "disabled | standard | always", "DIRECT", direct_table);
 	zprop_register_index(ZFS_PROP_LOGBIAS, "logbias", ZFS_LOGBIAS_LATENCY,
 	    PROP_INHERIT, ZFS_TYPE_FILESYSTEM | ZFS_TYPE_VOLUME,
 	    "latency | throughput", "LOGBIAS", logbias_table);
@@ -671,6 +701,15 @@ zfs_prop_init(void)
 	zprop_register_number(ZFS_PROP_SPECIAL_SMALL_BLOCKS,
 	    "special_small_blocks", 0, PROP_INHERIT, ZFS_TYPE_FILESYSTEM,
 	    "zero or 512 to 1M, power of 2", "SPECIAL_SMALL_BLOCKS");
+	zprop_register_number(ZFS_PROP_ARC_QUOTA, "arc_quota", 0,
+	    PROP_INHERIT, ZFS_TYPE_FILESYSTEM | ZFS_TYPE_VOLUME,
+	    "<size> | none", "ARCQUOTA");
+	zprop_register_number(ZFS_PROP_ARC_RESERVATION, "arc_reservation", 0,
+	    PROP_INHERIT, ZFS_TYPE_FILESYSTEM | ZFS_TYPE_VOLUME,
+	    "<size> | none", "ARCRESERV");
+	zprop_register_number(ZFS_PROP_PREFETCH_DISTANCE, "prefetch_distance",
+	    0, PROP_INHERIT, ZFS_TYPE_FILESYSTEM | ZFS_TYPE_VOLUME,
+	    "<size> | none", "PFDIST");
 
 	/* hidden properties */
 	zprop_register_hidden(ZFS_PROP_NUMCLONES, "numclones", PROP_TYPE_NUMBER,
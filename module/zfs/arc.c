@@ -362,6 +362,55 @@ int zfs_arc_eviction_pct = 200;
  */
 int zfs_arc_evict_batch_limit = 10;
 
+/*
+ * When set, the ARC consults a compact access-frequency sketch (see the
+ * "Access-frequency filter" comment below) so that blocks which are read
+ * only once, such as those streamed by a backup, cannot displace the
+ * frequently used working set.
+ */
+int zfs_arc_lfu_enabled = 0;
+
+/*
+ * The estimated number of distinct accesses a buffer needs before the
+ * access-frequency filter allows it to be promoted to the MFU state.
+ * Buffers at or above this estimate are also passed over by eviction in
+ * favor of less frequently used buffers.
+ */
+uint_t zfs_arc_lfu_admit_freq = 2;
+
+/*
+ * When set, hits on buffers held by the dbuf layer whose header is already
+ * in the MFU state are accounted without taking the buffer hash lock.
+ */
+int zfs_arc_lockless_access = 1;
+
+/*
+ * Number of threads used to evict from the multilist sublists of an ARC
+ * state in parallel.  The default of 0 sizes the pool from the number of
+ * CPUs, and 1 leaves all eviction to the single arc_evict thread.
+ */
+int zfs_arc_evict_threads = 0;
+
+/*
+ * Eviction requests are only split between the eviction threads when each
+ * thread would be asked for at least this many bytes, two maximum-sized
+ * blocks.  The threads also evict in batches of this many bytes, instead
+ * of zfs_arc_evict_batch_limit headers, before dropping the sublist lock.
+ */
+#define	ARC_EVICT_TASK_MIN	(2 * SPA_MAXBLOCKSIZE)
+
+/*
+ * Once a cached compressed buffer has been decompressed this many times to
+ * serve reads, an uncompressed copy of it is kept so that later reads copy
+ * the data instead of decompressing it again.  0 disables the copies.
+ */
+int zfs_arc_ucache_hits = 3;
+
+/*
+ * Limit on the size of the uncompressed copies, as a percentage of arc_c.
+ */
+int zfs_arc_ucache_percent = 5;
+
 /* number of seconds before growing cache again */
 int arc_grow_retry = 5;
 
@@ -558,6 +607,8 @@ arc_stats_t arc_stats = {
 	{ "l2_size",			KSTAT_DATA_UINT64 },
 	{ "l2_asize",			KSTAT_DATA_UINT64 },
 	{ "l2_hdr_size",		KSTAT_DATA_UINT64 },
+	{ "l2_hdrs",			KSTAT_DATA_UINT64 },
+	{ "l2_hdr_bytes_per_mib",	KSTAT_DATA_UINT64 },
 	{ "l2_log_blk_writes",		KSTAT_DATA_UINT64 },
 	{ "l2_log_blk_avg_asize",	KSTAT_DATA_UINT64 },
 	{ "l2_log_blk_asize",		KSTAT_DATA_UINT64 },
@@ -574,6 +625,10 @@ arc_stats_t arc_stats = {
 	{ "l2_rebuild_bufs",		KSTAT_DATA_UINT64 },
 	{ "l2_rebuild_bufs_precached",	KSTAT_DATA_UINT64 },
 	{ "l2_rebuild_log_blks",	KSTAT_DATA_UINT64 },
+	{ "l2_rebuild_active",		KSTAT_DATA_UINT64 },
+	{ "l2_rebuild_time_ms",		KSTAT_DATA_UINT64 },
+	{ "l2_rebuild_rate",		KSTAT_DATA_UINT64 },
+	{ "l2_rebuild_eta_secs",	KSTAT_DATA_UINT64 },
 	{ "memory_throttle_count",	KSTAT_DATA_UINT64 },
 	{ "memory_direct_count",	KSTAT_DATA_UINT64 },
 	{ "memory_indirect_count",	KSTAT_DATA_UINT64 },
@@ -597,6 +652,38 @@ arc_stats_t arc_stats = {
 	{ "arc_raw_size",		KSTAT_DATA_UINT64 },
 	{ "cached_only_in_progress",	KSTAT_DATA_UINT64 },
 	{ "abd_chunk_waste_size",	KSTAT_DATA_UINT64 },
+	{ "lfu_hits",			KSTAT_DATA_UINT64 },
+	{ "lfu_misses",			KSTAT_DATA_UINT64 },
+	{ "lfu_admitted",		KSTAT_DATA_UINT64 },
+	{ "lfu_rejected",		KSTAT_DATA_UINT64 },
+	{ "lfu_evict_protected",	KSTAT_DATA_UINT64 },
+	{ "lfu_evict_onehit",		KSTAT_DATA_UINT64 },
+	{ "lfu_sketch_resets",		KSTAT_DATA_UINT64 },
+	{ "hash_locks",			KSTAT_DATA_UINT64 },
+	{ "hash_lock_contended",	KSTAT_DATA_UINT64 },
+	{ "hash_lock_wait_ns",		KSTAT_DATA_UINT64 },
+	{ "access_lockless",		KSTAT_DATA_UINT64 },
+	{ "dataset_evict_protected",	KSTAT_DATA_UINT64 },
+	{ "dataset_over_quota",		KSTAT_DATA_UINT64 },
+	{ "evict_threads",		KSTAT_DATA_UINT64 },
+	{ "evict_parallel_scans",	KSTAT_DATA_UINT64 },
+	{ "evict_parallel_tasks",	KSTAT_DATA_UINT64 },
+	{ "evict_parallel_bytes",	KSTAT_DATA_UINT64 },
+	{ "evict_parallel_time_ns",	KSTAT_DATA_UINT64 },
+	{ "decompress_bytes",		KSTAT_DATA_UINT64 },
+	{ "decompress_time_ns",		KSTAT_DATA_UINT64 },
+	{ "ucache_size",		KSTAT_DATA_UINT64 },
+	{ "ucache_hits",		KSTAT_DATA_UINT64 },
+	{ "ucache_evictions",		KSTAT_DATA_UINT64 },
+	{ "decompress_saved_bytes",	KSTAT_DATA_UINT64 },
+	{ "decompress_saved_ns",	KSTAT_DATA_UINT64 },
+	{ "l2_admit_all_write_bytes",	KSTAT_DATA_UINT64 },
+	{ "l2_admit_all_hits",		KSTAT_DATA_UINT64 },
+	{ "l2_admit_mfu_write_bytes",	KSTAT_DATA_UINT64 },
+	{ "l2_admit_mfu_hits",		KSTAT_DATA_UINT64 },
+	{ "l2_admit_reread_write_bytes", KSTAT_DATA_UINT64 },
+	{ "l2_admit_reread_hits",	KSTAT_DATA_UINT64 },
+	{ "l2_feed_size",		KSTAT_DATA_UINT64 },
 };
 
 #define	ARCSTAT_MAX(stat, val) {					\
@@ -609,6 +696,15 @@ arc_stats_t arc_stats = {
 #define	ARCSTAT_MAXSTAT(stat) \
 	ARCSTAT_MAX(stat##_max, arc_stats.stat.value.ui64)
 
+/*
+ * Only bump the access-frequency filter kstats while the filter is in use.
+ */
+#define	ARCSTAT_LFU_BUMP(stat) do {					\
+	if (zfs_arc_lfu_enabled)					\
+		ARCSTAT_BUMP(stat);					\
+	_NOTE(CONSTCOND)						\
+} while (0)
+
 /*
  * We define a macro to allow ARC hits/misses to be easily broken down by
  * two separate conditions, giving a total of four different subtypes for
@@ -706,10 +802,31 @@ list_t arc_prune_list;
 kmutex_t arc_prune_mtx;
 taskq_t *arc_prune_taskq;
 
+/* uncompressed copies of hot compressed buffers, most recent first */
+static kmutex_t arc_ucache_lock;
+static list_t arc_ucache_list;
+static uint64_t arc_ucache_size;
+
+/* number of eviction threads, and their taskq if there is more than one */
+static uint_t arc_evict_threads;
+static taskq_t *arc_evict_taskq;
+
+typedef struct arc_evict_arg {
+	taskq_ent_t	eva_tqent;
+	multilist_t	*eva_ml;
+	arc_buf_hdr_t	*eva_marker;
+	int		eva_idx;
+	uint64_t	eva_spa;
+	uint64_t	eva_bytes;
+	uint64_t	eva_evicted;
+} arc_evict_arg_t;
+
 #define	GHOST_STATE(state)	\
 	((state) == arc_mru_ghost || (state) == arc_mfu_ghost ||	\
 	(state) == arc_l2c_only)
 
+#define	ARC_CACHED_STATE(state)	((state) == arc_mru || (state) == arc_mfu)
+
 #define	HDR_IN_HASH_TABLE(hdr)	((hdr)->b_flags & ARC_FLAG_IN_HASH_TABLE)
 #define	HDR_IO_IN_PROGRESS(hdr)	((hdr)->b_flags & ARC_FLAG_IO_IN_PROGRESS)
 #define	HDR_IO_ERROR(hdr)	((hdr)->b_flags & ARC_FLAG_IO_ERROR)
@@ -779,18 +896,26 @@ struct ht_lock {
 #endif
 };
 
-#define	BUF_LOCKS 8192
+/*
+ * The hash table locks are striped over the table.  At least BUF_LOCKS
+ * locks are used, and more on systems with many CPUs so that concurrent
+ * lookups from every CPU rarely land on the same lock.
+ */
+#define	BUF_LOCKS		8192
+#define	BUF_LOCKS_PER_CPU	256
 typedef struct buf_hash_table {
 	uint64_t ht_mask;
 	arc_buf_hdr_t **ht_table;
-	struct ht_lock ht_locks[BUF_LOCKS];
+	uint64_t ht_lock_mask;
+	struct ht_lock *ht_locks;
 } buf_hash_table_t;
 
 static buf_hash_table_t buf_hash_table;
 
 #define	BUF_HASH_INDEX(spa, dva, birth) \
 	(buf_hash(spa, dva, birth) & buf_hash_table.ht_mask)
-#define	BUF_HASH_LOCK_NTRY(idx) (buf_hash_table.ht_locks[idx & (BUF_LOCKS-1)])
+#define	BUF_HASH_LOCK_NTRY(idx) \
+	(buf_hash_table.ht_locks[idx & buf_hash_table.ht_lock_mask])
 #define	BUF_HASH_LOCK(idx)	(&(BUF_HASH_LOCK_NTRY(idx).ht_lock))
 #define	HDR_LOCK(hdr) \
 	(BUF_HASH_LOCK(BUF_HASH_INDEX(hdr->b_spa, &hdr->b_dva, hdr->b_birth)))
@@ -840,6 +965,7 @@ static list_t L2ARC_dev_list;			/* device list */
 static list_t *l2arc_dev_list;			/* device list pointer */
 static kmutex_t l2arc_dev_mtx;			/* device list mutex */
 static l2arc_dev_t *l2arc_dev_last;		/* last device used */
+static l2arc_dev_t *l2arc_dev_table[L2ARC_DEV_MAX]; /* devices by l2ad_id */
 static list_t L2ARC_free_on_write;		/* free after write buf list */
 static list_t *l2arc_free_on_write;		/* free after write list ptr */
 static kmutex_t l2arc_free_on_write_mtx;	/* mutex for list */
@@ -901,6 +1027,7 @@ static inline void arc_hdr_clear_flags(arc_buf_hdr_t *hdr, arc_flags_t flags);
 static boolean_t l2arc_write_eligible(uint64_t, arc_buf_hdr_t *);
 static void l2arc_read_done(zio_t *);
 static void l2arc_do_free_on_write(void);
+static void l2arc_admit_stat_hit(arc_buf_hdr_t *);
 static void l2arc_hdr_arcstats_update(arc_buf_hdr_t *hdr, boolean_t incr,
     boolean_t state_only);
 
@@ -919,6 +1046,18 @@ static void l2arc_hdr_arcstats_update(arc_buf_hdr_t *hdr, boolean_t incr,
  */
 int l2arc_mfuonly = 0;
 
+/*
+ * l2arc_feed_adaptive : A ZFS module parameter that controls whether the
+ * 		amount written per feed pass follows the workload instead of
+ * 		being fixed at l2arc_write_max. Each pass to a device aims to
+ * 		write between half and all of its share of the L2ARC-eligible
+ * 		bytes the ARC evicted since that device was last fed, scaled
+ * 		by the L2ARC hit ratio over the same period. While the ARC is
+ * 		warming up l2arc_write_boost is added on top. The static size,
+ * 		including any boost, is the upper bound.
+ */
+int l2arc_feed_adaptive = 0;
+
 /*
  * L2ARC TRIM
  * l2arc_trim_ahead : A ZFS module parameter that controls how much ahead of
@@ -948,9 +1087,47 @@ unsigned long l2arc_trim_ahead = 0;
  * 		evicts is significant compared to the amount of restored L2ARC
  * 		data. In this case do not write log blocks in L2ARC in order
  * 		not to waste space.
+ * l2arc_rebuild_threads : A ZFS module parameter that controls how many
+ * 		threads restore the contents of log blocks into the ARC, shared
+ * 		by all devices being rebuilt. While they restore one batch of
+ * 		buffers per log block, each device's rebuild thread keeps
+ * 		reading ahead in its log block chain. The default of 0 uses
+ * 		one thread per CPU.
  */
 int l2arc_rebuild_enabled = B_TRUE;
 unsigned long l2arc_rebuild_blocks_min_l2size = 1024 * 1024 * 1024;
+int l2arc_rebuild_threads = 0;
+
+/*
+ * Number of threads in l2arc_rebuild_taskq. Each device keeps at most
+ * twice as many read-ahead log blocks waiting to be restored.
+ */
+static int l2arc_rebuild_nthreads;
+static taskq_t *l2arc_rebuild_taskq;
+
+/*
+ * State shared between the rebuild thread of an L2ARC device and the
+ * tasks restoring its log blocks. Tasks may allocate their buffers in
+ * parallel, but link them into l2ad_buflist in the order the log blocks
+ * were read, so lrc_linked counts the log blocks linked so far.
+ */
+typedef struct l2arc_rebuild_ctx {
+	l2arc_dev_t	*lrc_dev;
+	kmutex_t	lrc_lock;
+	kcondvar_t	lrc_cv;
+	uint64_t	lrc_issued;	/* log blocks handed to tasks */
+	uint64_t	lrc_linked;	/* log blocks linked into buflist */
+	uint64_t	lrc_done;	/* restore tasks completed */
+	boolean_t	lrc_finished;
+} l2arc_rebuild_ctx_t;
+
+typedef struct l2arc_rebuild_task {
+	taskq_ent_t		lrt_tqent;
+	l2arc_rebuild_ctx_t	*lrt_ctx;
+	l2arc_log_blk_phys_t	*lrt_lb;
+	uint64_t		lrt_asize;	/* aligned size of log block */
+	uint64_t		lrt_seq;	/* position in the chain */
+} l2arc_rebuild_task_t;
 
 /* L2ARC persistence rebuild control routines. */
 void l2arc_rebuild_vdev(vdev_t *vd, boolean_t reopen);
@@ -968,10 +1145,11 @@ static zio_t *l2arc_log_blk_fetch(vdev_t *vd,
 static void l2arc_log_blk_fetch_abort(zio_t *zio);
 
 /* L2ARC persistence block restoration routines. */
-static void l2arc_log_blk_restore(l2arc_dev_t *dev,
-    const l2arc_log_blk_phys_t *lb, uint64_t lb_asize);
-static void l2arc_hdr_restore(const l2arc_log_ent_phys_t *le,
+static void l2arc_log_blk_restore(l2arc_rebuild_ctx_t *lrc,
+    const l2arc_log_blk_phys_t *lb, uint64_t lb_asize, uint64_t seq);
+static arc_buf_hdr_t *l2arc_hdr_restore_alloc(const l2arc_log_ent_phys_t *le,
     l2arc_dev_t *dev);
+static void l2arc_hdr_restore(arc_buf_hdr_t *hdr, l2arc_dev_t *dev);
 
 /* L2ARC persistence write I/O routines. */
 static void l2arc_log_blk_commit(l2arc_dev_t *dev, zio_t *pio,
@@ -1018,6 +1196,25 @@ buf_discard_identity(arc_buf_hdr_t *hdr)
 	hdr->b_birth = 0;
 }
 
+/*
+ * Acquire a hash lock on one of the hot lookup paths, accounting for the
+ * time spent waiting when it is already held.  The uncontended case costs
+ * no more than a plain mutex_enter().
+ */
+static inline void
+buf_hash_lock_enter(kmutex_t *hash_lock)
+{
+	hrtime_t start;
+
+	if (mutex_tryenter(hash_lock))
+		return;
+
+	start = gethrtime();
+	mutex_enter(hash_lock);
+	ARCSTAT_BUMP(arcstat_hash_lock_contended);
+	ARCSTAT_INCR(arcstat_hash_lock_wait_ns, gethrtime() - start);
+}
+
 static arc_buf_hdr_t *
 buf_hash_find(uint64_t spa, const blkptr_t *bp, kmutex_t **lockp)
 {
@@ -1027,7 +1224,7 @@ buf_hash_find(uint64_t spa, const blkptr_t *bp, kmutex_t **lockp)
 	kmutex_t *hash_lock = BUF_HASH_LOCK(idx);
 	arc_buf_hdr_t *hdr;
 
-	mutex_enter(hash_lock);
+	buf_hash_lock_enter(hash_lock);
 	for (hdr = buf_hash_table.ht_table[idx]; hdr != NULL;
 	    hdr = hdr->b_hash_next) {
 		if (HDR_EQUAL(spa, dva, birth, hdr)) {
@@ -1117,6 +1314,165 @@ buf_hash_remove(arc_buf_hdr_t *hdr)
 		ARCSTAT_BUMPDOWN(arcstat_hash_chains);
 }
 
+/*
+ * Access-frequency filter
+ *
+ * The MRU/MFU split protects the working set from a single pass over a
+ * large data set only as long as the streamed blocks are not referenced
+ * again.  A block that is streamed by a job which runs periodically (e.g.
+ * a nightly backup) will hit in the ghost lists on the next run, and is
+ * then promoted to the MFU state where it competes with genuinely hot
+ * data.  When zfs_arc_lfu_enabled is set, every distinct demand access to
+ * a block is counted in a count-min sketch, in the spirit of TinyLFU.
+ * Promotion to the MFU state then requires an estimated frequency of at
+ * least zfs_arc_lfu_admit_freq, and arc_evict_state_impl() passes over
+ * buffers at or above that frequency in favor of buffers below it.
+ *
+ * The sketch is an array of saturating counters, ARC_SKETCH_DEPTH rows
+ * deep and sized from the hash table.  An estimate is the minimum over the
+ * rows, so a block may only be over-counted.  Counter updates are not
+ * atomic; a lost increment only makes an estimate slightly less accurate.
+ * Once as_sample_size accesses have been recorded, the arc_reap_zthr
+ * halves all counters so the sketch reflects recent popularity rather
+ * than popularity since boot.
+ *
+ * The sketch takes one byte per hash table bucket (at least 4KiB), and is
+ * only allocated once the filter is first enabled: by arc_init() when the
+ * module is loaded with zfs_arc_lfu_enabled set, or otherwise by the
+ * arc_reap_zthr within a second of the tunable being set.  It is kept
+ * until the module is unloaded, so the filter can be turned off and on
+ * again without racing against lookups in the sketch.
+ */
+#define	ARC_SKETCH_DEPTH	4
+#define	ARC_SKETCH_CTR_MAX	15
+#define	ARC_SKETCH_MIN_WIDTH	(1ULL << 10)
+
+typedef struct arc_sketch {
+	uint64_t	as_mask;	/* width of a row, minus one */
+	uint64_t	as_sample_size;	/* accesses between agings */
+	aggsum_t	as_additions;	/* accesses since last aging */
+	uint8_t		*as_counters;	/* ARC_SKETCH_DEPTH rows */
+} arc_sketch_t;
+
+static arc_sketch_t arc_sketch;
+
+/*
+ * The filter is only consulted once the sketch has been allocated.
+ */
+static inline boolean_t
+arc_lfu_active(void)
+{
+	return (zfs_arc_lfu_enabled && arc_sketch.as_counters != NULL);
+}
+
+static void
+arc_sketch_init(void)
+{
+	uint64_t width = MAX(ARC_SKETCH_MIN_WIDTH,
+	    (buf_hash_table.ht_mask + 1) >> 2);
+
+	arc_sketch.as_mask = width - 1;
+	arc_sketch.as_sample_size = width * 10;
+	aggsum_init(&arc_sketch.as_additions, 0);
+	arc_sketch.as_counters = NULL;
+}
+
+/*
+ * Allocate the counters the first time the filter is enabled.  Only
+ * called from arc_init() and the arc_reap_zthr, so there is never more
+ * than one caller at a time.
+ */
+static void
+arc_sketch_alloc(void)
+{
+	uint8_t *counters;
+
+	if (arc_sketch.as_counters != NULL)
+		return;
+
+	counters = vmem_zalloc((arc_sketch.as_mask + 1) * ARC_SKETCH_DEPTH,
+	    KM_SLEEP);
+	membar_producer();
+	arc_sketch.as_counters = counters;
+}
+
+static void
+arc_sketch_fini(void)
+{
+	if (arc_sketch.as_counters != NULL) {
+		vmem_free(arc_sketch.as_counters,
+		    (arc_sketch.as_mask + 1) * ARC_SKETCH_DEPTH);
+		arc_sketch.as_counters = NULL;
+	}
+	aggsum_fini(&arc_sketch.as_additions);
+}
+
+static inline uint8_t *
+arc_sketch_counter(uint64_t hash, int row)
+{
+	uint64_t h1 = hash & UINT32_MAX;
+	uint64_t h2 = (hash >> 32) | 1;
+
+	return (&arc_sketch.as_counters[row * (arc_sketch.as_mask + 1) +
+	    ((h1 + row * h2) & arc_sketch.as_mask)]);
+}
+
+static uint_t
+arc_sketch_estimate(uint64_t hash)
+{
+	uint_t freq = ARC_SKETCH_CTR_MAX;
+
+	for (int i = 0; i < ARC_SKETCH_DEPTH; i++)
+		freq = MIN(freq, *arc_sketch_counter(hash, i));
+
+	return (freq);
+}
+
+/*
+ * Count one access and return the new estimate.  Only the counters which
+ * hold the current minimum are incremented ("conservative update"), which
+ * reduces over-counting caused by collisions.
+ */
+static uint_t
+arc_sketch_increment(uint64_t hash)
+{
+	uint_t freq = arc_sketch_estimate(hash);
+
+	if (freq >= ARC_SKETCH_CTR_MAX)
+		return (freq);
+
+	for (int i = 0; i < ARC_SKETCH_DEPTH; i++) {
+		uint8_t *ctr = arc_sketch_counter(hash, i);
+		if (*ctr == freq)
+			*ctr = freq + 1;
+	}
+	aggsum_add(&arc_sketch.as_additions, 1);
+
+	return (freq + 1);
+}
+
+/*
+ * Halve every counter once enough accesses have been recorded.  Called
+ * from the arc_reap_zthr so that the walk over the sketch is never done
+ * while holding a hash lock.
+ */
+static void
+arc_sketch_age(void)
+{
+	uint64_t ncounters = (arc_sketch.as_mask + 1) * ARC_SKETCH_DEPTH;
+
+	if (aggsum_compare(&arc_sketch.as_additions,
+	    arc_sketch.as_sample_size) < 0)
+		return;
+
+	for (uint64_t i = 0; i < ncounters; i++)
+		arc_sketch.as_counters[i] >>= 1;
+
+	aggsum_add(&arc_sketch.as_additions,
+	    -(int64_t)(aggsum_value(&arc_sketch.as_additions) / 2));
+	ARCSTAT_BUMP(arcstat_lfu_sketch_resets);
+}
+
 /*
  * Global data structures and functions for the buf kmem cache.
  */
@@ -1142,8 +1498,11 @@ buf_fini(void)
 	kmem_free(buf_hash_table.ht_table,
 	    (buf_hash_table.ht_mask + 1) * sizeof (void *));
 #endif
-	for (i = 0; i < BUF_LOCKS; i++)
+	for (i = 0; i <= buf_hash_table.ht_lock_mask; i++)
 		mutex_destroy(&buf_hash_table.ht_locks[i].ht_lock);
+	vmem_free(buf_hash_table.ht_locks,
+	    (buf_hash_table.ht_lock_mask + 1) * sizeof (struct ht_lock));
+	arc_sketch_fini();
 	kmem_cache_destroy(hdr_full_cache);
 	kmem_cache_destroy(hdr_full_crypt_cache);
 	kmem_cache_destroy(hdr_l2only_cache);
@@ -1264,6 +1623,7 @@ buf_init(void)
 {
 	uint64_t *ct = NULL;
 	uint64_t hsize = 1ULL << 12;
+	uint64_t nlocks;
 	int i, j;
 
 	/*
@@ -1308,10 +1668,22 @@ retry:
 		for (ct = zfs_crc64_table + i, *ct = i, j = 8; j > 0; j--)
 			*ct = (*ct >> 1) ^ (-(*ct & 1) & ZFS_CRC64_POLY);
 
-	for (i = 0; i < BUF_LOCKS; i++) {
+	nlocks = MAX(BUF_LOCKS, boot_ncpus * BUF_LOCKS_PER_CPU);
+	if (!ISP2(nlocks))
+		nlocks = 1ULL << highbit64(nlocks);
+	nlocks = MIN(nlocks, hsize);
+	buf_hash_table.ht_lock_mask = nlocks - 1;
+	buf_hash_table.ht_locks =
+	    vmem_zalloc(nlocks * sizeof (struct ht_lock), KM_SLEEP);
+	for (i = 0; i < nlocks; i++) {
 		mutex_init(&buf_hash_table.ht_locks[i].ht_lock,
 		    NULL, MUTEX_DEFAULT, NULL);
 	}
+	ARCSTAT(arcstat_hash_locks) = nlocks;
+
+	arc_sketch_init();
+	if (zfs_arc_lfu_enabled)
+		arc_sketch_alloc();
 }
 
 #define	ARC_MINTIME	(hz>>4) /* 62 ms */
@@ -1741,6 +2113,26 @@ arc_buf_try_copy_decompressed_data(arc_buf_t *buf)
  * which circumvent the regular disk->arc->l2arc path and instead come
  * into being in the reverse order, i.e. l2arc->arc.
  */
+/*
+ * Accessors for the fields packed into b_l2prop, see l2arc_buf_hdr_t.
+ */
+#define	HDR_L2_DEV(hdr)	(l2arc_dev_table[L2HDR_GET_DEVID(&(hdr)->b_l2hdr)])
+#define	HDR_L2_DADDR(hdr)	L2HDR_GET_DADDR(&(hdr)->b_l2hdr)
+#define	HDR_L2_STATE(hdr)	L2HDR_GET_STATE(&(hdr)->b_l2hdr)
+
+static inline void
+l2arc_hdr_set(arc_buf_hdr_t *hdr, l2arc_dev_t *dev, uint64_t daddr,
+    arc_state_type_t arcs_state)
+{
+	l2arc_buf_hdr_t *l2hdr = &hdr->b_l2hdr;
+
+	ASSERT3P(l2arc_dev_table[dev->l2ad_id], ==, dev);
+	l2hdr->b_l2prop = 0;
+	L2HDR_SET_DADDR(l2hdr, daddr);
+	L2HDR_SET_STATE(l2hdr, arcs_state);
+	L2HDR_SET_DEVID(l2hdr, dev->l2ad_id);
+}
+
 static arc_buf_hdr_t *
 arc_buf_alloc_l2only(size_t size, arc_buf_contents_t type, l2arc_dev_t *dev,
     dva_t dva, uint64_t daddr, int32_t psize, uint64_t birth,
@@ -1767,9 +2159,7 @@ arc_buf_alloc_l2only(size_t size, arc_buf_contents_t type, l2arc_dev_t *dev,
 
 	hdr->b_dva = dva;
 
-	hdr->b_l2hdr.b_dev = dev;
-	hdr->b_l2hdr.b_daddr = daddr;
-	hdr->b_l2hdr.b_arcs_state = arcs_state;
+	l2arc_hdr_set(hdr, dev, daddr, arcs_state);
 
 	return (hdr);
 }
@@ -2000,6 +2390,226 @@ arc_buf_untransform_in_place(arc_buf_t *buf, kmutex_t *hash_lock)
 	hdr->b_crypt_hdr.b_ebufcnt -= 1;
 }
 
+/*
+ * Decompression cache.
+ *
+ * With compressed ARC, every uncompressed buf created for a compressed
+ * header decompresses the header's data, unless another buf of the header
+ * already holds an uncompressed copy.  For small, hot blocks which are
+ * repeatedly read through short-lived bufs this makes decompression a
+ * significant part of the cost of an ARC hit.  Once such a header has
+ * been decompressed zfs_arc_ucache_hits times (b_decomp_cnt; the hit
+ * counters are reset whenever a buf is created), an uncompressed copy of
+ * its data is kept with it (see arc_ucache_t) and later fills copy from it
+ * instead.
+ *
+ * The copies are charged to the ARC like any other buffer but are the
+ * cheapest memory to give back: arc_evict() drops them, least recently
+ * used first, before it evicts any cached buffers, and they are dropped
+ * with their header when it leaves the MRU/MFU states.
+ */
+
+static uint64_t
+arc_ucache_max(void)
+{
+	return (arc_c / 100 * MIN(zfs_arc_ucache_percent, 100));
+}
+
+static void
+arc_ucache_free(arc_ucache_t *uc)
+{
+	if (uc->uc_type == ARC_BUFC_METADATA) {
+		zio_buf_free(uc->uc_data, uc->uc_size);
+		arc_space_return(uc->uc_size, ARC_SPACE_META);
+	} else {
+		ASSERT(uc->uc_type == ARC_BUFC_DATA);
+		zio_data_buf_free(uc->uc_data, uc->uc_size);
+		arc_space_return(uc->uc_size, ARC_SPACE_DATA);
+	}
+	ARCSTAT_INCR(arcstat_ucache_size, -uc->uc_size);
+	kmem_free(uc, sizeof (arc_ucache_t));
+}
+
+/*
+ * Drop least recently used uncompressed copies until at least the given
+ * number of bytes has been released.  Copies which were hit since the
+ * last scan get a second chance, and those whose hash lock can't be taken
+ * without waiting are skipped, so this may release less than requested.
+ */
+static uint64_t
+arc_ucache_evict(uint64_t bytes)
+{
+	list_t free_list;
+	arc_ucache_t *uc;
+	uint64_t evicted = 0;
+	uint64_t scanned = 0;
+
+	list_create(&free_list, sizeof (arc_ucache_t),
+	    offsetof(arc_ucache_t, uc_node));
+
+	mutex_enter(&arc_ucache_lock);
+	while (evicted < bytes && scanned < arc_ucache_size &&
+	    (uc = list_tail(&arc_ucache_list)) != NULL) {
+		arc_buf_hdr_t *hdr = uc->uc_hdr;
+		kmutex_t *hash_lock = HDR_LOCK(hdr);
+
+		scanned += uc->uc_size;
+		list_remove(&arc_ucache_list, uc);
+
+		if (uc->uc_referenced || !mutex_tryenter(hash_lock)) {
+			uc->uc_referenced = B_FALSE;
+			list_insert_head(&arc_ucache_list, uc);
+			continue;
+		}
+
+		ASSERT3P(hdr->b_l1hdr.b_ucache, ==, uc);
+		hdr->b_l1hdr.b_ucache = NULL;
+		mutex_exit(hash_lock);
+
+		arc_ucache_size -= uc->uc_size;
+		evicted += uc->uc_size;
+		list_insert_tail(&free_list, uc);
+	}
+	mutex_exit(&arc_ucache_lock);
+
+	while ((uc = list_remove_head(&free_list)) != NULL) {
+		ARCSTAT_BUMP(arcstat_ucache_evictions);
+		arc_ucache_free(uc);
+	}
+	list_destroy(&free_list);
+
+	return (evicted);
+}
+
+/*
+ * Drop the header's uncompressed copy, if any.  The hash lock must be held.
+ */
+static void
+arc_ucache_drop(arc_buf_hdr_t *hdr)
+{
+	arc_ucache_t *uc = hdr->b_l1hdr.b_ucache;
+
+	if (uc == NULL)
+		return;
+
+	mutex_enter(&arc_ucache_lock);
+	list_remove(&arc_ucache_list, uc);
+	arc_ucache_size -= uc->uc_size;
+	hdr->b_l1hdr.b_ucache = NULL;
+	mutex_exit(&arc_ucache_lock);
+
+	arc_ucache_free(uc);
+}
+
+/*
+ * Fill an uncompressed buf from its header's uncompressed copy.  Returns
+ * B_FALSE if the header has none.
+ */
+static boolean_t
+arc_ucache_fill(arc_buf_t *buf, kmutex_t *hash_lock)
+{
+	arc_buf_hdr_t *hdr = buf->b_hdr;
+	arc_ucache_t *uc;
+	uint64_t size = 0;
+
+	if (hdr->b_l1hdr.b_ucache == NULL)
+		return (B_FALSE);
+
+	if (hash_lock != NULL)
+		mutex_enter(hash_lock);
+	if ((uc = hdr->b_l1hdr.b_ucache) != NULL) {
+		ASSERT3U(uc->uc_size, ==, HDR_GET_LSIZE(hdr));
+		size = uc->uc_size;
+		bcopy(uc->uc_data, buf->b_data, size);
+		uc->uc_referenced = B_TRUE;
+	}
+	if (hash_lock != NULL)
+		mutex_exit(hash_lock);
+
+	if (size == 0)
+		return (B_FALSE);
+
+	/*
+	 * Estimate the time saved from the average decompression rate, kept
+	 * in nanoseconds per KiB to avoid overflowing the multiplication.
+	 */
+	uint64_t dbytes = ARCSTAT(arcstat_decompress_bytes) >> 10;
+	if (dbytes != 0) {
+		ARCSTAT_INCR(arcstat_decompress_saved_ns,
+		    (size * (ARCSTAT(arcstat_decompress_time_ns) / dbytes)) >>
+		    10);
+	}
+	ARCSTAT_BUMP(arcstat_ucache_hits);
+	ARCSTAT_INCR(arcstat_decompress_saved_bytes, size);
+
+	return (B_TRUE);
+}
+
+/*
+ * Keep an uncompressed copy of a buf that was just decompressed, if its
+ * header is cached and hot enough, and there is room for the copy.
+ */
+static void
+arc_ucache_insert(arc_buf_t *buf, kmutex_t *hash_lock)
+{
+	arc_buf_hdr_t *hdr = buf->b_hdr;
+	arc_buf_contents_t type = arc_buf_type(hdr);
+	uint64_t size = HDR_GET_LSIZE(hdr);
+	arc_ucache_t *uc;
+
+	if (zfs_arc_ucache_hits == 0 || HDR_PROTECTED(hdr) ||
+	    hdr->b_l1hdr.b_ucache != NULL ||
+	    !ARC_CACHED_STATE(hdr->b_l1hdr.b_state) ||
+	    atomic_inc_32_nv(&hdr->b_l1hdr.b_decomp_cnt) < zfs_arc_ucache_hits)
+		return;
+
+	/*
+	 * Make room by dropping older copies, unless the caller holds a
+	 * hash lock which arc_ucache_evict() might need.
+	 */
+	if (arc_ucache_size + size > arc_ucache_max()) {
+		if (hash_lock == NULL || size > arc_ucache_max())
+			return;
+		(void) arc_ucache_evict(arc_ucache_size + size -
+		    arc_ucache_max());
+		if (arc_ucache_size + size > arc_ucache_max())
+			return;
+	}
+
+	uc = kmem_alloc(sizeof (arc_ucache_t), KM_SLEEP);
+	uc->uc_size = size;
+	uc->uc_type = type;
+	uc->uc_referenced = B_FALSE;
+	if (type == ARC_BUFC_METADATA) {
+		uc->uc_data = zio_buf_alloc(size);
+		arc_space_consume(size, ARC_SPACE_META);
+	} else {
+		ASSERT(type == ARC_BUFC_DATA);
+		uc->uc_data = zio_data_buf_alloc(size);
+		arc_space_consume(size, ARC_SPACE_DATA);
+	}
+	ARCSTAT_INCR(arcstat_ucache_size, size);
+	bcopy(buf->b_data, uc->uc_data, size);
+
+	if (hash_lock != NULL)
+		mutex_enter(hash_lock);
+	if (hdr->b_l1hdr.b_ucache == NULL &&
+	    ARC_CACHED_STATE(hdr->b_l1hdr.b_state)) {
+		mutex_enter(&arc_ucache_lock);
+		uc->uc_hdr = hdr;
+		hdr->b_l1hdr.b_ucache = uc;
+		list_insert_head(&arc_ucache_list, uc);
+		arc_ucache_size += size;
+		mutex_exit(&arc_ucache_lock);
+		uc = NULL;
+	}
+	if (hash_lock != NULL)
+		mutex_exit(hash_lock);
+
+	if (uc != NULL)
+		arc_ucache_free(uc);
+}
+
 /*
  * Given a buf that has a data buffer attached to it, this function will
  * efficiently fill the buf with data of the specified compression setting from
@@ -2025,6 +2635,7 @@ arc_buf_fill(arc_buf_t *buf, spa_t *spa, const zbookmark_phys_t *zb,
 	boolean_t encrypted = (flags & ARC_FILL_ENCRYPTED) != 0;
 	dmu_object_byteswap_t bswap = hdr->b_l1hdr.b_byteswap;
 	kmutex_t *hash_lock = (flags & ARC_FILL_LOCKED) ? NULL : HDR_LOCK(hdr);
+	boolean_t decompressed = B_FALSE;
 
 	ASSERT3P(buf->b_data, !=, NULL);
 	IMPLY(compressed, hdr_compressed || ARC_BUF_ENCRYPTED(buf));
@@ -2150,11 +2761,25 @@ arc_buf_fill(arc_buf_t *buf, spa_t *spa, const zbookmark_phys_t *zb,
 		if (arc_buf_try_copy_decompressed_data(buf)) {
 			/* Skip byteswapping and checksumming (already done) */
 			return (0);
+		} else if (arc_ucache_fill(buf, hash_lock)) {
+			/*
+			 * The copy is already byteswapped, but the hdr's
+			 * checksum may have been freed with its last buf.
+			 */
+			arc_cksum_compute(buf);
+			return (0);
 		} else {
+			hrtime_t start = gethrtime();
+
 			error = zio_decompress_data(HDR_GET_COMPRESS(hdr),
 			    hdr->b_l1hdr.b_pabd, buf->b_data,
 			    HDR_GET_PSIZE(hdr), HDR_GET_LSIZE(hdr),
 			    &hdr->b_complevel);
+			ARCSTAT_INCR(arcstat_decompress_time_ns,
+			    gethrtime() - start);
+			ARCSTAT_INCR(arcstat_decompress_bytes,
+			    HDR_GET_LSIZE(hdr));
+			decompressed = B_TRUE;
 
 			/*
 			 * Absent hardware errors or software bugs, this should
@@ -2186,6 +2811,9 @@ byteswap:
 	/* Compute the hdr's checksum if necessary */
 	arc_cksum_compute(buf);
 
+	if (decompressed)
+		arc_ucache_insert(buf, hash_lock);
+
 	return (0);
 }
 
@@ -2407,8 +3035,9 @@ arc_buf_info(arc_buf_t *ab, arc_buf_info_t *abi, int state_index)
 	}
 
 	if (l2hdr) {
-		abi->abi_l2arc_dattr = l2hdr->b_daddr;
-		abi->abi_l2arc_hits = l2hdr->b_hits;
+		abi->abi_l2arc_dattr = L2HDR_GET_DADDR(l2hdr);
+		if (l1hdr)
+			abi->abi_l2arc_hits = l1hdr->b_l2_hits;
 	}
 
 	abi->abi_state_type = state ? state->arcs_state : ARC_STATE_ANON;
@@ -2416,6 +3045,307 @@ arc_buf_info(arc_buf_t *ab, arc_buf_info_t *abi, int state_index)
 	abi->abi_size = arc_hdr_size(hdr);
 }
 
+/*
+ * Per-dataset accounting (see the comment above arc_dataset_t).
+ *
+ * Registered datasets are kept in an AVL tree keyed by pool and objset id,
+ * so that every registration of the same dataset shares one arc_dataset_t
+ * and arc_evict() can find those with a quota.  Each objset resolves its
+ * arc_dataset_t once when it is opened and passes it to arc_read_dataset()
+ * and arc_write(), so reads and writes never look at the tree.  A header
+ * is only ever (re)tagged while it is not in the MRU or MFU state, so
+ * everything charged to a dataset by arc_dataset_space() is later returned
+ * to that same dataset.
+ */
+static avl_tree_t arc_dataset_tree;
+static krwlock_t arc_dataset_lock;
+
+/* number of registered datasets with an ARC quota */
+static uint64_t arc_dataset_nquota;
+
+/* set by arc_evict() while at least one dataset is over its ARC quota */
+static boolean_t arc_dataset_over_quota;
+
+static int
+arc_dataset_compare(const void *x1, const void *x2)
+{
+	const arc_dataset_t *ad1 = x1;
+	const arc_dataset_t *ad2 = x2;
+
+	int cmp = TREE_CMP(ad1->ad_spa, ad2->ad_spa);
+	if (likely(cmp))
+		return (cmp);
+
+	return (TREE_CMP(ad1->ad_objset, ad2->ad_objset));
+}
+
+arc_dataset_t *
+arc_dataset_register(spa_t *spa, uint64_t objset)
+{
+	arc_dataset_t search, *ad;
+	avl_index_t where;
+
+	search.ad_spa = spa_load_guid(spa);
+	search.ad_objset = objset;
+
+	rw_enter(&arc_dataset_lock, RW_WRITER);
+	ad = avl_find(&arc_dataset_tree, &search, &where);
+	if (ad == NULL) {
+		ad = kmem_zalloc(sizeof (arc_dataset_t), KM_SLEEP);
+		ad->ad_spa = search.ad_spa;
+		ad->ad_objset = objset;
+		avl_insert(&arc_dataset_tree, ad, where);
+	}
+	ad->ad_nregs++;
+	atomic_inc_64(&ad->ad_refcnt);
+	rw_exit(&arc_dataset_lock);
+
+	return (ad);
+}
+
+/*
+ * Add a reference for a caller which may use the arc_dataset_t after the
+ * registration it got it from is gone, such as an asynchronous prefetch.
+ */
+void
+arc_dataset_hold(arc_dataset_t *ad)
+{
+	VERIFY3U(atomic_inc_64_nv(&ad->ad_refcnt), >, 1);
+}
+
+void
+arc_dataset_rele(arc_dataset_t *ad)
+{
+	/*
+	 * Only datasets which are no longer in the tree can drop their
+	 * last reference, so no new holds can race with the free.  The
+	 * size should have been returned by the headers which were charged
+	 * to the dataset; it is only used to steer eviction, so a drift is
+	 * logged rather than treated as fatal.
+	 */
+	if (atomic_dec_64_nv(&ad->ad_refcnt) == 0) {
+		ASSERT0(ad->ad_nregs);
+		if (ad->ad_size != 0) {
+			zfs_dbgmsg("arc dataset %llu freed with size %lld",
+			    (u_longlong_t)ad->ad_objset,
+			    (longlong_t)ad->ad_size);
+		}
+		kmem_free(ad, sizeof (arc_dataset_t));
+	}
+}
+
+/*
+ * The number of bytes charged to the dataset.  Should the accounting have
+ * drifted below zero, report an empty dataset instead of a huge one.
+ */
+static inline uint64_t
+arc_dataset_size(arc_dataset_t *ad)
+{
+	int64_t size = (int64_t)ad->ad_size;
+
+	return (size > 0 ? size : 0);
+}
+
+void
+arc_dataset_unregister(arc_dataset_t *ad)
+{
+	rw_enter(&arc_dataset_lock, RW_WRITER);
+	ASSERT3U(ad->ad_nregs, >, 0);
+	if (--ad->ad_nregs == 0) {
+		avl_remove(&arc_dataset_tree, ad);
+		if (ad->ad_quota != 0)
+			atomic_dec_64(&arc_dataset_nquota);
+	}
+	rw_exit(&arc_dataset_lock);
+
+	arc_dataset_rele(ad);
+}
+
+void
+arc_dataset_set_quota(arc_dataset_t *ad, uint64_t quota)
+{
+	rw_enter(&arc_dataset_lock, RW_WRITER);
+	if (ad->ad_quota == 0 && quota != 0)
+		atomic_inc_64(&arc_dataset_nquota);
+	else if (ad->ad_quota != 0 && quota == 0)
+		atomic_dec_64(&arc_dataset_nquota);
+	ad->ad_quota = quota;
+	rw_exit(&arc_dataset_lock);
+}
+
+void
+arc_dataset_set_reservation(arc_dataset_t *ad, uint64_t reservation)
+{
+	ad->ad_reservation = reservation;
+}
+
+void
+arc_dataset_set_l2arc_admit(arc_dataset_t *ad, zfs_l2arc_admit_t admit)
+{
+	ad->ad_l2arc_admit = admit;
+}
+
+void
+arc_dataset_stats(arc_dataset_t *ad, uint64_t *size, uint64_t *hits,
+    uint64_t *misses)
+{
+	*size = arc_dataset_size(ad);
+	*hits = ad->ad_hits;
+	*misses = ad->ad_misses;
+}
+
+/*
+ * The predictive prefetcher keeps the number of streams of the dataset's
+ * objects and the sum of their prefetch distances here, so that they can
+ * be reported with the dataset's other kstats.
+ */
+void
+arc_dataset_prefetch_update(arc_dataset_t *ad, int64_t streams,
+    int64_t distance)
+{
+	if (ad == NULL)
+		return;
+	if (streams != 0)
+		atomic_add_64(&ad->ad_pf_streams, streams);
+	if (distance != 0)
+		atomic_add_64(&ad->ad_pf_distance, distance);
+}
+
+void
+arc_dataset_prefetch_stats(arc_dataset_t *ad, uint64_t *streams,
+    uint64_t *distance)
+{
+	*streams = ad->ad_pf_streams;
+	*distance = ad->ad_pf_distance;
+}
+
+/*
+ * Charge a header that is not yet cached to the given dataset, if any.
+ * The caller's own reference keeps the dataset from being freed.
+ */
+static void
+arc_hdr_set_dataset(arc_buf_hdr_t *hdr, arc_dataset_t *ad)
+{
+	ASSERT(HDR_HAS_L1HDR(hdr));
+	ASSERT(!ARC_CACHED_STATE(hdr->b_l1hdr.b_state));
+
+	if (hdr->b_l1hdr.b_dataset != NULL || ad == NULL)
+		return;
+
+	arc_dataset_hold(ad);
+	hdr->b_l1hdr.b_dataset = ad;
+}
+
+static void
+arc_hdr_clear_dataset(arc_buf_hdr_t *hdr)
+{
+	arc_dataset_t *ad = hdr->b_l1hdr.b_dataset;
+
+	if (ad != NULL) {
+		hdr->b_l1hdr.b_dataset = NULL;
+		arc_dataset_rele(ad);
+	}
+}
+
+/*
+ * Mirror a change of the given state's arcs_size on behalf of the header
+ * in the size of the dataset it is charged to.
+ */
+static inline void
+arc_dataset_space(arc_buf_hdr_t *hdr, arc_state_t *state, int64_t delta)
+{
+	arc_dataset_t *ad;
+
+	if (!ARC_CACHED_STATE(state) || !HDR_HAS_L1HDR(hdr) ||
+	    (ad = hdr->b_l1hdr.b_dataset) == NULL)
+		return;
+
+	atomic_add_64(&ad->ad_size, delta);
+}
+
+/*
+ * Returns the number of bytes arc_change_state() adds to or removes from
+ * the size of a non-ghost state for this header.
+ */
+static uint64_t
+arc_hdr_state_size(arc_buf_hdr_t *hdr)
+{
+	uint64_t size = 0;
+
+	for (arc_buf_t *buf = hdr->b_l1hdr.b_buf; buf != NULL;
+	    buf = buf->b_next) {
+		if (!arc_buf_is_shared(buf))
+			size += arc_buf_size(buf);
+	}
+	if (hdr->b_l1hdr.b_pabd != NULL)
+		size += arc_hdr_size(hdr);
+	if (HDR_HAS_RABD(hdr))
+		size += HDR_GET_PSIZE(hdr);
+
+	return (size);
+}
+
+static inline void
+arc_dataset_hit(arc_buf_hdr_t *hdr)
+{
+	if (hdr->b_l1hdr.b_dataset != NULL)
+		atomic_inc_64(&hdr->b_l1hdr.b_dataset->ad_hits);
+}
+
+/*
+ * Recompute whether any registered dataset is over its ARC quota.  Only
+ * datasets with a quota are interesting, so nothing is walked unless at
+ * least one is set.
+ */
+static void
+arc_dataset_update_quota(void)
+{
+	boolean_t over = B_FALSE;
+	uint64_t nover = 0;
+
+	if (arc_dataset_nquota != 0) {
+		rw_enter(&arc_dataset_lock, RW_READER);
+		for (arc_dataset_t *ad = avl_first(&arc_dataset_tree);
+		    ad != NULL; ad = AVL_NEXT(&arc_dataset_tree, ad)) {
+			if (ad->ad_quota != 0 &&
+			    arc_dataset_size(ad) > ad->ad_quota)
+				nover++;
+		}
+		rw_exit(&arc_dataset_lock);
+		over = (nover != 0);
+	}
+
+	arc_dataset_over_quota = over;
+	ARCSTAT(arcstat_dataset_over_quota) = nover;
+}
+
+/*
+ * Decide whether eviction should pass over this cached header for now:
+ * while some dataset is over its quota only buffers of over-quota datasets
+ * are evicted, and buffers of datasets within their reservation are kept.
+ * Buffers charged to no dataset, such as those of the MOS and snapshots,
+ * are never passed over; nothing limits them, so sparing them would let
+ * them take the space the quota frees.
+ */
+static boolean_t
+arc_dataset_evict_skip(arc_buf_hdr_t *hdr)
+{
+	arc_dataset_t *ad = hdr->b_l1hdr.b_dataset;
+	uint64_t size;
+
+	if (ad == NULL)
+		return (B_FALSE);
+
+	size = arc_dataset_size(ad);
+	if (ad->ad_quota != 0 && size > ad->ad_quota)
+		return (B_FALSE);
+
+	if (size <= ad->ad_reservation)
+		return (B_TRUE);
+
+	return (arc_dataset_over_quota);
+}
+
 /*
  * Move the supplied buffer to the indicated state. The hash lock
  * for the buffer must be held by the caller.
@@ -2456,6 +3386,9 @@ arc_change_state(arc_state_t *new_state, arc_buf_hdr_t *hdr,
 	ASSERT(!GHOST_STATE(new_state) || bufcnt == 0);
 	ASSERT(old_state != arc_anon || bufcnt <= 1);
 
+	if (HDR_HAS_L1HDR(hdr) && !ARC_CACHED_STATE(new_state))
+		arc_ucache_drop(hdr);
+
 	/*
 	 * If this buffer is evictable, transfer it from the
 	 * old state list to the new state list.
@@ -2618,12 +3551,22 @@ arc_change_state(arc_state_t *new_state, arc_buf_hdr_t *hdr,
 		}
 	}
 
+	/* mirror the size change in the dataset charged for the header */
+	if (update_old && HDR_HAS_L1HDR(hdr) &&
+	    hdr->b_l1hdr.b_dataset != NULL &&
+	    ARC_CACHED_STATE(old_state) != ARC_CACHED_STATE(new_state)) {
+		int64_t size = arc_hdr_state_size(hdr);
+
+		arc_dataset_space(hdr, old_state, -size);
+		arc_dataset_space(hdr, new_state, size);
+	}
+
 	if (HDR_HAS_L1HDR(hdr)) {
 		hdr->b_l1hdr.b_state = new_state;
 
 		if (HDR_HAS_L2HDR(hdr) && new_state != arc_l2c_only) {
 			l2arc_hdr_arcstats_decrement_state(hdr);
-			hdr->b_l2hdr.b_arcs_state = new_state->arcs_state;
+			L2HDR_SET_STATE(&hdr->b_l2hdr, new_state->arcs_state);
 			l2arc_hdr_arcstats_increment_state(hdr);
 		}
 	}
@@ -3000,6 +3943,7 @@ arc_hdr_free_on_write(arc_buf_hdr_t *hdr, boolean_t free_rdata)
 		    size, hdr);
 	}
 	(void) zfs_refcount_remove_many(&state->arcs_size, size, hdr);
+	arc_dataset_space(hdr, state, -size);
 	if (type == ARC_BUFC_METADATA) {
 		arc_space_return(size, ARC_SPACE_META);
 	} else {
@@ -3332,6 +4276,7 @@ arc_hdr_alloc(uint64_t spa, int32_t psize, int32_t lsize,
 	hdr->b_l1hdr.b_arc_access = 0;
 	hdr->b_l1hdr.b_bufcnt = 0;
 	hdr->b_l1hdr.b_buf = NULL;
+	hdr->b_l1hdr.b_decomp_cnt = 0;
 
 	/*
 	 * Allocate the hdr's buffer. This will contain either
@@ -3357,7 +4302,7 @@ arc_hdr_realloc(arc_buf_hdr_t *hdr, kmem_cache_t *old, kmem_cache_t *new)
 	ASSERT(HDR_HAS_L2HDR(hdr));
 
 	arc_buf_hdr_t *nhdr;
-	l2arc_dev_t *dev = hdr->b_l2hdr.b_dev;
+	l2arc_dev_t *dev = HDR_L2_DEV(hdr);
 
 	ASSERT((old == hdr_full_cache && new == hdr_l2only_cache) ||
 	    (old == hdr_l2only_cache && new == hdr_full_cache));
@@ -3387,6 +4332,7 @@ arc_hdr_realloc(arc_buf_hdr_t *hdr, kmem_cache_t *old, kmem_cache_t *new)
 		 * l2c_only even though it's about to change.
 		 */
 		nhdr->b_l1hdr.b_state = arc_l2c_only;
+		nhdr->b_l1hdr.b_decomp_cnt = 0;
 
 		/* Verify previous threads set to NULL before freeing */
 		ASSERT3P(nhdr->b_l1hdr.b_pabd, ==, NULL);
@@ -3415,6 +4361,7 @@ arc_hdr_realloc(arc_buf_hdr_t *hdr, kmem_cache_t *old, kmem_cache_t *new)
 		VERIFY3P(hdr->b_l1hdr.b_pabd, ==, NULL);
 		ASSERT(!HDR_HAS_RABD(hdr));
 
+		arc_hdr_clear_dataset(hdr);
 		arc_hdr_clear_flags(nhdr, ARC_FLAG_HAS_L1HDR);
 	}
 	/*
@@ -3512,6 +4459,7 @@ arc_hdr_realloc_crypt(arc_buf_hdr_t *hdr, boolean_t need_crypt)
 	nhdr->b_l1hdr.b_freeze_cksum = hdr->b_l1hdr.b_freeze_cksum;
 	nhdr->b_l1hdr.b_bufcnt = hdr->b_l1hdr.b_bufcnt;
 	nhdr->b_l1hdr.b_byteswap = hdr->b_l1hdr.b_byteswap;
+	nhdr->b_l1hdr.b_decomp_cnt = hdr->b_l1hdr.b_decomp_cnt;
 	nhdr->b_l1hdr.b_state = hdr->b_l1hdr.b_state;
 	nhdr->b_l1hdr.b_arc_access = hdr->b_l1hdr.b_arc_access;
 	nhdr->b_l1hdr.b_mru_hits = hdr->b_l1hdr.b_mru_hits;
@@ -3521,6 +4469,7 @@ arc_hdr_realloc_crypt(arc_buf_hdr_t *hdr, boolean_t need_crypt)
 	nhdr->b_l1hdr.b_l2_hits = hdr->b_l1hdr.b_l2_hits;
 	nhdr->b_l1hdr.b_acb = hdr->b_l1hdr.b_acb;
 	nhdr->b_l1hdr.b_pabd = hdr->b_l1hdr.b_pabd;
+	nhdr->b_l1hdr.b_dataset = hdr->b_l1hdr.b_dataset;
 
 	/*
 	 * This zfs_refcount_add() exists only to ensure that the individual
@@ -3557,6 +4506,7 @@ arc_hdr_realloc_crypt(arc_buf_hdr_t *hdr, boolean_t need_crypt)
 	hdr->b_l1hdr.b_buf = NULL;
 	hdr->b_l1hdr.b_bufcnt = 0;
 	hdr->b_l1hdr.b_byteswap = 0;
+	hdr->b_l1hdr.b_decomp_cnt = 0;
 	hdr->b_l1hdr.b_state = NULL;
 	hdr->b_l1hdr.b_arc_access = 0;
 	hdr->b_l1hdr.b_mru_hits = 0;
@@ -3566,6 +4516,7 @@ arc_hdr_realloc_crypt(arc_buf_hdr_t *hdr, boolean_t need_crypt)
 	hdr->b_l1hdr.b_l2_hits = 0;
 	hdr->b_l1hdr.b_acb = NULL;
 	hdr->b_l1hdr.b_pabd = NULL;
+	hdr->b_l1hdr.b_dataset = NULL;
 
 	if (ocache == hdr_full_crypt_cache) {
 		ASSERT(!HDR_HAS_RABD(hdr));
@@ -3718,8 +4669,7 @@ static void
 l2arc_hdr_arcstats_update(arc_buf_hdr_t *hdr, boolean_t incr,
     boolean_t state_only)
 {
-	l2arc_buf_hdr_t *l2hdr = &hdr->b_l2hdr;
-	l2arc_dev_t *dev = l2hdr->b_dev;
+	l2arc_dev_t *dev = HDR_L2_DEV(hdr);
 	uint64_t lsize = HDR_GET_LSIZE(hdr);
 	uint64_t psize = HDR_GET_PSIZE(hdr);
 	uint64_t asize = vdev_psize_to_asize(dev->l2ad_vdev, psize);
@@ -3751,7 +4701,7 @@ l2arc_hdr_arcstats_update(arc_buf_hdr_t *hdr, boolean_t incr,
 		 * possibly absent L1 header (apparent in buffers restored
 		 * from persistent L2ARC).
 		 */
-		switch (hdr->b_l2hdr.b_arcs_state) {
+		switch (HDR_L2_STATE(hdr)) {
 			case ARC_STATE_MRU_GHOST:
 			case ARC_STATE_MRU:
 				ARCSTAT_INCR(arcstat_l2_mru_asize, asize_s);
@@ -3770,6 +4720,7 @@ l2arc_hdr_arcstats_update(arc_buf_hdr_t *hdr, boolean_t incr,
 
 	ARCSTAT_INCR(arcstat_l2_psize, psize_s);
 	ARCSTAT_INCR(arcstat_l2_lsize, lsize_s);
+	ARCSTAT_INCR(arcstat_l2_hdrs, incr ? 1 : -1);
 
 	switch (type) {
 		case ARC_BUFC_DATA:
@@ -3787,8 +4738,7 @@ l2arc_hdr_arcstats_update(arc_buf_hdr_t *hdr, boolean_t incr,
 static void
 arc_hdr_l2hdr_destroy(arc_buf_hdr_t *hdr)
 {
-	l2arc_buf_hdr_t *l2hdr = &hdr->b_l2hdr;
-	l2arc_dev_t *dev = l2hdr->b_dev;
+	l2arc_dev_t *dev = HDR_L2_DEV(hdr);
 	uint64_t psize = HDR_GET_PSIZE(hdr);
 	uint64_t asize = vdev_psize_to_asize(dev->l2ad_vdev, psize);
 
@@ -3813,12 +4763,13 @@ arc_hdr_destroy(arc_buf_hdr_t *hdr)
 		    hdr->b_l1hdr.b_bufcnt > 0);
 		ASSERT(zfs_refcount_is_zero(&hdr->b_l1hdr.b_refcnt));
 		ASSERT3P(hdr->b_l1hdr.b_state, ==, arc_anon);
+		ASSERT3P(hdr->b_l1hdr.b_ucache, ==, NULL);
 	}
 	ASSERT(!HDR_IO_IN_PROGRESS(hdr));
 	ASSERT(!HDR_IN_HASH_TABLE(hdr));
 
 	if (HDR_HAS_L2HDR(hdr)) {
-		l2arc_dev_t *dev = hdr->b_l2hdr.b_dev;
+		l2arc_dev_t *dev = HDR_L2_DEV(hdr);
 		boolean_t buflist_held = MUTEX_HELD(&dev->l2ad_mtx);
 
 		if (!buflist_held)
@@ -3860,6 +4811,8 @@ arc_hdr_destroy(arc_buf_hdr_t *hdr)
 
 		if (HDR_HAS_RABD(hdr))
 			arc_hdr_free_abd(hdr, B_TRUE);
+
+		arc_hdr_clear_dataset(hdr);
 	}
 
 	ASSERT3P(hdr->b_hash_next, ==, NULL);
@@ -4062,15 +5015,21 @@ arc_set_need_free(void)
 	}
 }
 
+/*
+ * Evict up to the specified number of bytes, and at most batch headers if
+ * batch is not zero, from one sublist.
+ */
 static uint64_t
 arc_evict_state_impl(multilist_t *ml, int idx, arc_buf_hdr_t *marker,
-    uint64_t spa, int64_t bytes)
+    uint64_t spa, int64_t bytes, int batch)
 {
 	multilist_sublist_t *mls;
 	uint64_t bytes_evicted = 0;
 	arc_buf_hdr_t *hdr;
 	kmutex_t *hash_lock;
 	int evict_count = 0;
+	int lfu_skip_count = 0;
+	int ds_skip_count = 0;
 
 	ASSERT3P(marker, !=, NULL);
 	IMPLY(bytes < 0, bytes == ARC_EVICT_ALL);
@@ -4080,7 +5039,7 @@ arc_evict_state_impl(multilist_t *ml, int idx, arc_buf_hdr_t *marker,
 	for (hdr = multilist_sublist_prev(mls, marker); hdr != NULL;
 	    hdr = multilist_sublist_prev(mls, marker)) {
 		if ((bytes != ARC_EVICT_ALL && bytes_evicted >= bytes) ||
-		    (evict_count >= zfs_arc_evict_batch_limit))
+		    (batch != 0 && evict_count >= batch))
 			break;
 
 		/*
@@ -4114,6 +5073,41 @@ arc_evict_state_impl(multilist_t *ml, int idx, arc_buf_hdr_t *marker,
 			continue;
 		}
 
+		/*
+		 * When the access-frequency filter is enabled, prefer to
+		 * evict rarely used buffers: pass over up to a batch worth
+		 * of frequently used ones per call, so eviction still makes
+		 * progress when nothing else is left.  Ghost headers carry
+		 * no data and are not protected.  The header's state can't
+		 * change while we hold the sublist lock.
+		 */
+		uint_t freq = 0;
+		if (arc_lfu_active() && bytes != ARC_EVICT_ALL &&
+		    !GHOST_STATE(hdr->b_l1hdr.b_state)) {
+			freq = arc_sketch_estimate(buf_hash(hdr->b_spa,
+			    &hdr->b_dva, hdr->b_birth));
+			if (freq >= zfs_arc_lfu_admit_freq &&
+			    lfu_skip_count < zfs_arc_evict_batch_limit) {
+				lfu_skip_count++;
+				ARCSTAT_BUMP(arcstat_lfu_evict_protected);
+				continue;
+			}
+		}
+
+		/*
+		 * Likewise, honor per-dataset ARC quotas and reservations
+		 * by passing over up to a batch worth of buffers which
+		 * belong to other datasets.
+		 */
+		if (bytes != ARC_EVICT_ALL &&
+		    !GHOST_STATE(hdr->b_l1hdr.b_state) &&
+		    ds_skip_count < zfs_arc_evict_batch_limit &&
+		    arc_dataset_evict_skip(hdr)) {
+			ds_skip_count++;
+			ARCSTAT_BUMP(arcstat_dataset_evict_protected);
+			continue;
+		}
+
 		hash_lock = HDR_LOCK(hdr);
 
 		/*
@@ -4138,8 +5132,11 @@ arc_evict_state_impl(multilist_t *ml, int idx, arc_buf_hdr_t *marker,
 			 * decided to skip this header, don't increment
 			 * evict_count in this case.
 			 */
-			if (evicted != 0)
+			if (evicted != 0) {
 				evict_count++;
+				if (freq == 1)
+					ARCSTAT_BUMP(arcstat_lfu_evict_onehit);
+			}
 
 		} else {
 			ARCSTAT_BUMP(arcstat_mutex_miss);
@@ -4183,7 +5180,80 @@ arc_evict_state_impl(multilist_t *ml, int idx, arc_buf_hdr_t *marker,
 	 */
 	cond_resched();
 
-	return (bytes_evicted);
+	return (bytes_evicted);
+}
+
+static void
+arc_evict_task(void *arg)
+{
+	arc_evict_arg_t *eva = arg;
+	hrtime_t start = gethrtime();
+	uint64_t evicted;
+
+	/*
+	 * A flush must reach arc_evict_state_impl() as ARC_EVICT_ALL, which
+	 * turns off the frequency and dataset reservation skips; it is
+	 * batched by header count instead.
+	 */
+	do {
+		if (eva->eva_bytes == ARC_EVICT_ALL) {
+			evicted = arc_evict_state_impl(eva->eva_ml,
+			    eva->eva_idx, eva->eva_marker, eva->eva_spa,
+			    ARC_EVICT_ALL, zfs_arc_evict_batch_limit);
+		} else {
+			evicted = arc_evict_state_impl(eva->eva_ml,
+			    eva->eva_idx, eva->eva_marker, eva->eva_spa,
+			    MIN(eva->eva_bytes - eva->eva_evicted,
+			    ARC_EVICT_TASK_MIN), 0);
+		}
+		eva->eva_evicted += evicted;
+	} while (evicted != 0 && eva->eva_evicted < eva->eva_bytes);
+
+	ARCSTAT_BUMP(arcstat_evict_parallel_tasks);
+	ARCSTAT_INCR(arcstat_evict_parallel_bytes, eva->eva_evicted);
+	ARCSTAT_INCR(arcstat_evict_parallel_time_ns, gethrtime() - start);
+}
+
+/*
+ * Evict up to the specified number of bytes from each of ntasks sublists,
+ * starting at sublist_idx, by handing one sublist to each task of the
+ * eviction taskq.  Each task works through its share in batches of
+ * ARC_EVICT_TASK_MIN bytes.  Returns the total number of bytes evicted once
+ * all of the tasks have completed.
+ */
+static uint64_t
+arc_evict_state_parallel(multilist_t *ml, arc_buf_hdr_t **markers,
+    arc_evict_arg_t *eva, int ntasks, int sublist_idx, uint64_t spa,
+    uint64_t bytes)
+{
+	int num_sublists = multilist_get_num_sublists(ml);
+	uint64_t evicted = 0;
+
+	ASSERT3P(arc_evict_taskq, !=, NULL);
+	ASSERT3S(ntasks, <=, num_sublists);
+
+	for (int i = 0; i < ntasks; i++) {
+		eva[i].eva_ml = ml;
+		eva[i].eva_idx = sublist_idx;
+		eva[i].eva_marker = markers[sublist_idx];
+		eva[i].eva_spa = spa;
+		eva[i].eva_bytes = bytes;
+		eva[i].eva_evicted = 0;
+		taskq_dispatch_ent(arc_evict_taskq, arc_evict_task, &eva[i], 0,
+		    &eva[i].eva_tqent);
+
+		if (++sublist_idx >= num_sublists)
+			sublist_idx = 0;
+	}
+
+	taskq_wait(arc_evict_taskq);
+
+	for (int i = 0; i < ntasks; i++)
+		evicted += eva[i].eva_evicted;
+
+	ARCSTAT_BUMP(arcstat_evict_parallel_scans);
+
+	return (evicted);
 }
 
 /*
@@ -4207,6 +5277,7 @@ arc_evict_state(arc_state_t *state, uint64_t spa, int64_t bytes,
 	multilist_t *ml = state->arcs_list[type];
 	int num_sublists;
 	arc_buf_hdr_t **markers;
+	arc_evict_arg_t *eva = NULL;
 
 	IMPLY(bytes < 0, bytes == ARC_EVICT_ALL);
 
@@ -4237,6 +5308,12 @@ arc_evict_state(arc_state_t *state, uint64_t spa, int64_t bytes,
 		multilist_sublist_unlock(mls);
 	}
 
+	if (arc_evict_taskq != NULL && num_sublists > 1) {
+		eva = kmem_zalloc(sizeof (*eva) * num_sublists, KM_SLEEP);
+		for (int i = 0; i < num_sublists; i++)
+			taskq_init_ent(&eva[i].eva_tqent);
+	}
+
 	/*
 	 * While we haven't hit our target number of bytes to evict, or
 	 * we're evicting all available buffers.
@@ -4244,6 +5321,7 @@ arc_evict_state(arc_state_t *state, uint64_t spa, int64_t bytes,
 	while (total_evicted < bytes || bytes == ARC_EVICT_ALL) {
 		int sublist_idx = multilist_get_random_index(ml);
 		uint64_t scan_evicted = 0;
+		int ntasks = 0;
 
 		/*
 		 * Try to reduce pinned dnodes with a floor of arc_dnode_limit.
@@ -4257,6 +5335,30 @@ arc_evict_state(arc_state_t *state, uint64_t spa, int64_t bytes,
 			    zfs_arc_dnode_reduce_percent);
 		}
 
+		/*
+		 * When there is enough left to evict, split it evenly
+		 * between the sublists and have the eviction threads work
+		 * on them in parallel.
+		 */
+		if (eva != NULL) {
+			ntasks = num_sublists;
+			if (bytes != ARC_EVICT_ALL) {
+				ntasks = MIN(ntasks, (bytes - total_evicted) /
+				    ARC_EVICT_TASK_MIN);
+			}
+		}
+		if (ntasks > 1) {
+			uint64_t share = ARC_EVICT_ALL;
+
+			if (bytes != ARC_EVICT_ALL) {
+				share = DIV_ROUND_UP(bytes - total_evicted,
+				    ntasks);
+			}
+			scan_evicted = arc_evict_state_parallel(ml, markers,
+			    eva, ntasks, sublist_idx, spa, share);
+			total_evicted += scan_evicted;
+		}
+
 		/*
 		 * Start eviction using a randomly selected sublist,
 		 * this is to try and evenly balance eviction across all
@@ -4264,7 +5366,7 @@ arc_evict_state(arc_state_t *state, uint64_t spa, int64_t bytes,
 		 * (e.g. index 0) would cause evictions to favor certain
 		 * sublists over others.
 		 */
-		for (int i = 0; i < num_sublists; i++) {
+		for (int i = 0; ntasks <= 1 && i < num_sublists; i++) {
 			uint64_t bytes_remaining;
 			uint64_t bytes_evicted;
 
@@ -4276,7 +5378,8 @@ arc_evict_state(arc_state_t *state, uint64_t spa, int64_t bytes,
 				break;
 
 			bytes_evicted = arc_evict_state_impl(ml, sublist_idx,
-			    markers[sublist_idx], spa, bytes_remaining);
+			    markers[sublist_idx], spa, bytes_remaining,
+			    zfs_arc_evict_batch_limit);
 
 			scan_evicted += bytes_evicted;
 			total_evicted += bytes_evicted;
@@ -4318,6 +5421,8 @@ arc_evict_state(arc_state_t *state, uint64_t spa, int64_t bytes,
 		kmem_cache_free(hdr_full_cache, markers[i]);
 	}
 	kmem_free(markers, sizeof (*markers) * num_sublists);
+	if (eva != NULL)
+		kmem_free(eva, sizeof (*eva) * num_sublists);
 
 	return (total_evicted);
 }
@@ -4614,6 +5719,18 @@ arc_evict(void)
 	uint64_t asize = aggsum_value(&arc_size);
 	uint64_t ameta = aggsum_value(&arc_meta_used);
 
+	arc_dataset_update_quota();
+
+	/*
+	 * Uncompressed copies of compressed buffers are the cheapest memory
+	 * to give back, so release them before evicting any cached buffers.
+	 */
+	if (asize > arc_c && arc_ucache_size != 0) {
+		total_evicted += arc_ucache_evict(asize - arc_c);
+		asize = aggsum_value(&arc_size);
+		ameta = aggsum_value(&arc_meta_used);
+	}
+
 	/*
 	 * If we're over arc_meta_limit, we want to correct that before
 	 * potentially evicting data buffers below.
@@ -4999,6 +6116,16 @@ arc_reap_cb_check(void *arg, zthr_t *zthr)
 	if (!((reap_cb_check_counter++) % 60))
 		zfs_zstd_cache_reap_now();
 
+	/*
+	 * Allocate the access-frequency sketch when the filter is first
+	 * enabled, and age it once it has seen enough accesses.  This is
+	 * also done here to avoid the need for an independent thread.
+	 */
+	if (zfs_arc_lfu_enabled) {
+		arc_sketch_alloc();
+		arc_sketch_age();
+	}
+
 	return (B_FALSE);
 }
 
@@ -5339,6 +6466,7 @@ arc_get_data_impl(arc_buf_hdr_t *hdr, uint64_t size, void *tag,
 	if (!GHOST_STATE(state)) {
 
 		(void) zfs_refcount_add_many(&state->arcs_size, size, tag);
+		arc_dataset_space(hdr, state, size);
 
 		/*
 		 * If this is reached via arc_read, the link is
@@ -5406,6 +6534,7 @@ arc_free_data_impl(arc_buf_hdr_t *hdr, uint64_t size, void *tag)
 		    size, tag);
 	}
 	(void) zfs_refcount_remove_many(&state->arcs_size, size, tag);
+	arc_dataset_space(hdr, state, -size);
 
 	VERIFY3U(hdr->b_type, ==, type);
 	if (type == ARC_BUFC_METADATA) {
@@ -5416,6 +6545,58 @@ arc_free_data_impl(arc_buf_hdr_t *hdr, uint64_t size, void *tag)
 	}
 }
 
+/*
+ * Record an access to the header in the access-frequency sketch and return
+ * the estimated number of distinct accesses to it.  Prefetches are not
+ * counted, and neither are references which arrive within ARC_MINTIME of
+ * the previous one; arc_access() uses the same window to decide whether a
+ * buffer has really been referenced again.
+ */
+static uint_t
+arc_lfu_access(arc_buf_hdr_t *hdr)
+{
+	arc_state_t *state = hdr->b_l1hdr.b_state;
+	uint64_t hash;
+
+	if (HDR_EMPTY(hdr))
+		return (0);
+
+	hash = buf_hash(hdr->b_spa, &hdr->b_dva, hdr->b_birth);
+
+	if (HDR_PREFETCH(hdr) || HDR_PRESCIENT_PREFETCH(hdr)) {
+		if (zfs_refcount_is_zero(&hdr->b_l1hdr.b_refcnt))
+			return (arc_sketch_estimate(hash));
+	} else if ((state == arc_mru || state == arc_mfu) &&
+	    !ddi_time_after(ddi_get_lbolt(),
+	    hdr->b_l1hdr.b_arc_access + ARC_MINTIME)) {
+		return (arc_sketch_estimate(hash));
+	}
+
+	return (arc_sketch_increment(hash));
+}
+
+/*
+ * Decide whether the access-frequency filter allows a buffer with the
+ * given estimated frequency to be promoted to the MFU state.  The caller
+ * passes whether the filter was active when it estimated the frequency,
+ * so that a concurrent change of the tunable cannot have an unestimated
+ * frequency rejected.
+ */
+static boolean_t
+arc_lfu_admit(boolean_t lfu, uint_t freq)
+{
+	if (!lfu)
+		return (B_TRUE);
+
+	if (freq < zfs_arc_lfu_admit_freq) {
+		ARCSTAT_BUMP(arcstat_lfu_rejected);
+		return (B_FALSE);
+	}
+
+	ARCSTAT_BUMP(arcstat_lfu_admitted);
+	return (B_TRUE);
+}
+
 /*
  * This routine is called whenever a buffer is accessed.
  * NOTE: the hash lock is dropped in this function.
@@ -5424,10 +6605,15 @@ static void
 arc_access(arc_buf_hdr_t *hdr, kmutex_t *hash_lock)
 {
 	clock_t now;
+	const boolean_t lfu = arc_lfu_active();
+	uint_t freq = 0;
 
 	ASSERT(MUTEX_HELD(hash_lock));
 	ASSERT(HDR_HAS_L1HDR(hdr));
 
+	if (lfu)
+		freq = arc_lfu_access(hdr);
+
 	if (hdr->b_l1hdr.b_state == arc_anon) {
 		/*
 		 * This buffer is not in the cache, and does not
@@ -5481,11 +6667,16 @@ arc_access(arc_buf_hdr_t *hdr, kmutex_t *hash_lock)
 			/*
 			 * More than 125ms have passed since we
 			 * instantiated this buffer.  Move it to the
-			 * most frequently used state.
+			 * most frequently used state, unless the
+			 * access-frequency filter considers it too
+			 * rarely used.
 			 */
 			hdr->b_l1hdr.b_arc_access = now;
-			DTRACE_PROBE1(new_state__mfu, arc_buf_hdr_t *, hdr);
-			arc_change_state(arc_mfu, hdr, hash_lock);
+			if (arc_lfu_admit(lfu, freq)) {
+				DTRACE_PROBE1(new_state__mfu,
+				    arc_buf_hdr_t *, hdr);
+				arc_change_state(arc_mfu, hdr, hash_lock);
+			}
 		}
 		atomic_inc_32(&hdr->b_l1hdr.b_mru_hits);
 		ARCSTAT_BUMP(arcstat_mru_hits);
@@ -5508,6 +6699,9 @@ arc_access(arc_buf_hdr_t *hdr, kmutex_t *hash_lock)
 					l2arc_hdr_arcstats_increment_state(hdr);
 			}
 			DTRACE_PROBE1(new_state__mru, arc_buf_hdr_t *, hdr);
+		} else if (!arc_lfu_admit(lfu, freq)) {
+			new_state = arc_mru;
+			DTRACE_PROBE1(new_state__mru, arc_buf_hdr_t *, hdr);
 		} else {
 			new_state = arc_mfu;
 			DTRACE_PROBE1(new_state__mfu, arc_buf_hdr_t *, hdr);
@@ -5546,22 +6740,36 @@ arc_access(arc_buf_hdr_t *hdr, kmutex_t *hash_lock)
 			 * move this block back to the MRU state.
 			 */
 			new_state = arc_mru;
+		} else if (!arc_lfu_admit(lfu, freq)) {
+			new_state = arc_mru;
 		}
 
 		hdr->b_l1hdr.b_arc_access = ddi_get_lbolt();
-		DTRACE_PROBE1(new_state__mfu, arc_buf_hdr_t *, hdr);
+		if (new_state == arc_mru) {
+			DTRACE_PROBE1(new_state__mru, arc_buf_hdr_t *, hdr);
+		} else {
+			DTRACE_PROBE1(new_state__mfu, arc_buf_hdr_t *, hdr);
+		}
 		arc_change_state(new_state, hdr, hash_lock);
 
 		atomic_inc_32(&hdr->b_l1hdr.b_mfu_ghost_hits);
 		ARCSTAT_BUMP(arcstat_mfu_ghost_hits);
 	} else if (hdr->b_l1hdr.b_state == arc_l2c_only) {
+		arc_state_t	*new_state = arc_mfu;
 		/*
 		 * This buffer is on the 2nd Level ARC.
 		 */
 
+		if (!arc_lfu_admit(lfu, freq))
+			new_state = arc_mru;
+
 		hdr->b_l1hdr.b_arc_access = ddi_get_lbolt();
-		DTRACE_PROBE1(new_state__mfu, arc_buf_hdr_t *, hdr);
-		arc_change_state(arc_mfu, hdr, hash_lock);
+		if (new_state == arc_mru) {
+			DTRACE_PROBE1(new_state__mru, arc_buf_hdr_t *, hdr);
+		} else {
+			DTRACE_PROBE1(new_state__mfu, arc_buf_hdr_t *, hdr);
+		}
+		arc_change_state(new_state, hdr, hash_lock);
 	} else {
 		cmn_err(CE_PANIC, "invalid arc state 0x%p",
 		    hdr->b_l1hdr.b_state);
@@ -5588,8 +6796,35 @@ arc_buf_access(arc_buf_t *buf)
 		return;
 	}
 
+	/*
+	 * A header in the MFU state stays there for as long as we hold
+	 * b_evict_lock: it cannot be evicted while it has a buffer, and
+	 * arc_release() must take b_evict_lock before moving it to the
+	 * anonymous state.  For such a header arc_access() only updates
+	 * the access time and hit counters, which can be done without the
+	 * hash lock; this keeps hits on hot buffers from serializing on it.
+	 */
+	if (zfs_arc_lockless_access && hdr->b_l1hdr.b_state == arc_mfu) {
+		DTRACE_PROBE1(arc__hit, arc_buf_hdr_t *, hdr);
+		if (arc_lfu_active())
+			(void) arc_lfu_access(hdr);
+		atomic_inc_32(&hdr->b_l1hdr.b_mfu_hits);
+		hdr->b_l1hdr.b_arc_access = ddi_get_lbolt();
+		arc_dataset_hit(hdr);
+		mutex_exit(&buf->b_evict_lock);
+
+		ARCSTAT_BUMP(arcstat_hits);
+		ARCSTAT_BUMP(arcstat_mfu_hits);
+		ARCSTAT_BUMP(arcstat_access_lockless);
+		ARCSTAT_LFU_BUMP(arcstat_lfu_hits);
+		ARCSTAT_CONDSTAT(!HDR_PREFETCH(hdr) &&
+		    !HDR_PRESCIENT_PREFETCH(hdr), demand, prefetch,
+		    !HDR_ISTYPE_METADATA(hdr), data, metadata, hits);
+		return;
+	}
+
 	kmutex_t *hash_lock = HDR_LOCK(hdr);
-	mutex_enter(hash_lock);
+	buf_hash_lock_enter(hash_lock);
 
 	if (hdr->b_l1hdr.b_state == arc_anon || HDR_EMPTY(hdr)) {
 		mutex_exit(hash_lock);
@@ -5605,9 +6840,11 @@ arc_buf_access(arc_buf_t *buf)
 
 	DTRACE_PROBE1(arc__hit, arc_buf_hdr_t *, hdr);
 	arc_access(hdr, hash_lock);
+	arc_dataset_hit(hdr);
 	mutex_exit(hash_lock);
 
 	ARCSTAT_BUMP(arcstat_hits);
+	ARCSTAT_LFU_BUMP(arcstat_lfu_hits);
 	ARCSTAT_CONDSTAT(!HDR_PREFETCH(hdr) && !HDR_PRESCIENT_PREFETCH(hdr),
 	    demand, prefetch, !HDR_ISTYPE_METADATA(hdr), data, metadata, hits);
 }
@@ -5907,11 +7144,14 @@ arc_read_done(zio_t *zio)
  *
  * arc_read_done() will invoke all the requested "done" functions
  * for readers of this block.
+ *
+ * Blocks read from disk are charged to the dataset ad, unless it is NULL.
  */
 int
-arc_read(zio_t *pio, spa_t *spa, const blkptr_t *bp,
+arc_read_dataset(zio_t *pio, spa_t *spa, const blkptr_t *bp,
     arc_read_done_func_t *done, void *private, zio_priority_t priority,
-    int zio_flags, arc_flags_t *arc_flags, const zbookmark_phys_t *zb)
+    int zio_flags, arc_flags_t *arc_flags, const zbookmark_phys_t *zb,
+    arc_dataset_t *ad)
 {
 	arc_buf_hdr_t *hdr = NULL;
 	kmutex_t *hash_lock = NULL;
@@ -6089,12 +7329,14 @@ top:
 		}
 		DTRACE_PROBE1(arc__hit, arc_buf_hdr_t *, hdr);
 		arc_access(hdr, hash_lock);
+		arc_dataset_hit(hdr);
 		if (*arc_flags & ARC_FLAG_PRESCIENT_PREFETCH)
 			arc_hdr_set_flags(hdr, ARC_FLAG_PRESCIENT_PREFETCH);
 		if (*arc_flags & ARC_FLAG_L2CACHE)
 			arc_hdr_set_flags(hdr, ARC_FLAG_L2CACHE);
 		mutex_exit(hash_lock);
 		ARCSTAT_BUMP(arcstat_hits);
+		ARCSTAT_LFU_BUMP(arcstat_lfu_hits);
 		ARCSTAT_CONDSTAT(!HDR_PREFETCH(hdr),
 		    demand, prefetch, !HDR_ISTYPE_METADATA(hdr),
 		    data, metadata, hits);
@@ -6140,6 +7382,7 @@ top:
 			hdr = arc_hdr_alloc(spa_load_guid(spa), psize, lsize,
 			    BP_IS_PROTECTED(bp), BP_GET_COMPRESS(bp), 0, type,
 			    encrypted_read);
+			arc_hdr_set_dataset(hdr, ad);
 
 			if (!embedded_bp) {
 				hdr->b_dva = *BP_IDENTITY(bp);
@@ -6173,6 +7416,7 @@ top:
 				    &hdr->b_l1hdr.b_refcnt));
 				ASSERT3P(hdr->b_l1hdr.b_buf, ==, NULL);
 				ASSERT3P(hdr->b_l1hdr.b_freeze_cksum, ==, NULL);
+				arc_hdr_set_dataset(hdr, ad);
 			} else if (HDR_IO_IN_PROGRESS(hdr)) {
 				/*
 				 * If this header already had an IO in progress
@@ -6261,9 +7505,9 @@ top:
 		arc_hdr_set_flags(hdr, ARC_FLAG_IO_IN_PROGRESS);
 
 		if (HDR_HAS_L2HDR(hdr) &&
-		    (vd = hdr->b_l2hdr.b_dev->l2ad_vdev) != NULL) {
-			devw = hdr->b_l2hdr.b_dev->l2ad_writing;
-			addr = hdr->b_l2hdr.b_daddr;
+		    (vd = HDR_L2_DEV(hdr)->l2ad_vdev) != NULL) {
+			devw = HDR_L2_DEV(hdr)->l2ad_writing;
+			addr = HDR_L2_DADDR(hdr);
 			/*
 			 * Lock out L2ARC device removal.
 			 */
@@ -6299,6 +7543,11 @@ top:
 			    blkptr_t *, bp, uint64_t, lsize,
 			    zbookmark_phys_t *, zb);
 			ARCSTAT_BUMP(arcstat_misses);
+			ARCSTAT_LFU_BUMP(arcstat_lfu_misses);
+			if (hdr->b_l1hdr.b_dataset != NULL) {
+				atomic_inc_64(
+				    &hdr->b_l1hdr.b_dataset->ad_misses);
+			}
 			ARCSTAT_CONDSTAT(!HDR_PREFETCH(hdr),
 			    demand, prefetch, !HDR_ISTYPE_METADATA(hdr), data,
 			    metadata, misses);
@@ -6328,7 +7577,8 @@ top:
 
 				DTRACE_PROBE1(l2arc__hit, arc_buf_hdr_t *, hdr);
 				ARCSTAT_BUMP(arcstat_l2_hits);
-				atomic_inc_32(&hdr->b_l2hdr.b_hits);
+				atomic_inc_32(&hdr->b_l1hdr.b_l2_hits);
+				l2arc_admit_stat_hit(hdr);
 
 				cb = kmem_zalloc(sizeof (l2arc_read_callback_t),
 				    KM_SLEEP);
@@ -6455,6 +7705,15 @@ out:
 	return (rc);
 }
 
+int
+arc_read(zio_t *pio, spa_t *spa, const blkptr_t *bp,
+    arc_read_done_func_t *done, void *private, zio_priority_t priority,
+    int zio_flags, arc_flags_t *arc_flags, const zbookmark_phys_t *zb)
+{
+	return (arc_read_dataset(pio, spa, bp, done, private, priority,
+	    zio_flags, arc_flags, zb, NULL));
+}
+
 arc_prune_t *
 arc_add_prune_callback(arc_prune_func_t *func, void *private)
 {
@@ -6606,7 +7865,9 @@ arc_release(arc_buf_t *buf, void *tag)
 	ASSERT3S(zfs_refcount_count(&hdr->b_l1hdr.b_refcnt), >, 0);
 
 	if (HDR_HAS_L2HDR(hdr)) {
-		mutex_enter(&hdr->b_l2hdr.b_dev->l2ad_mtx);
+		l2arc_dev_t *dev = HDR_L2_DEV(hdr);
+
+		mutex_enter(&dev->l2ad_mtx);
 
 		/*
 		 * We have to recheck this conditional again now that
@@ -6619,7 +7880,7 @@ arc_release(arc_buf_t *buf, void *tag)
 		if (HDR_HAS_L2HDR(hdr))
 			arc_hdr_l2hdr_destroy(hdr);
 
-		mutex_exit(&hdr->b_l2hdr.b_dev->l2ad_mtx);
+		mutex_exit(&dev->l2ad_mtx);
 	}
 
 	/*
@@ -6698,6 +7959,7 @@ arc_release(arc_buf_t *buf, void *tag)
 
 		(void) zfs_refcount_remove_many(&state->arcs_size,
 		    arc_buf_size(buf), buf);
+		arc_dataset_space(hdr, state, -arc_buf_size(buf));
 
 		if (zfs_refcount_is_zero(&hdr->b_l1hdr.b_refcnt)) {
 			ASSERT3P(state, !=, arc_l2c_only);
@@ -7058,7 +8320,7 @@ arc_write(zio_t *pio, spa_t *spa, uint64_t txg,
     const zio_prop_t *zp, arc_write_done_func_t *ready,
     arc_write_done_func_t *children_ready, arc_write_done_func_t *physdone,
     arc_write_done_func_t *done, void *private, zio_priority_t priority,
-    int zio_flags, const zbookmark_phys_t *zb)
+    int zio_flags, const zbookmark_phys_t *zb, arc_dataset_t *ad)
 {
 	arc_buf_hdr_t *hdr = buf->b_hdr;
 	arc_write_callback_t *callback;
@@ -7073,6 +8335,7 @@ arc_write(zio_t *pio, spa_t *spa, uint64_t txg,
 	ASSERT3U(hdr->b_l1hdr.b_bufcnt, >, 0);
 	if (l2arc)
 		arc_hdr_set_flags(hdr, ARC_FLAG_L2CACHE);
+	arc_hdr_set_dataset(hdr, ad);
 
 	if (ARC_BUF_ENCRYPTED(buf)) {
 		ASSERT(ARC_BUF_COMPRESSED(buf));
@@ -7244,6 +8507,43 @@ arc_kstat_update_state(arc_state_t *state, kstat_named_t *size,
 	    zfs_refcount_count(&state->arcs_esize[ARC_BUFC_METADATA]);
 }
 
+/*
+ * Sums up the progress of the ongoing L2ARC rebuilds: how many there are,
+ * the rate at which they restore L2ARC data, and the time until the last
+ * of them is expected to complete.
+ */
+static void
+l2arc_rebuild_kstat_update(void)
+{
+	hrtime_t now = gethrtime();
+	uint64_t active = 0, rate = 0, eta = 0;
+
+	mutex_enter(&l2arc_dev_mtx);
+	for (l2arc_dev_t *dev = list_head(l2arc_dev_list); dev != NULL;
+	    dev = list_next(l2arc_dev_list, dev)) {
+		hrtime_t start = dev->l2ad_rebuild_start;
+		uint64_t total = dev->l2ad_rebuild_lb_total;
+		uint64_t done = dev->l2ad_rebuild_lb_done;
+		uint64_t elapsed;
+
+		if (start == 0)
+			continue;
+
+		elapsed = MAX(NSEC2MSEC(now - start), 1);
+		active++;
+		rate += dev->l2ad_rebuild_asize * MILLISEC / elapsed;
+		if (done > 0 && total > done) {
+			eta = MAX(eta,
+			    (total - done) * elapsed / done / MILLISEC);
+		}
+	}
+	mutex_exit(&l2arc_dev_mtx);
+
+	ARCSTAT(arcstat_l2_rebuild_active) = active;
+	ARCSTAT(arcstat_l2_rebuild_rate) = rate;
+	ARCSTAT(arcstat_l2_rebuild_eta_secs) = eta;
+}
+
 static int
 arc_kstat_update(kstat_t *ksp, int rw)
 {
@@ -7280,6 +8580,10 @@ arc_kstat_update(kstat_t *ksp, int rw)
 		    aggsum_value(&astat_metadata_size);
 		ARCSTAT(arcstat_hdr_size) = aggsum_value(&astat_hdr_size);
 		ARCSTAT(arcstat_l2_hdr_size) = aggsum_value(&astat_l2_hdr_size);
+		ARCSTAT(arcstat_l2_hdr_bytes_per_mib) =
+		    ARCSTAT(arcstat_l2_psize) == 0 ? 0 :
+		    ARCSTAT(arcstat_l2_hdrs) * HDR_L2ONLY_SIZE * (1 << 20) /
+		    ARCSTAT(arcstat_l2_psize);
 		ARCSTAT(arcstat_dbuf_size) = aggsum_value(&astat_dbuf_size);
 #if defined(COMPAT_FREEBSD11)
 		ARCSTAT(arcstat_other_size) = aggsum_value(&astat_bonus_size) +
@@ -7290,6 +8594,7 @@ arc_kstat_update(kstat_t *ksp, int rw)
 		ARCSTAT(arcstat_bonus_size) = aggsum_value(&astat_bonus_size);
 		ARCSTAT(arcstat_abd_chunk_waste_size) =
 		    aggsum_value(&astat_abd_chunk_waste_size);
+		l2arc_rebuild_kstat_update();
 
 		as->arcstat_memory_all_bytes.value.ui64 =
 		    arc_all_memory();
@@ -7607,6 +8912,12 @@ arc_init(void)
 	mutex_init(&arc_evict_lock, NULL, MUTEX_DEFAULT, NULL);
 	list_create(&arc_evict_waiters, sizeof (arc_evict_waiter_t),
 	    offsetof(arc_evict_waiter_t, aew_node));
+	rw_init(&arc_dataset_lock, NULL, RW_DEFAULT, NULL);
+	avl_create(&arc_dataset_tree, arc_dataset_compare,
+	    sizeof (arc_dataset_t), offsetof(arc_dataset_t, ad_node));
+	mutex_init(&arc_ucache_lock, NULL, MUTEX_DEFAULT, NULL);
+	list_create(&arc_ucache_list, sizeof (arc_ucache_t),
+	    offsetof(arc_ucache_t, uc_node));
 
 	arc_min_prefetch_ms = 1000;
 	arc_min_prescient_prefetch_ms = 6000;
@@ -7666,6 +8977,26 @@ arc_init(void)
 	    boot_ncpus, INT_MAX, TASKQ_PREPOPULATE | TASKQ_DYNAMIC |
 	    TASKQ_THREADS_CPU_PCT);
 
+	/*
+	 * Small systems evict fast enough from the arc_evict thread alone;
+	 * larger ones get a thread per doubling of the CPU count plus one
+	 * for every 32 CPUs.
+	 */
+	if (zfs_arc_evict_threads > 0) {
+		arc_evict_threads = zfs_arc_evict_threads;
+	} else if (boot_ncpus < 6) {
+		arc_evict_threads = 1;
+	} else {
+		arc_evict_threads = MAX(2,
+		    highbit64(boot_ncpus) - 1 + boot_ncpus / 32);
+	}
+	if (arc_evict_threads > 1) {
+		arc_evict_taskq = taskq_create("arc_evict", arc_evict_threads,
+		    defclsyspri, arc_evict_threads, INT_MAX,
+		    TASKQ_PREPOPULATE);
+	}
+	ARCSTAT(arcstat_evict_threads) = arc_evict_threads;
+
 	arc_ksp = kstat_create("zfs", 0, "arcstats", "misc", KSTAT_TYPE_NAMED,
 	    sizeof (arc_stats) / sizeof (kstat_named_t), KSTAT_FLAG_VIRTUAL);
 
@@ -7743,8 +9074,18 @@ arc_fini(void)
 	(void) zthr_cancel(arc_evict_zthr);
 	(void) zthr_cancel(arc_reap_zthr);
 
+	if (arc_evict_taskq != NULL) {
+		taskq_destroy(arc_evict_taskq);
+		arc_evict_taskq = NULL;
+	}
+
 	mutex_destroy(&arc_evict_lock);
 	list_destroy(&arc_evict_waiters);
+	avl_destroy(&arc_dataset_tree);
+	rw_destroy(&arc_dataset_lock);
+	ASSERT0(arc_ucache_size);
+	list_destroy(&arc_ucache_list);
+	mutex_destroy(&arc_ucache_lock);
 
 	/*
 	 * Free any buffers that were tagged for destruction.  This needs
@@ -8016,6 +9357,19 @@ arc_fini(void)
  * into account when restoring buffers.
  */
 
+/*
+ * Return the l2arc_admit policy of the dataset a header is charged to.
+ * Headers which are not charged to a dataset are admitted unconditionally.
+ */
+static zfs_l2arc_admit_t
+l2arc_hdr_admit(arc_buf_hdr_t *hdr)
+{
+	if (!HDR_HAS_L1HDR(hdr) || hdr->b_l1hdr.b_dataset == NULL)
+		return (ZFS_L2ARC_ADMIT_ALL);
+
+	return (hdr->b_l1hdr.b_dataset->ad_l2arc_admit);
+}
+
 static boolean_t
 l2arc_write_eligible(uint64_t spa_guid, arc_buf_hdr_t *hdr)
 {
@@ -8025,14 +9379,102 @@ l2arc_write_eligible(uint64_t spa_guid, arc_buf_hdr_t *hdr)
 	 * 2. is already cached on the L2ARC.
 	 * 3. has an I/O in progress (it may be an incomplete read).
 	 * 4. is flagged not eligible (zfs property).
+	 * 5. is rejected by its dataset's admission policy (zfs property):
+	 *    "mfu" only admits buffers in the MFU state, "reread" also
+	 *    admits MRU buffers which have been hit at least once.
 	 */
 	if (hdr->b_spa != spa_guid || HDR_HAS_L2HDR(hdr) ||
 	    HDR_IO_IN_PROGRESS(hdr) || !HDR_L2CACHE(hdr))
 		return (B_FALSE);
 
+	switch (l2arc_hdr_admit(hdr)) {
+	case ZFS_L2ARC_ADMIT_MFU:
+		if (hdr->b_l1hdr.b_state != arc_mfu)
+			return (B_FALSE);
+		break;
+	case ZFS_L2ARC_ADMIT_REREAD:
+		if (hdr->b_l1hdr.b_state != arc_mfu &&
+		    hdr->b_l1hdr.b_mru_hits == 0 &&
+		    hdr->b_l1hdr.b_mfu_hits == 0)
+			return (B_FALSE);
+		break;
+	default:
+		break;
+	}
+
 	return (B_TRUE);
 }
 
+/*
+ * Account L2ARC writes and hits to the admission policy of the dataset
+ * the header belongs to.
+ */
+static void
+l2arc_admit_stat_write(arc_buf_hdr_t *hdr, uint64_t asize)
+{
+	switch (l2arc_hdr_admit(hdr)) {
+	case ZFS_L2ARC_ADMIT_MFU:
+		ARCSTAT_INCR(arcstat_l2_admit_mfu_write_bytes, asize);
+		break;
+	case ZFS_L2ARC_ADMIT_REREAD:
+		ARCSTAT_INCR(arcstat_l2_admit_reread_write_bytes, asize);
+		break;
+	default:
+		ARCSTAT_INCR(arcstat_l2_admit_all_write_bytes, asize);
+		break;
+	}
+}
+
+static void
+l2arc_admit_stat_hit(arc_buf_hdr_t *hdr)
+{
+	switch (l2arc_hdr_admit(hdr)) {
+	case ZFS_L2ARC_ADMIT_MFU:
+		ARCSTAT_BUMP(arcstat_l2_admit_mfu_hits);
+		break;
+	case ZFS_L2ARC_ADMIT_REREAD:
+		ARCSTAT_BUMP(arcstat_l2_admit_reread_hits);
+		break;
+	default:
+		ARCSTAT_BUMP(arcstat_l2_admit_all_hits);
+		break;
+	}
+}
+
+/*
+ * Scale the feed size to how quickly the ARC is evicting buffers which
+ * could be cached and how useful the L2ARC has been since the previous
+ * pass to this device: with no L2ARC hits half of the evicted bytes are
+ * written, with only hits all of them are.  The devices are fed in turn,
+ * so each one takes its share of what was evicted since it was last fed.
+ * While the ARC is warming up l2arc_write_boost is added on top, as for
+ * the static size.  The result is bounded by the static size.  Only
+ * called from the feed thread, which owns the device's snapshots.
+ */
+static uint64_t
+l2arc_write_size_adaptive(l2arc_dev_t *dev, uint64_t max)
+{
+	uint64_t evicted, hits, misses, delta, target;
+
+	evicted = ARCSTAT(arcstat_evict_l2_cached) +
+	    ARCSTAT(arcstat_evict_l2_eligible);
+	hits = ARCSTAT(arcstat_l2_hits) - dev->l2ad_feed_hits;
+	misses = ARCSTAT(arcstat_l2_misses) - dev->l2ad_feed_misses;
+
+	delta = (evicted - dev->l2ad_feed_evicted) / MAX(l2arc_ndev, 1);
+	target = delta / 2;
+	if (hits + misses > 0)
+		target += delta / 2 * hits / (hits + misses);
+	if (arc_warm == B_FALSE)
+		target += l2arc_write_boost;
+
+	dev->l2ad_feed_evicted = evicted;
+	dev->l2ad_feed_hits += hits;
+	dev->l2ad_feed_misses += misses;
+
+	return (MIN(MAX(target, SPA_OLD_MAXBLOCKSIZE), max));
+}
+
 static uint64_t
 l2arc_write_size(l2arc_dev_t *dev)
 {
@@ -8077,6 +9519,10 @@ l2arc_write_size(l2arc_dev_t *dev)
 			size += l2arc_write_boost;
 	}
 
+	if (l2arc_feed_adaptive)
+		size = l2arc_write_size_adaptive(dev, size);
+	ARCSTAT(arcstat_l2_feed_size) = size;
+
 	return (size);
 
 }
@@ -8842,8 +10288,8 @@ retry:
 		ASSERT(!HDR_L2_WRITING(hdr));
 		ASSERT(!HDR_L2_WRITE_HEAD(hdr));
 
-		if (!all && (hdr->b_l2hdr.b_daddr >= dev->l2ad_evict ||
-		    hdr->b_l2hdr.b_daddr < dev->l2ad_hand)) {
+		if (!all && (HDR_L2_DADDR(hdr) >= dev->l2ad_evict ||
+		    HDR_L2_DADDR(hdr) < dev->l2ad_hand)) {
 			/*
 			 * We've evicted to the target address,
 			 * or the end of the device.
@@ -9241,12 +10687,8 @@ l2arc_write_buffers(spa_t *spa, l2arc_dev_t *dev, uint64_t target_sz)
 				    ZIO_FLAG_CANFAIL);
 			}
 
-			hdr->b_l2hdr.b_dev = dev;
-			hdr->b_l2hdr.b_hits = 0;
-
-			hdr->b_l2hdr.b_daddr = dev->l2ad_hand;
-			hdr->b_l2hdr.b_arcs_state =
-			    hdr->b_l1hdr.b_state->arcs_state;
+			l2arc_hdr_set(hdr, dev, dev->l2ad_hand,
+			    hdr->b_l1hdr.b_state->arcs_state);
 			arc_hdr_set_flags(hdr, ARC_FLAG_HAS_L2HDR);
 
 			mutex_enter(&dev->l2ad_mtx);
@@ -9257,12 +10699,13 @@ l2arc_write_buffers(spa_t *spa, l2arc_dev_t *dev, uint64_t target_sz)
 			    arc_hdr_size(hdr), hdr);
 
 			wzio = zio_write_phys(pio, dev->l2ad_vdev,
-			    hdr->b_l2hdr.b_daddr, asize, to_write,
+			    HDR_L2_DADDR(hdr), asize, to_write,
 			    ZIO_CHECKSUM_OFF, NULL, hdr,
 			    ZIO_PRIORITY_ASYNC_WRITE,
 			    ZIO_FLAG_CANFAIL, B_FALSE);
 
 			write_lsize += HDR_GET_LSIZE(hdr);
+			l2arc_admit_stat_write(hdr, asize);
 			DTRACE_PROBE2(l2arc__write, vdev_t *, dev->l2ad_vdev,
 			    zio_t *, wzio);
 
@@ -9473,13 +10916,31 @@ l2arc_add_vdev(spa_t *spa, vdev_t *vd)
 {
 	l2arc_dev_t		*adddev;
 	uint64_t		l2dhdr_asize;
+	uint_t			id;
 
 	ASSERT(!l2arc_vdev_present(vd));
 
 	/*
-	 * Create a new l2arc device entry.
+	 * Create a new l2arc device entry and claim an index for it, which
+	 * the headers of its buffers use to refer to it.
 	 */
 	adddev = vmem_zalloc(sizeof (l2arc_dev_t), KM_SLEEP);
+	mutex_enter(&l2arc_dev_mtx);
+	for (id = 0; id < L2ARC_DEV_MAX; id++) {
+		if (l2arc_dev_table[id] == NULL) {
+			l2arc_dev_table[id] = adddev;
+			break;
+		}
+	}
+	mutex_exit(&l2arc_dev_mtx);
+	if (id == L2ARC_DEV_MAX) {
+		cmn_err(CE_WARN, "l2arc: cannot use more than %d cache "
+		    "devices, not adding vdev %llu", L2ARC_DEV_MAX,
+		    (u_longlong_t)vd->vdev_guid);
+		vmem_free(adddev, sizeof (l2arc_dev_t));
+		return;
+	}
+	adddev->l2ad_id = id;
 	adddev->l2ad_spa = spa;
 	adddev->l2ad_vdev = vd;
 	/* leave extra size for an l2arc device header */
@@ -9491,6 +10952,10 @@ l2arc_add_vdev(spa_t *spa, vdev_t *vd)
 	adddev->l2ad_hand = adddev->l2ad_start;
 	adddev->l2ad_evict = adddev->l2ad_start;
 	adddev->l2ad_first = B_TRUE;
+	adddev->l2ad_feed_evicted = ARCSTAT(arcstat_evict_l2_cached) +
+	    ARCSTAT(arcstat_evict_l2_eligible);
+	adddev->l2ad_feed_hits = ARCSTAT(arcstat_l2_hits);
+	adddev->l2ad_feed_misses = ARCSTAT(arcstat_l2_misses);
 	adddev->l2ad_writing = B_FALSE;
 	adddev->l2ad_trim_all = B_FALSE;
 	list_link_init(&adddev->l2ad_node);
@@ -9657,6 +11122,11 @@ l2arc_remove_vdev(vdev_t *vd)
 	zfs_refcount_destroy(&remdev->l2ad_lb_asize);
 	zfs_refcount_destroy(&remdev->l2ad_lb_count);
 	kmem_free(remdev->l2ad_dev_hdr, remdev->l2ad_dev_hdr_asize);
+
+	mutex_enter(&l2arc_dev_mtx);
+	ASSERT3P(l2arc_dev_table[remdev->l2ad_id], ==, remdev);
+	l2arc_dev_table[remdev->l2ad_id] = NULL;
+	mutex_exit(&l2arc_dev_mtx);
 	vmem_free(remdev, sizeof (l2arc_dev_t));
 }
 
@@ -9681,11 +11151,18 @@ l2arc_init(void)
 	    offsetof(l2arc_dev_t, l2ad_node));
 	list_create(l2arc_free_on_write, sizeof (l2arc_data_free_t),
 	    offsetof(l2arc_data_free_t, l2df_list_node));
+
+	l2arc_rebuild_nthreads = l2arc_rebuild_threads > 0 ?
+	    l2arc_rebuild_threads : MAX(boot_ncpus, 1);
+	l2arc_rebuild_taskq = taskq_create("l2arc_rebuild",
+	    l2arc_rebuild_nthreads, minclsyspri, 1, INT_MAX, TASKQ_DYNAMIC);
 }
 
 void
 l2arc_fini(void)
 {
+	taskq_destroy(l2arc_rebuild_taskq);
+
 	mutex_destroy(&l2arc_feed_thr_lock);
 	cv_destroy(&l2arc_feed_thr_cv);
 	mutex_destroy(&l2arc_rebuild_thr_lock);
@@ -9771,6 +11248,74 @@ l2arc_dev_rebuild_thread(void *arg)
 	thread_exit();
 }
 
+/*
+ * Restores one log block on behalf of l2arc_rebuild() and frees it.
+ */
+static void
+l2arc_rebuild_task(void *arg)
+{
+	l2arc_rebuild_task_t *lrt = arg;
+	l2arc_rebuild_ctx_t *lrc = lrt->lrt_ctx;
+
+	l2arc_log_blk_restore(lrc, lrt->lrt_lb, lrt->lrt_asize, lrt->lrt_seq);
+	vmem_free(lrt->lrt_lb, sizeof (*lrt->lrt_lb));
+	kmem_free(lrt, sizeof (*lrt));
+
+	mutex_enter(&lrc->lrc_lock);
+	lrc->lrc_done++;
+	cv_broadcast(&lrc->lrc_cv);
+	mutex_exit(&lrc->lrc_lock);
+}
+
+/*
+ * Hands a validated log block over to l2arc_rebuild_taskq, which takes
+ * ownership of it. To bound the memory held by log blocks that were read
+ * ahead, this waits while too many of them are pending for the device.
+ */
+static void
+l2arc_rebuild_dispatch(l2arc_rebuild_ctx_t *lrc, l2arc_log_blk_phys_t *lb,
+    uint64_t asize)
+{
+	l2arc_rebuild_task_t *lrt = kmem_alloc(sizeof (*lrt), KM_SLEEP);
+
+	mutex_enter(&lrc->lrc_lock);
+	while (lrc->lrc_issued - lrc->lrc_done >= 2 * l2arc_rebuild_nthreads)
+		cv_wait(&lrc->lrc_cv, &lrc->lrc_lock);
+	lrt->lrt_seq = lrc->lrc_issued++;
+	mutex_exit(&lrc->lrc_lock);
+
+	lrt->lrt_ctx = lrc;
+	lrt->lrt_lb = lb;
+	lrt->lrt_asize = asize;
+	taskq_init_ent(&lrt->lrt_tqent);
+	taskq_dispatch_ent(l2arc_rebuild_taskq, l2arc_rebuild_task, lrt, 0,
+	    &lrt->lrt_tqent);
+}
+
+/*
+ * Waits for all log blocks handed to l2arc_rebuild_taskq to be restored,
+ * then accounts for the time the rebuild took. Once this returns, the
+ * rebuild no longer references the device from any other thread.
+ */
+static void
+l2arc_rebuild_finish(l2arc_rebuild_ctx_t *lrc)
+{
+	l2arc_dev_t *dev = lrc->lrc_dev;
+
+	if (lrc->lrc_finished)
+		return;
+
+	mutex_enter(&lrc->lrc_lock);
+	while (lrc->lrc_done != lrc->lrc_issued)
+		cv_wait(&lrc->lrc_cv, &lrc->lrc_lock);
+	mutex_exit(&lrc->lrc_lock);
+
+	ARCSTAT_INCR(arcstat_l2_rebuild_time_ms,
+	    NSEC2MSEC(gethrtime() - dev->l2ad_rebuild_start));
+	dev->l2ad_rebuild_start = 0;
+	lrc->lrc_finished = B_TRUE;
+}
+
 /*
  * This function implements the actual L2ARC metadata rebuild. It:
  * starts reading the log block chain and restores each block's contents
@@ -9792,11 +11337,21 @@ l2arc_rebuild(l2arc_dev_t *dev)
 	zio_t			*this_io = NULL, *next_io = NULL;
 	l2arc_log_blkptr_t	lbps[2];
 	l2arc_lb_ptr_buf_t	*lb_ptr_buf;
+	l2arc_rebuild_ctx_t	lrc;
 	boolean_t		lock_held;
 
 	this_lb = vmem_zalloc(sizeof (*this_lb), KM_SLEEP);
 	next_lb = vmem_zalloc(sizeof (*next_lb), KM_SLEEP);
 
+	bzero(&lrc, sizeof (lrc));
+	lrc.lrc_dev = dev;
+	mutex_init(&lrc.lrc_lock, NULL, MUTEX_DEFAULT, NULL);
+	cv_init(&lrc.lrc_cv, NULL, CV_DEFAULT, NULL);
+	dev->l2ad_rebuild_lb_total = l2dhdr->dh_lb_count;
+	dev->l2ad_rebuild_lb_done = 0;
+	dev->l2ad_rebuild_asize = 0;
+	dev->l2ad_rebuild_start = gethrtime();
+
 	/*
 	 * We prevent device removal while issuing reads to the device,
 	 * then during the rebuilding phases we drop this lock again so
@@ -9861,11 +11416,14 @@ l2arc_rebuild(l2arc_dev_t *dev)
 
 		/*
 		 * Now that we know that the next_lb checks out alright, we
-		 * can start reconstruction from this log block.
+		 * can start reconstruction from this log block. This happens
+		 * asynchronously, so that we can keep fetching the chain.
 		 * L2BLK_GET_PSIZE returns aligned size for log blocks.
 		 */
 		uint64_t asize = L2BLK_GET_PSIZE((&lbps[0])->lbp_prop);
-		l2arc_log_blk_restore(dev, this_lb, asize);
+		l2arc_log_blkptr_t prev_lbp = this_lb->lb_prev_lbp;
+		l2arc_rebuild_dispatch(&lrc, this_lb, asize);
+		this_lb = vmem_zalloc(sizeof (*this_lb), KM_SLEEP);
 
 		/*
 		 * log block restored, include its pointer in the list of
@@ -9916,6 +11474,9 @@ l2arc_rebuild(l2arc_dev_t *dev)
 		for (;;) {
 			mutex_enter(&l2arc_rebuild_thr_lock);
 			if (dev->l2ad_rebuild_cancel) {
+				mutex_exit(&l2arc_rebuild_thr_lock);
+				l2arc_rebuild_finish(&lrc);
+				mutex_enter(&l2arc_rebuild_thr_lock);
 				dev->l2ad_rebuild = B_FALSE;
 				cv_signal(&l2arc_rebuild_thr_cv);
 				mutex_exit(&l2arc_rebuild_thr_lock);
@@ -9942,7 +11503,7 @@ l2arc_rebuild(l2arc_dev_t *dev)
 		 * Continue with the next log block.
 		 */
 		lbps[0] = lbps[1];
-		lbps[1] = this_lb->lb_prev_lbp;
+		lbps[1] = prev_lbp;
 		PTR_SWAP(this_lb, next_lb);
 		this_io = next_io;
 		next_io = NULL;
@@ -9956,6 +11517,14 @@ out:
 	vmem_free(this_lb, sizeof (*this_lb));
 	vmem_free(next_lb, sizeof (*next_lb));
 
+	/*
+	 * On cancellation the restore tasks have already finished, and the
+	 * device may be gone by now.
+	 */
+	l2arc_rebuild_finish(&lrc);
+	mutex_destroy(&lrc.lrc_lock);
+	cv_destroy(&lrc.lrc_cv);
+
 	if (!l2arc_rebuild_enabled) {
 		spa_history_log_internal(spa, "L2ARC rebuild", NULL,
 		    "disabled");
@@ -10181,13 +11750,19 @@ cleanup:
  * entries which only contain an l2arc hdr, essentially restoring the
  * buffers to their L2ARC evicted state. This function also updates space
  * usage on the L2ARC vdev to make sure it tracks restored buffers.
+ *
+ * Log blocks of a device may be restored concurrently, but each one's
+ * batch of buffers is linked into l2ad_buflist in the order given by `seq'.
  */
 static void
-l2arc_log_blk_restore(l2arc_dev_t *dev, const l2arc_log_blk_phys_t *lb,
-    uint64_t lb_asize)
+l2arc_log_blk_restore(l2arc_rebuild_ctx_t *lrc, const l2arc_log_blk_phys_t *lb,
+    uint64_t lb_asize, uint64_t seq)
 {
+	l2arc_dev_t	*dev = lrc->lrc_dev;
 	uint64_t	size = 0, asize = 0;
 	uint64_t	log_entries = dev->l2ad_log_entries;
+	arc_buf_hdr_t	**hdrs;
+	list_t		batch;
 
 	/*
 	 * Usually arc_adapt() is called only for data, not headers, but
@@ -10196,12 +11771,16 @@ l2arc_log_blk_restore(l2arc_dev_t *dev, const l2arc_log_blk_phys_t *lb,
 	 */
 	arc_adapt(log_entries * HDR_L2ONLY_SIZE, arc_l2c_only);
 
+	hdrs = kmem_alloc(log_entries * sizeof (arc_buf_hdr_t *), KM_SLEEP);
+	list_create(&batch, sizeof (arc_buf_hdr_t),
+	    offsetof(arc_buf_hdr_t, b_l2hdr.b_l2node));
+
 	for (int i = log_entries - 1; i >= 0; i--) {
 		/*
 		 * Restore goes in the reverse temporal direction to preserve
 		 * correct temporal ordering of buffers in the l2ad_buflist.
-		 * l2arc_hdr_restore also does a list_insert_tail instead of
-		 * list_insert_head on the l2ad_buflist:
+		 * Batches are appended to the l2ad_buflist with
+		 * list_move_tail instead of list_insert_head:
 		 *
 		 *		LIST	l2ad_buflist		LIST
 		 *		HEAD  <------ (time) ------	TAIL
@@ -10220,8 +11799,44 @@ l2arc_log_blk_restore(l2arc_dev_t *dev, const l2arc_log_blk_phys_t *lb,
 		size += L2BLK_GET_LSIZE((&lb->lb_entries[i])->le_prop);
 		asize += vdev_psize_to_asize(dev->l2ad_vdev,
 		    L2BLK_GET_PSIZE((&lb->lb_entries[i])->le_prop));
-		l2arc_hdr_restore(&lb->lb_entries[i], dev);
+		hdrs[i] = l2arc_hdr_restore_alloc(&lb->lb_entries[i], dev);
+		list_insert_tail(&batch, hdrs[i]);
+	}
+
+	/*
+	 * vdev_space_update() has to be called before arc_hdr_destroy() to
+	 * avoid underflow since the latter also calls vdev_space_update().
+	 */
+	vdev_space_update(dev->l2ad_vdev, asize, 0, 0);
+
+	/*
+	 * Wait for the log blocks which come before this one in the chain,
+	 * then link the whole batch into the buflist at once. The headers
+	 * must be on the buflist before they become visible in the hash
+	 * table.
+	 */
+	mutex_enter(&lrc->lrc_lock);
+	while (lrc->lrc_linked != seq)
+		cv_wait(&lrc->lrc_cv, &lrc->lrc_lock);
+	mutex_exit(&lrc->lrc_lock);
+
+	mutex_enter(&dev->l2ad_mtx);
+	for (int i = log_entries - 1; i >= 0; i--) {
+		(void) zfs_refcount_add_many(&dev->l2ad_alloc,
+		    arc_hdr_size(hdrs[i]), hdrs[i]);
 	}
+	list_move_tail(&dev->l2ad_buflist, &batch);
+	mutex_exit(&dev->l2ad_mtx);
+	list_destroy(&batch);
+
+	mutex_enter(&lrc->lrc_lock);
+	lrc->lrc_linked++;
+	cv_broadcast(&lrc->lrc_cv);
+	mutex_exit(&lrc->lrc_lock);
+
+	for (int i = log_entries - 1; i >= 0; i--)
+		l2arc_hdr_restore(hdrs[i], dev);
+	kmem_free(hdrs, log_entries * sizeof (arc_buf_hdr_t *));
 
 	/*
 	 * Record rebuild stats:
@@ -10234,19 +11849,20 @@ l2arc_log_blk_restore(l2arc_dev_t *dev, const l2arc_log_blk_phys_t *lb,
 	ARCSTAT_F_AVG(arcstat_l2_log_blk_avg_asize, lb_asize);
 	ARCSTAT_F_AVG(arcstat_l2_data_to_meta_ratio, asize / lb_asize);
 	ARCSTAT_BUMP(arcstat_l2_rebuild_log_blks);
+	atomic_add_64(&dev->l2ad_rebuild_asize, asize);
+	atomic_inc_64(&dev->l2ad_rebuild_lb_done);
 }
 
 /*
- * Restores a single ARC buf hdr from a log entry. The ARC buffer is put
- * into a state indicating that it has been evicted to L2ARC.
+ * Allocates the ARC buf hdr for a log entry of a log block being restored.
+ * The ARC buffer is put into a state indicating that it has been evicted to
+ * L2ARC.
  */
-static void
-l2arc_hdr_restore(const l2arc_log_ent_phys_t *le, l2arc_dev_t *dev)
+static arc_buf_hdr_t *
+l2arc_hdr_restore_alloc(const l2arc_log_ent_phys_t *le, l2arc_dev_t *dev)
 {
-	arc_buf_hdr_t		*hdr, *exists;
-	kmutex_t		*hash_lock;
+	arc_buf_hdr_t		*hdr;
 	arc_buf_contents_t	type = L2BLK_GET_TYPE((le)->le_prop);
-	uint64_t		asize;
 
 	/*
 	 * Do all the allocation before grabbing any locks, this lets us
@@ -10260,20 +11876,26 @@ l2arc_hdr_restore(const l2arc_log_ent_phys_t *le, l2arc_dev_t *dev)
 	    L2BLK_GET_PROTECTED((le)->le_prop),
 	    L2BLK_GET_PREFETCH((le)->le_prop),
 	    L2BLK_GET_STATE((le)->le_prop));
-	asize = vdev_psize_to_asize(dev->l2ad_vdev,
-	    L2BLK_GET_PSIZE((le)->le_prop));
-
-	/*
-	 * vdev_space_update() has to be called before arc_hdr_destroy() to
-	 * avoid underflow since the latter also calls vdev_space_update().
-	 */
 	l2arc_hdr_arcstats_increment(hdr);
-	vdev_space_update(dev->l2ad_vdev, asize, 0, 0);
 
-	mutex_enter(&dev->l2ad_mtx);
-	list_insert_tail(&dev->l2ad_buflist, hdr);
-	(void) zfs_refcount_add_many(&dev->l2ad_alloc, arc_hdr_size(hdr), hdr);
-	mutex_exit(&dev->l2ad_mtx);
+	return (hdr);
+}
+
+/*
+ * Inserts a restored ARC buf hdr, which is already on the l2ad_buflist,
+ * into the hash table. If the buffer is cached already, the restored hdr
+ * is dropped instead.
+ */
+static void
+l2arc_hdr_restore(arc_buf_hdr_t *hdr, l2arc_dev_t *dev)
+{
+	arc_buf_hdr_t		*exists;
+	kmutex_t		*hash_lock;
+	uint64_t		daddr = HDR_L2_DADDR(hdr);
+	arc_state_type_t	arcs_state = HDR_L2_STATE(hdr);
+	uint64_t		asize;
+
+	asize = vdev_psize_to_asize(dev->l2ad_vdev, HDR_GET_PSIZE(hdr));
 
 	exists = buf_hash_insert(hdr, &hash_lock);
 	if (exists) {
@@ -10287,10 +11909,7 @@ l2arc_hdr_restore(const l2arc_log_ent_phys_t *le, l2arc_dev_t *dev)
 		 */
 		if (!HDR_HAS_L2HDR(exists)) {
 			arc_hdr_set_flags(exists, ARC_FLAG_HAS_L2HDR);
-			exists->b_l2hdr.b_dev = dev;
-			exists->b_l2hdr.b_daddr = le->le_daddr;
-			exists->b_l2hdr.b_arcs_state =
-			    L2BLK_GET_STATE((le)->le_prop);
+			l2arc_hdr_set(exists, dev, daddr, arcs_state);
 			mutex_enter(&dev->l2ad_mtx);
 			list_insert_tail(&dev->l2ad_buflist, exists);
 			(void) zfs_refcount_add_many(&dev->l2ad_alloc,
@@ -10583,7 +12202,7 @@ l2arc_log_blk_insert(l2arc_dev_t *dev, const arc_buf_hdr_t *hdr)
 	bzero(le, sizeof (*le));
 	le->le_dva = hdr->b_dva;
 	le->le_birth = hdr->b_birth;
-	le->le_daddr = hdr->b_l2hdr.b_daddr;
+	le->le_daddr = HDR_L2_DADDR(hdr);
 	if (index == 0)
 		dev->l2ad_log_blk_payload_start = le->le_daddr;
 	L2BLK_SET_LSIZE((le)->le_prop, HDR_GET_LSIZE(hdr));
@@ -10644,6 +12263,7 @@ l2arc_range_check_overlap(uint64_t bottom, uint64_t top, uint64_t check)
 EXPORT_SYMBOL(arc_buf_size);
 EXPORT_SYMBOL(arc_write);
 EXPORT_SYMBOL(arc_read);
+EXPORT_SYMBOL(arc_read_dataset);
 EXPORT_SYMBOL(arc_buf_info);
 EXPORT_SYMBOL(arc_getbuf_func);
 EXPORT_SYMBOL(arc_add_prune_callback);
@@ -10742,6 +12362,12 @@ ZFS_MODULE_PARAM(zfs_l2arc, l2arc_, rebuild_enabled, INT, ZMOD_RW,
 ZFS_MODULE_PARAM(zfs_l2arc, l2arc_, rebuild_blocks_min_l2size, ULONG, ZMOD_RW,
 	"Min size in bytes to write rebuild log blocks in L2ARC");
 
+ZFS_MODULE_PARAM(zfs_l2arc, l2arc_, rebuild_threads, INT, ZMOD_RD,
+	"Number of threads restoring log blocks during L2ARC rebuild");
+
+ZFS_MODULE_PARAM(zfs_l2arc, l2arc_, feed_adaptive, INT, ZMOD_RW,
+	"Scale the L2ARC feed size to the ARC eviction rate and hit ratio");
+
 ZFS_MODULE_PARAM(zfs_l2arc, l2arc_, mfuonly, INT, ZMOD_RW,
 	"Cache only MFU data from ARC into L2ARC");
 
@@ -10766,4 +12392,22 @@ ZFS_MODULE_PARAM(zfs_arc, zfs_arc_, eviction_pct, INT, ZMOD_RW,
 
 ZFS_MODULE_PARAM(zfs_arc, zfs_arc_, evict_batch_limit, INT, ZMOD_RW,
 	"The number of headers to evict per sublist before moving to the next");
+
+ZFS_MODULE_PARAM(zfs_arc, zfs_arc_, lfu_enabled, INT, ZMOD_RW,
+	"Use an access-frequency filter to protect frequently used buffers");
+
+ZFS_MODULE_PARAM(zfs_arc, zfs_arc_, lfu_admit_freq, UINT, ZMOD_RW,
+	"Min estimated accesses before a buffer may be promoted to the MFU");
+
+ZFS_MODULE_PARAM(zfs_arc, zfs_arc_, lockless_access, INT, ZMOD_RW,
+	"Account dbuf hits on MFU buffers without taking the hash lock");
+
+ZFS_MODULE_PARAM(zfs_arc, zfs_arc_, evict_threads, INT, ZMOD_RD,
+	"Number of threads evicting ARC sublists in parallel (0 = auto)");
+
+ZFS_MODULE_PARAM(zfs_arc, zfs_arc_, ucache_hits, INT, ZMOD_RW,
+	"Decompressions before an uncompressed copy of a buffer is kept");
+
+ZFS_MODULE_PARAM(zfs_arc, zfs_arc_, ucache_percent, INT, ZMOD_RW,
+	"Limit on uncompressed copies of buffers as a percent of arc_c");
 /* END CSTYLED */
@@ -37,6 +37,11 @@ static dataset_kstat_values_t empty_dataset_kstats = {
 	{ "nread",	KSTAT_DATA_UINT64 },
 	{ "nunlinks",	KSTAT_DATA_UINT64 },
 	{ "nunlinked",	KSTAT_DATA_UINT64 },
+	{ "arc_size",	KSTAT_DATA_UINT64 },
+	{ "arc_hits",	KSTAT_DATA_UINT64 },
+	{ "arc_misses",	KSTAT_DATA_UINT64 },
+	{ "prefetch_streams",	KSTAT_DATA_UINT64 },
+	{ "prefetch_distance",	KSTAT_DATA_UINT64 },
 };
 
 static int
@@ -61,6 +66,11 @@ dataset_kstats_update(kstat_t *ksp, int rw)
 	    aggsum_value(&dk->dk_aggsums.das_nunlinks);
 	dkv->dkv_nunlinked.value.ui64 =
 	    aggsum_value(&dk->dk_aggsums.das_nunlinked);
+	arc_dataset_stats(dk->dk_arc_dataset, &dkv->dkv_arc_size.value.ui64,
+	    &dkv->dkv_arc_hits.value.ui64, &dkv->dkv_arc_misses.value.ui64);
+	arc_dataset_prefetch_stats(dk->dk_arc_dataset,
+	    &dkv->dkv_prefetch_streams.value.ui64,
+	    &dkv->dkv_prefetch_distance.value.ui64);
 
 	return (0);
 }
@@ -146,6 +156,9 @@ dataset_kstats_create(dataset_kstats_t *dk, objset_t *objset)
 	aggsum_init(&dk->dk_aggsums.das_nread, 0);
 	aggsum_init(&dk->dk_aggsums.das_nunlinks, 0);
 	aggsum_init(&dk->dk_aggsums.das_nunlinked, 0);
+
+	dk->dk_arc_dataset = arc_dataset_register(dmu_objset_spa(objset),
+	    dmu_objset_id(objset));
 }
 
 void
@@ -162,6 +175,9 @@ dataset_kstats_destroy(dataset_kstats_t *dk)
 	kstat_delete(dk->dk_kstats);
 	dk->dk_kstats = NULL;
 
+	arc_dataset_unregister(dk->dk_arc_dataset);
+	dk->dk_arc_dataset = NULL;
+
 	aggsum_fini(&dk->dk_aggsums.das_writes);
 	aggsum_fini(&dk->dk_aggsums.das_nwritten);
 	aggsum_fini(&dk->dk_aggsums.das_reads);
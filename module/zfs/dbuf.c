@@ -97,6 +97,18 @@ typedef struct dbuf_stats {
 	 * already created and in the dbuf hash table.
 	 */
 	kstat_named_t hash_insert_race;
+	/*
+	 * Number of hash table locks, the number of times one was found
+	 * held in a conflicting mode, and the time spent waiting for them.
+	 */
+	kstat_named_t hash_locks;
+	kstat_named_t hash_lock_contended;
+	kstat_named_t hash_lock_wait_ns;
+	/*
+	 * Number of holds taken on already held dbufs without db_mtx, see
+	 * dbuf_find_held().
+	 */
+	kstat_named_t hash_hits_lockless;
 	/*
 	 * Statistics about the size of the metadata dbuf cache.
 	 */
@@ -109,6 +121,14 @@ typedef struct dbuf_stats {
 	 * the data in the regular dbuf cache.
 	 */
 	kstat_named_t metadata_cache_overflow;
+	/*
+	 * Partial overwrites of uncached blocks which did not read the
+	 * block, and how many of those were later filled in from the old
+	 * block or overwritten in full before that was needed.
+	 */
+	kstat_named_t partial_deferred;
+	kstat_named_t partial_filled;
+	kstat_named_t partial_overwritten;
 } dbuf_stats_t;
 
 dbuf_stats_t dbuf_stats = {
@@ -129,10 +149,17 @@ dbuf_stats_t dbuf_stats = {
 	{ "hash_chains",			KSTAT_DATA_UINT64 },
 	{ "hash_chain_max",			KSTAT_DATA_UINT64 },
 	{ "hash_insert_race",			KSTAT_DATA_UINT64 },
+	{ "hash_locks",				KSTAT_DATA_UINT64 },
+	{ "hash_lock_contended",		KSTAT_DATA_UINT64 },
+	{ "hash_lock_wait_ns",			KSTAT_DATA_UINT64 },
+	{ "hash_hits_lockless",			KSTAT_DATA_UINT64 },
 	{ "metadata_cache_count",		KSTAT_DATA_UINT64 },
 	{ "metadata_cache_size_bytes",		KSTAT_DATA_UINT64 },
 	{ "metadata_cache_size_bytes_max",	KSTAT_DATA_UINT64 },
-	{ "metadata_cache_overflow",		KSTAT_DATA_UINT64 }
+	{ "metadata_cache_overflow",		KSTAT_DATA_UINT64 },
+	{ "partial_deferred",			KSTAT_DATA_UINT64 },
+	{ "partial_filled",			KSTAT_DATA_UINT64 },
+	{ "partial_overwritten",		KSTAT_DATA_UINT64 }
 };
 
 #define	DBUF_STAT_INCR(stat, val)	\
@@ -154,6 +181,7 @@ static boolean_t dbuf_undirty(dmu_buf_impl_t *db, dmu_tx_t *tx);
 static void dbuf_write(dbuf_dirty_record_t *dr, arc_buf_t *data, dmu_tx_t *tx);
 static void dbuf_sync_leaf_verify_bonus_dnode(dbuf_dirty_record_t *dr);
 static int dbuf_read_verify_dnode_crypt(dmu_buf_impl_t *db, uint32_t flags);
+static void dbuf_hold_locked(dnode_t *dn, dmu_buf_impl_t *db, void *tag);
 
 extern inline void dmu_buf_init_user(dmu_buf_user_t *dbu,
     dmu_buf_evict_func_t *evict_func_sync,
@@ -264,6 +292,19 @@ static unsigned long dbuf_metadata_cache_target_bytes(void);
 uint_t dbuf_cache_hiwater_pct = 10;
 uint_t dbuf_cache_lowater_pct = 10;
 
+/*
+ * When set, dbuf_hold_impl() takes holds on cached dbufs which are already
+ * held without taking db_mtx.
+ */
+int dbuf_lockless_hold = 1;
+
+/*
+ * Partial overwrites of uncached level-0 blocks of at least this size
+ * do not read the block first (see dmu_buf_will_dirty_range()).  Zero
+ * disables this.
+ */
+unsigned long dbuf_deferred_fill_min_size = SPA_OLD_MAXBLOCKSIZE;
+
 /* ARGSUSED */
 static int
 dbuf_cons(void *vdb, void *unused, int kmflag)
@@ -319,6 +360,25 @@ dbuf_hash(void *os, uint64_t obj, uint8_t lvl, uint64_t blkid)
 	(dbuf)->db_level == (level) &&			\
 	(dbuf)->db_blkid == (blkid))
 
+/*
+ * Acquire a hash table lock, accounting for the time spent waiting when it
+ * is held in a conflicting mode.  The uncontended case costs no more than
+ * a plain rw_enter().
+ */
+static inline void
+dbuf_hash_lock_enter(krwlock_t *lock, krw_t rw)
+{
+	hrtime_t start;
+
+	if (rw_tryenter(lock, rw))
+		return;
+
+	start = gethrtime();
+	rw_enter(lock, rw);
+	DBUF_STAT_BUMP(hash_lock_contended);
+	DBUF_STAT_INCR(hash_lock_wait_ns, gethrtime() - start);
+}
+
 dmu_buf_impl_t *
 dbuf_find(objset_t *os, uint64_t obj, uint8_t level, uint64_t blkid)
 {
@@ -330,21 +390,76 @@ dbuf_find(objset_t *os, uint64_t obj, uint8_t level, uint64_t blkid)
 	hv = dbuf_hash(os, obj, level, blkid);
 	idx = hv & h->hash_table_mask;
 
-	mutex_enter(DBUF_HASH_MUTEX(h, idx));
+	dbuf_hash_lock_enter(DBUF_HASH_RWLOCK(h, idx), RW_READER);
 	for (db = h->hash_table[idx]; db != NULL; db = db->db_hash_next) {
 		if (DBUF_EQUAL(db, os, obj, level, blkid)) {
 			mutex_enter(&db->db_mtx);
 			if (db->db_state != DB_EVICTING) {
-				mutex_exit(DBUF_HASH_MUTEX(h, idx));
+				rw_exit(DBUF_HASH_RWLOCK(h, idx));
 				return (db);
 			}
 			mutex_exit(&db->db_mtx);
 		}
 	}
-	mutex_exit(DBUF_HASH_MUTEX(h, idx));
+	rw_exit(DBUF_HASH_RWLOCK(h, idx));
 	return (NULL);
 }
 
+/*
+ * Look up a cached dbuf that is already held and add a hold on it before
+ * taking db_mtx.  Holds only go from zero to non-zero under db_mtx (in
+ * dbuf_hold_impl(), where the dbuf is also taken off the dbuf caches), so
+ * a dbuf found with a non-zero hold count is neither cached for eviction
+ * nor being evicted, and the hash table lock keeps it from being freed
+ * while we look at it.  Dbufs held only by their dirty records and dbufs
+ * which are being synced are left to the regular path, as holding those
+ * may require db_mtx (see dbuf_fix_old_data() and dbuf_hold_copy()).
+ *
+ * The checks made before the hold is added race with state changes made
+ * under db_mtx, so once the dbuf is held they are made again under db_mtx,
+ * which is also needed to call arc_buf_access() like the regular path.  If
+ * they no longer pass, the hold is released again.  The hash table lock
+ * is dropped first, so that it is never held across waiting for db_mtx.
+ *
+ * Returns NULL if the dbuf must be held the regular way.
+ */
+static dmu_buf_impl_t *
+dbuf_find_held(objset_t *os, uint64_t obj, uint8_t level, uint64_t blkid,
+    void *tag)
+{
+	dbuf_hash_table_t *h = &dbuf_hash_table;
+	uint64_t idx = dbuf_hash(os, obj, level, blkid) & h->hash_table_mask;
+	dmu_buf_impl_t *db;
+
+	dbuf_hash_lock_enter(DBUF_HASH_RWLOCK(h, idx), RW_READER);
+	for (db = h->hash_table[idx]; db != NULL; db = db->db_hash_next) {
+		if (DBUF_EQUAL(db, os, obj, level, blkid) &&
+		    db->db_state != DB_EVICTING)
+			break;
+	}
+	if (db != NULL && (db->db_state != DB_CACHED ||
+	    db->db_data_pending != NULL ||
+	    zfs_refcount_count(&db->db_holds) <= db->db_dirtycnt ||
+	    !zfs_refcount_add_if_nonzero(&db->db_holds, tag)))
+		db = NULL;
+	rw_exit(DBUF_HASH_RWLOCK(h, idx));
+
+	if (db == NULL)
+		return (NULL);
+
+	mutex_enter(&db->db_mtx);
+	if (db->db_state != DB_CACHED || db->db_data_pending != NULL ||
+	    zfs_refcount_count(&db->db_holds) <= db->db_dirtycnt + 1) {
+		dbuf_rele_and_unlock(db, tag, B_FALSE);
+		return (NULL);
+	}
+	if (db->db_buf != NULL)
+		arc_buf_access(db->db_buf);
+	mutex_exit(&db->db_mtx);
+
+	return (db);
+}
+
 static dmu_buf_impl_t *
 dbuf_find_bonus(objset_t *os, uint64_t object)
 {
@@ -384,13 +499,13 @@ dbuf_hash_insert(dmu_buf_impl_t *db)
 	hv = dbuf_hash(os, obj, level, blkid);
 	idx = hv & h->hash_table_mask;
 
-	mutex_enter(DBUF_HASH_MUTEX(h, idx));
+	dbuf_hash_lock_enter(DBUF_HASH_RWLOCK(h, idx), RW_WRITER);
 	for (dbf = h->hash_table[idx], i = 0; dbf != NULL;
 	    dbf = dbf->db_hash_next, i++) {
 		if (DBUF_EQUAL(dbf, os, obj, level, blkid)) {
 			mutex_enter(&dbf->db_mtx);
 			if (dbf->db_state != DB_EVICTING) {
-				mutex_exit(DBUF_HASH_MUTEX(h, idx));
+				rw_exit(DBUF_HASH_RWLOCK(h, idx));
 				return (dbf);
 			}
 			mutex_exit(&dbf->db_mtx);
@@ -408,7 +523,7 @@ dbuf_hash_insert(dmu_buf_impl_t *db)
 	mutex_enter(&db->db_mtx);
 	db->db_hash_next = h->hash_table[idx];
 	h->hash_table[idx] = db;
-	mutex_exit(DBUF_HASH_MUTEX(h, idx));
+	rw_exit(DBUF_HASH_RWLOCK(h, idx));
 	atomic_inc_64(&dbuf_hash_count);
 	DBUF_STAT_MAX(hash_elements_max, dbuf_hash_count);
 
@@ -465,13 +580,13 @@ dbuf_hash_remove(dmu_buf_impl_t *db)
 
 	/*
 	 * We mustn't hold db_mtx to maintain lock ordering:
-	 * DBUF_HASH_MUTEX > db_mtx.
+	 * DBUF_HASH_RWLOCK > db_mtx.
 	 */
 	ASSERT(zfs_refcount_is_zero(&db->db_holds));
 	ASSERT(db->db_state == DB_EVICTING);
 	ASSERT(!MUTEX_HELD(&db->db_mtx));
 
-	mutex_enter(DBUF_HASH_MUTEX(h, idx));
+	dbuf_hash_lock_enter(DBUF_HASH_RWLOCK(h, idx), RW_WRITER);
 	dbp = &h->hash_table[idx];
 	while ((dbf = *dbp) != db) {
 		dbp = &dbf->db_hash_next;
@@ -482,7 +597,7 @@ dbuf_hash_remove(dmu_buf_impl_t *db)
 	if (h->hash_table[idx] &&
 	    h->hash_table[idx]->db_hash_next == NULL)
 		DBUF_STAT_BUMPDOWN(hash_chains);
-	mutex_exit(DBUF_HASH_MUTEX(h, idx));
+	rw_exit(DBUF_HASH_RWLOCK(h, idx));
 	atomic_dec_64(&dbuf_hash_count);
 }
 
@@ -788,6 +903,7 @@ dbuf_init(void)
 {
 	uint64_t hsize = 1ULL << 16;
 	dbuf_hash_table_t *h = &dbuf_hash_table;
+	uint64_t nlocks;
 	int i;
 
 	/*
@@ -821,8 +937,15 @@ retry:
 	    sizeof (dmu_buf_impl_t),
 	    0, dbuf_cons, dbuf_dest, NULL, NULL, NULL, 0);
 
-	for (i = 0; i < DBUF_MUTEXES; i++)
-		mutex_init(&h->hash_mutexes[i], NULL, MUTEX_DEFAULT, NULL);
+	nlocks = MAX(DBUF_RWLOCKS, boot_ncpus * DBUF_RWLOCKS_PER_CPU);
+	if (!ISP2(nlocks))
+		nlocks = 1ULL << highbit64(nlocks);
+	nlocks = MIN(nlocks, hsize);
+	h->hash_rwlock_mask = nlocks - 1;
+	h->hash_rwlocks = vmem_zalloc(nlocks * sizeof (krwlock_t), KM_SLEEP);
+	for (i = 0; i < nlocks; i++)
+		rw_init(&h->hash_rwlocks[i], NULL, RW_DEFAULT, NULL);
+	dbuf_stats.hash_locks.value.ui64 = nlocks;
 
 	dbuf_stats_init(h);
 
@@ -874,8 +997,10 @@ dbuf_fini(void)
 
 	dbuf_stats_destroy();
 
-	for (i = 0; i < DBUF_MUTEXES; i++)
-		mutex_destroy(&h->hash_mutexes[i]);
+	for (i = 0; i <= h->hash_rwlock_mask; i++)
+		rw_destroy(&h->hash_rwlocks[i]);
+	vmem_free(h->hash_rwlocks,
+	    (h->hash_rwlock_mask + 1) * sizeof (krwlock_t));
 #if defined(_KERNEL)
 	/*
 	 * Large allocations which do not require contiguous pages
@@ -1521,9 +1646,9 @@ dbuf_read_impl(dmu_buf_impl_t *db, zio_t *zio, uint32_t flags,
 	 */
 	blkptr_t bp = *db->db_blkptr;
 	dmu_buf_unlock_parent(db, dblt, tag);
-	(void) arc_read(zio, db->db_objset->os_spa, &bp,
+	(void) arc_read_dataset(zio, db->db_objset->os_spa, &bp,
 	    dbuf_read_done, db, ZIO_PRIORITY_SYNC_READ, zio_flags,
-	    &aflags, &zb);
+	    &aflags, &zb, db->db_objset->os_arc_dataset);
 	return (err);
 early_unlock:
 	DB_DNODE_EXIT(db);
@@ -1584,6 +1709,261 @@ dbuf_fix_old_data(dmu_buf_impl_t *db, uint64_t txg)
 	}
 }
 
+/*
+ * Return the dirty record whose data is the current buffer of this dbuf,
+ * if that buffer was partially overwritten and has not been filled in.
+ */
+static dbuf_dirty_record_t *
+dbuf_partial_head(dmu_buf_impl_t *db)
+{
+	dbuf_dirty_record_t *dr;
+
+	ASSERT(MUTEX_HELD(&db->db_mtx));
+
+	if (db->db_level != 0 || db->db_blkid == DMU_BONUS_BLKID)
+		return (NULL);
+
+	dr = list_head(&db->db_dirty_records);
+	if (dr == NULL || dr->dt.dl.dr_partial == NULL ||
+	    dr->dt.dl.dr_data != db->db_buf)
+		return (NULL);
+
+	return (dr);
+}
+
+void
+dbuf_partial_discard(dbuf_dirty_record_t *dr)
+{
+	if (dr->dt.dl.dr_partial != NULL) {
+		range_tree_vacate(dr->dt.dl.dr_partial, NULL, NULL);
+		range_tree_destroy(dr->dt.dl.dr_partial);
+		dr->dt.dl.dr_partial = NULL;
+	}
+}
+
+typedef struct dbuf_partial_arg {
+	const uint8_t *dpa_src;
+	uint8_t *dpa_dst;
+	uint64_t dpa_off;
+} dbuf_partial_arg_t;
+
+/*
+ * range_tree_walk() callback which copies the old data in front of each
+ * valid range.  A NULL source is a hole.
+ */
+static void
+dbuf_partial_fill_gap(void *arg, uint64_t start, uint64_t size)
+{
+	dbuf_partial_arg_t *dpa = arg;
+
+	ASSERT3U(start, >=, dpa->dpa_off);
+	if (start > dpa->dpa_off) {
+		if (dpa->dpa_src != NULL) {
+			bcopy(dpa->dpa_src + dpa->dpa_off,
+			    dpa->dpa_dst + dpa->dpa_off, start - dpa->dpa_off);
+		} else {
+			bzero(dpa->dpa_dst + dpa->dpa_off,
+			    start - dpa->dpa_off);
+		}
+	}
+	dpa->dpa_off = start + size;
+}
+
+/*
+ * Complete the partially overwritten dirty record of the given txg, if
+ * there is one, by copying the bytes outside of its valid ranges from the
+ * previous version of the block.  Any earlier dirty record of the dbuf
+ * was partial too when this one was created, and its ranges are included
+ * in this one, so the block db_blkptr points to has the right contents
+ * whether or not those records have synced.  Called and returns with
+ * db_mtx held; the mutex is dropped while the block is read.
+ */
+int
+dbuf_partial_fill(dmu_buf_impl_t *db, uint64_t txg, enum zio_flag flags)
+{
+	dbuf_dirty_record_t *dr;
+	dbuf_partial_arg_t dpa;
+	arc_flags_t aflags = ARC_FLAG_WAIT;
+	arc_buf_t *abuf = NULL;
+	zbookmark_phys_t zb;
+	db_lock_type_t dblt;
+	blkptr_t bp;
+	int err = 0;
+
+	ASSERT(MUTEX_HELD(&db->db_mtx));
+	ASSERT0(db->db_level);
+
+	while (db->db_partial_filling)
+		cv_wait(&db->db_changed, &db->db_mtx);
+
+	dr = dbuf_find_dirty_eq(db, txg);
+	if (dr == NULL || dr->dt.dl.dr_partial == NULL)
+		return (0);
+
+	dblt = dmu_buf_lock_parent(db, RW_READER, FTAG);
+	if (db->db_blkptr != NULL)
+		bp = *db->db_blkptr;
+	else
+		BP_ZERO(&bp);
+	dmu_buf_unlock_parent(db, dblt, FTAG);
+
+	db->db_partial_filling = B_TRUE;
+	mutex_exit(&db->db_mtx);
+
+	if (!BP_IS_HOLE(&bp)) {
+		SET_BOOKMARK(&zb, dmu_objset_id(db->db_objset),
+		    db->db.db_object, db->db_level, db->db_blkid);
+		err = arc_read_dataset(NULL, dmu_objset_spa(db->db_objset),
+		    &bp, arc_getbuf_func, &abuf, ZIO_PRIORITY_SYNC_READ, flags,
+		    &aflags, &zb, db->db_objset->os_arc_dataset);
+		if (err == 0 && abuf == NULL)
+			err = SET_ERROR(EIO);
+		ASSERT(err != 0 ||
+		    arc_buf_lsize(abuf) == db->db.db_size);
+	}
+
+	mutex_enter(&db->db_mtx);
+	if (err == 0) {
+		dpa.dpa_src = (abuf != NULL) ? abuf->b_data : NULL;
+		dpa.dpa_dst = dr->dt.dl.dr_data->b_data;
+		dpa.dpa_off = 0;
+		range_tree_walk(dr->dt.dl.dr_partial, dbuf_partial_fill_gap,
+		    &dpa);
+		dbuf_partial_fill_gap(&dpa, db->db.db_size, 0);
+		dbuf_partial_discard(dr);
+		DBUF_STAT_BUMP(partial_filled);
+	}
+	db->db_partial_filling = B_FALSE;
+	cv_broadcast(&db->db_changed);
+
+	if (abuf != NULL)
+		arc_buf_destroy(abuf, &abuf);
+
+	return (err);
+}
+
+/*
+ * Start reading the previous version of a partially overwritten block
+ * which is about to be synced, so that its dbuf_partial_fill() in
+ * dbuf_sync_leaf() does not wait for the disk.
+ */
+static void
+dbuf_partial_prefetch(dbuf_dirty_record_t *dr)
+{
+	dmu_buf_impl_t *db = dr->dr_dbuf;
+	arc_flags_t aflags = ARC_FLAG_NOWAIT | ARC_FLAG_PREFETCH |
+	    ARC_FLAG_NO_BUF;
+	zbookmark_phys_t zb;
+	db_lock_type_t dblt;
+	blkptr_t bp;
+
+	mutex_enter(&db->db_mtx);
+	if (db->db_partial_filling || dr->dt.dl.dr_partial == NULL ||
+	    db->db_blkptr == NULL) {
+		mutex_exit(&db->db_mtx);
+		return;
+	}
+	dblt = dmu_buf_lock_parent(db, RW_READER, FTAG);
+	bp = *db->db_blkptr;
+	dmu_buf_unlock_parent(db, dblt, FTAG);
+	mutex_exit(&db->db_mtx);
+
+	if (BP_IS_HOLE(&bp))
+		return;
+
+	SET_BOOKMARK(&zb, dmu_objset_id(db->db_objset), db->db.db_object,
+	    db->db_level, db->db_blkid);
+	(void) arc_read_dataset(NULL, dmu_objset_spa(db->db_objset), &bp,
+	    NULL, NULL, ZIO_PRIORITY_ASYNC_READ,
+	    ZIO_FLAG_CANFAIL | ZIO_FLAG_SPECULATIVE, &aflags, &zb,
+	    db->db_objset->os_arc_dataset);
+}
+
+/*
+ * Return the newest dirty record of this dbuf if its block was written by
+ * dmu_write_direct() and the dbuf has not been read or refilled since.
+ */
+static dbuf_dirty_record_t *
+dbuf_direct_head(dmu_buf_impl_t *db)
+{
+	dbuf_dirty_record_t *dr;
+
+	ASSERT(MUTEX_HELD(&db->db_mtx));
+
+	if (db->db_state != DB_NOFILL || db->db_level != 0 ||
+	    db->db_blkid == DMU_BONUS_BLKID)
+		return (NULL);
+
+	dr = list_head(&db->db_dirty_records);
+	if (dr == NULL || !dr->dt.dl.dr_direct)
+		return (NULL);
+
+	return (dr);
+}
+
+/*
+ * Read the block of a dirty record written by dmu_write_direct() back in,
+ * making it the data of the dbuf and of the record.  If the record was
+ * synced out while the mutex was dropped, the dbuf is left to be read
+ * from disk as usual.  Called and returns with db_mtx held.
+ */
+static int
+dbuf_read_direct(dmu_buf_impl_t *db, uint32_t flags)
+{
+	dbuf_dirty_record_t *dr;
+	zbookmark_phys_t zb;
+	arc_buf_t *buf;
+	uint64_t txg;
+	blkptr_t bp;
+	int err = 0;
+
+	ASSERT(MUTEX_HELD(&db->db_mtx));
+
+	while (db->db_partial_filling)
+		cv_wait(&db->db_changed, &db->db_mtx);
+
+	dr = dbuf_direct_head(db);
+	if (dr == NULL)
+		return (0);
+
+	bp = dr->dt.dl.dr_overridden_by;
+	txg = dr->dr_txg;
+	db->db_partial_filling = B_TRUE;
+	mutex_exit(&db->db_mtx);
+
+	buf = dbuf_alloc_arcbuf(db);
+	if (BP_IS_HOLE(&bp)) {
+		bzero(buf->b_data, db->db.db_size);
+	} else {
+		abd_t *abd = abd_get_from_buf(buf->b_data, db->db.db_size);
+
+		SET_BOOKMARK(&zb, dmu_objset_id(db->db_objset),
+		    db->db.db_object, db->db_level, db->db_blkid);
+		err = zio_wait(zio_read(NULL, dmu_objset_spa(db->db_objset),
+		    &bp, abd, db->db.db_size, NULL, NULL,
+		    ZIO_PRIORITY_SYNC_READ, (flags & DB_RF_CANFAIL) ?
+		    ZIO_FLAG_CANFAIL : ZIO_FLAG_MUSTSUCCEED, &zb));
+		abd_free(abd);
+	}
+
+	mutex_enter(&db->db_mtx);
+	db->db_partial_filling = B_FALSE;
+	cv_broadcast(&db->db_changed);
+
+	dr = dbuf_direct_head(db);
+	if (err == 0 && dr != NULL && dr->dr_txg == txg) {
+		ASSERT3P(db->db_buf, ==, NULL);
+		dbuf_set_data(db, buf);
+		dr->dt.dl.dr_data = buf;
+		db->db_state = DB_CACHED;
+		DTRACE_SET_STATE(db, "directly written block read back");
+	} else {
+		arc_buf_destroy(buf, db);
+	}
+
+	return (err);
+}
+
 int
 dbuf_read(dmu_buf_impl_t *db, zio_t *zio, uint32_t flags)
 {
@@ -1597,25 +1977,52 @@ dbuf_read(dmu_buf_impl_t *db, zio_t *zio, uint32_t flags)
 	 */
 	ASSERT(!zfs_refcount_is_zero(&db->db_holds));
 
-	if (db->db_state == DB_NOFILL)
-		return (SET_ERROR(EIO));
+	if (db->db_state == DB_NOFILL) {
+		/*
+		 * A block written by dmu_write_direct() is read back into
+		 * the dbuf, unless the caller only needs its block pointer.
+		 */
+		mutex_enter(&db->db_mtx);
+		if ((flags & DB_RF_NO_DIRECT) && dbuf_direct_head(db) != NULL) {
+			mutex_exit(&db->db_mtx);
+			return (0);
+		}
+		err = dbuf_read_direct(db, flags);
+		if (err == 0 && db->db_state == DB_NOFILL)
+			err = SET_ERROR(EIO);
+		mutex_exit(&db->db_mtx);
+		if (err != 0)
+			return (err);
+	}
 
 	DB_DNODE_ENTER(db);
 	dn = DB_DNODE(db);
 
 	prefetch = db->db_level == 0 && db->db_blkid != DMU_BONUS_BLKID &&
 	    (flags & DB_RF_NOPREFETCH) == 0 && dn != NULL &&
-	    DBUF_IS_CACHEABLE(db);
+	    (DBUF_IS_CACHEABLE(db) || DBUF_IS_UNCACHED(db));
 
 	mutex_enter(&db->db_mtx);
 	if (db->db_state == DB_CACHED) {
 		spa_t *spa = dn->dn_objset->os_spa;
+		dbuf_dirty_record_t *dr = dbuf_partial_head(db);
+
+		/*
+		 * A partially overwritten buffer is filled in from the old
+		 * block the first time it is read.
+		 */
+		if (dr != NULL) {
+			err = dbuf_partial_fill(db, dr->dr_txg,
+			    (flags & DB_RF_CANFAIL) ?
+			    ZIO_FLAG_CANFAIL : ZIO_FLAG_MUSTSUCCEED);
+		}
 
 		/*
 		 * Ensure that this block's dnode has been decrypted if
 		 * the caller has requested decrypted data.
 		 */
-		err = dbuf_read_verify_dnode_crypt(db, flags);
+		if (err == 0)
+			err = dbuf_read_verify_dnode_crypt(db, flags);
 
 		/*
 		 * If the arc buf is compressed or encrypted and the caller
@@ -1723,9 +2130,11 @@ dbuf_noread(dmu_buf_impl_t *db)
 	ASSERT(!zfs_refcount_is_zero(&db->db_holds));
 	ASSERT(db->db_blkid != DMU_BONUS_BLKID);
 	mutex_enter(&db->db_mtx);
-	while (db->db_state == DB_READ || db->db_state == DB_FILL)
+	while (db->db_state == DB_READ || db->db_state == DB_FILL ||
+	    db->db_partial_filling)
 		cv_wait(&db->db_changed, &db->db_mtx);
-	if (db->db_state == DB_UNCACHED) {
+	if (db->db_state == DB_UNCACHED || dbuf_direct_head(db) != NULL) {
+		/* A directly written block is replaced without reading it. */
 		ASSERT(db->db_buf == NULL);
 		ASSERT(db->db.db_data == NULL);
 		dbuf_set_data(db, dbuf_alloc_arcbuf(db));
@@ -1769,6 +2178,15 @@ dbuf_unoverride(dbuf_dirty_record_t *dr)
 	dr->dt.dl.dr_nopwrite = B_FALSE;
 	dr->dt.dl.dr_has_raw_params = B_FALSE;
 
+	/*
+	 * A directly written record had no data of its own; from now on
+	 * it uses whatever the caller fills into the dbuf, if anything.
+	 */
+	if (dr->dt.dl.dr_direct) {
+		dr->dt.dl.dr_direct = B_FALSE;
+		dr->dt.dl.dr_data = db->db_buf;
+	}
+
 	/*
 	 * Release the already-written buffer, so we leave it in
 	 * a consistent dirty state.  Note that all callers are
@@ -1777,7 +2195,8 @@ dbuf_unoverride(dbuf_dirty_record_t *dr)
 	 * the buf thawed to save the effort of freezing &
 	 * immediately re-thawing it.
 	 */
-	arc_release(dr->dt.dl.dr_data, db);
+	if (dr->dt.dl.dr_data != NULL)
+		arc_release(dr->dt.dl.dr_data, db);
 }
 
 /*
@@ -1822,6 +2241,8 @@ dbuf_free_range(dnode_t *dn, uint64_t start_blkid, uint64_t end_blkid,
 
 		/* found a level 0 buffer in the range */
 		mutex_enter(&db->db_mtx);
+		while (db->db_partial_filling)
+			cv_wait(&db->db_changed, &db->db_mtx);
 		if (dbuf_undirty(db, tx)) {
 			/* mutex has been dropped and dbuf destroyed */
 			continue;
@@ -1877,6 +2298,8 @@ dbuf_free_range(dnode_t *dn, uint64_t start_blkid, uint64_t end_blkid,
 			bzero(db->db.db_data, db->db.db_size);
 			rw_exit(&db->db_rwlock);
 			arc_buf_freeze(db->db_buf);
+			if ((dr = dbuf_partial_head(db)) != NULL)
+				dbuf_partial_discard(dr);
 		}
 
 		mutex_exit(&db->db_mtx);
@@ -2084,6 +2507,8 @@ dbuf_dirty(dmu_buf_impl_t *db, dmu_tx_t *tx)
 	    (dmu_tx_is_syncing(tx) ? DN_DIRTY_SYNC : DN_DIRTY_OPEN));
 
 	mutex_enter(&db->db_mtx);
+	while (db->db_partial_filling)
+		cv_wait(&db->db_changed, &db->db_mtx);
 	/*
 	 * XXX make this true for indirects too?  The problem is that
 	 * transactions created with dmu_tx_create_assigned() from
@@ -2177,6 +2602,20 @@ dbuf_dirty(dmu_buf_impl_t *db, dmu_tx_t *tx)
 				 * syncing state (since they are only modified
 				 * then).
 				 */
+				if (dbuf_partial_head(db) != NULL) {
+					/*
+					 * The copy is partial too, and the
+					 * new record still has to be filled
+					 * in from the old block.
+					 */
+					dr->dt.dl.dr_partial =
+					    range_tree_create(NULL, RANGE_SEG32,
+					    NULL, 0, 0);
+					range_tree_walk(
+					    dr_head->dt.dl.dr_partial,
+					    range_tree_add,
+					    dr->dt.dl.dr_partial);
+				}
 				arc_release(db->db_buf, db);
 				dbuf_fix_old_data(db, tx->tx_txg);
 				data_old = db->db_buf;
@@ -2367,6 +2806,9 @@ dbuf_undirty(dmu_buf_impl_t *db, dmu_tx_t *tx)
 	ASSERT0(db->db_level);
 	ASSERT(MUTEX_HELD(&db->db_mtx));
 
+	while (db->db_partial_filling)
+		cv_wait(&db->db_changed, &db->db_mtx);
+
 	/*
 	 * If this buffer is not dirty, we're done.
 	 */
@@ -2376,6 +2818,7 @@ dbuf_undirty(dmu_buf_impl_t *db, dmu_tx_t *tx)
 	ASSERT(dr->dr_dbuf == db);
 
 	dnode_t *dn = dr->dr_dnode;
+	boolean_t direct = dr->dt.dl.dr_direct;
 
 	dprintf_dbuf(db, "size=%llx\n", (u_longlong_t)db->db.db_size);
 
@@ -2411,7 +2854,11 @@ dbuf_undirty(dmu_buf_impl_t *db, dmu_tx_t *tx)
 		ASSERT(dr->dt.dl.dr_data != NULL);
 		if (dr->dt.dl.dr_data != db->db_buf)
 			arc_buf_destroy(dr->dt.dl.dr_data, db);
+	} else if (direct) {
+		/* Free the block written by dmu_write_direct(). */
+		dbuf_unoverride(dr);
 	}
+	dbuf_partial_discard(dr);
 
 	kmem_free(dr, sizeof (dbuf_dirty_record_t));
 
@@ -2424,6 +2871,16 @@ dbuf_undirty(dmu_buf_impl_t *db, dmu_tx_t *tx)
 		return (B_TRUE);
 	}
 
+	/*
+	 * With no directly written block left to read back, the dbuf can
+	 * be read from disk again.
+	 */
+	if (direct && db->db_state == DB_NOFILL &&
+	    list_is_empty(&db->db_dirty_records)) {
+		db->db_state = DB_UNCACHED;
+		DTRACE_SET_STATE(db, "undirtied nofill buffer");
+	}
+
 	return (B_FALSE);
 }
 
@@ -2448,9 +2905,10 @@ dmu_buf_will_dirty_impl(dmu_buf_t *db_fake, int flags, dmu_tx_t *tx)
 		/*
 		 * It's possible that it is already dirty but not cached,
 		 * because there are some calls to dbuf_dirty() that don't
-		 * go through dmu_buf_will_dirty().
+		 * go through dmu_buf_will_dirty().  A partially overwritten
+		 * buffer must be filled in by dbuf_read() first.
 		 */
-		if (dr != NULL) {
+		if (dr != NULL && dbuf_partial_head(db) == NULL) {
 			/* This dbuf is already dirty and cached. */
 			dbuf_redirty(dr);
 			mutex_exit(&db->db_mtx);
@@ -2474,6 +2932,118 @@ dmu_buf_will_dirty(dmu_buf_t *db_fake, dmu_tx_t *tx)
 	    DB_RF_MUST_SUCCEED | DB_RF_NOPREFETCH, tx);
 }
 
+/*
+ * Whether a partial overwrite of this uncached block can skip reading it.
+ * Holes, embedded and freed blocks are not read by dbuf_read() anyway.
+ */
+static boolean_t
+dbuf_partial_deferrable(dmu_buf_impl_t *db)
+{
+	db_lock_type_t dblt;
+	boolean_t ret;
+	dnode_t *dn;
+
+	ASSERT(MUTEX_HELD(&db->db_mtx));
+	ASSERT3U(db->db_state, ==, DB_UNCACHED);
+
+	if (db->db_dirtycnt != 0 || db->db_objset->os_encrypted)
+		return (B_FALSE);
+
+	dblt = dmu_buf_lock_parent(db, RW_READER, FTAG);
+	ret = db->db_blkptr != NULL && !BP_IS_HOLE(db->db_blkptr) &&
+	    !BP_IS_EMBEDDED(db->db_blkptr) && !BP_IS_REDACTED(db->db_blkptr);
+	dmu_buf_unlock_parent(db, dblt, FTAG);
+
+	if (ret) {
+		DB_DNODE_ENTER(db);
+		dn = DB_DNODE(db);
+		ret = !dn->dn_free_txg && !dnode_block_freed(dn, db->db_blkid);
+		DB_DNODE_EXIT(db);
+	}
+
+	return (ret);
+}
+
+static void
+dbuf_partial_add(dmu_buf_impl_t *db, dbuf_dirty_record_t *dr,
+    uint64_t off, uint64_t len)
+{
+	range_tree_t *rt = dr->dt.dl.dr_partial;
+
+	ASSERT(MUTEX_HELD(&db->db_mtx));
+
+	range_tree_clear(rt, off, len);
+	range_tree_add(rt, off, len);
+	if (range_tree_space(rt) == db->db.db_size) {
+		dbuf_partial_discard(dr);
+		DBUF_STAT_BUMP(partial_overwritten);
+	}
+}
+
+/*
+ * Prepare to modify the range [off, off + len) of a level-0 buffer.  If
+ * the block is large and not cached, it is not read: the new dirty record
+ * tracks the ranges which have been written, and the rest of the buffer
+ * is filled in from the old block by dbuf_partial_fill() when it is read,
+ * synced or passed to dmu_sync().  If the ranges cover the whole block
+ * by then, the old block is never read.
+ *
+ * The caller holds a range lock covering the range, so the block cannot
+ * be freed while we set this up.
+ */
+void
+dmu_buf_will_dirty_range(dmu_buf_t *db_fake, uint64_t off, uint64_t len,
+    dmu_tx_t *tx)
+{
+	dmu_buf_impl_t *db = (dmu_buf_impl_t *)db_fake;
+	dbuf_dirty_record_t *dr;
+	boolean_t deferred = B_FALSE;
+
+	ASSERT(tx->tx_txg != 0);
+	ASSERT(!zfs_refcount_is_zero(&db->db_holds));
+	ASSERT3U(off + len, <=, db->db.db_size);
+
+	if (db->db_level != 0 || db->db_blkid == DMU_BONUS_BLKID ||
+	    db->db_blkid == DMU_SPILL_BLKID || dmu_tx_is_syncing(tx) ||
+	    dbuf_deferred_fill_min_size == 0 ||
+	    db->db.db_size < dbuf_deferred_fill_min_size) {
+		dmu_buf_will_dirty(db_fake, tx);
+		return;
+	}
+
+	mutex_enter(&db->db_mtx);
+	while (db->db_state == DB_READ || db->db_state == DB_FILL)
+		cv_wait(&db->db_changed, &db->db_mtx);
+	if (db->db_state == DB_UNCACHED && dbuf_partial_deferrable(db)) {
+		dbuf_set_data(db, dbuf_alloc_arcbuf(db));
+		db->db_state = DB_FILL;
+		DTRACE_SET_STATE(db, "assigning partially filled buffer");
+		deferred = B_TRUE;
+	} else if (db->db_state != DB_CACHED || dbuf_partial_head(db) == NULL) {
+		mutex_exit(&db->db_mtx);
+		dmu_buf_will_dirty(db_fake, tx);
+		return;
+	}
+	mutex_exit(&db->db_mtx);
+
+	dr = dbuf_dirty(db, tx);
+
+	mutex_enter(&db->db_mtx);
+	if (deferred) {
+		ASSERT3U(db->db_state, ==, DB_FILL);
+		ASSERT3P(dr->dt.dl.dr_partial, ==, NULL);
+		dr->dt.dl.dr_partial = range_tree_create(NULL, RANGE_SEG32,
+		    NULL, 0, 0);
+		db->db_state = DB_CACHED;
+		DTRACE_SET_STATE(db, "partial fill done");
+		cv_broadcast(&db->db_changed);
+		DBUF_STAT_BUMP(partial_deferred);
+	}
+	if (dr->dt.dl.dr_partial != NULL)
+		dbuf_partial_add(db, dr, off, len);
+	mutex_exit(&db->db_mtx);
+}
+
 boolean_t
 dmu_buf_is_dirty(dmu_buf_t *db_fake, dmu_tx_t *tx)
 {
@@ -2486,6 +3056,26 @@ dmu_buf_is_dirty(dmu_buf_t *db_fake, dmu_tx_t *tx)
 	return (dr != NULL);
 }
 
+/*
+ * The caller is about to replace the whole buffer of this dirty record, so
+ * nothing is left to fill in from the old block.
+ */
+static void
+dbuf_partial_overwrite(dmu_buf_impl_t *db, dbuf_dirty_record_t *dr)
+{
+	if (db->db_level != 0 || db->db_blkid == DMU_BONUS_BLKID)
+		return;
+
+	mutex_enter(&db->db_mtx);
+	while (db->db_partial_filling)
+		cv_wait(&db->db_changed, &db->db_mtx);
+	if (dr->dt.dl.dr_partial != NULL) {
+		dbuf_partial_discard(dr);
+		DBUF_STAT_BUMP(partial_overwritten);
+	}
+	mutex_exit(&db->db_mtx);
+}
+
 void
 dmu_buf_will_not_fill(dmu_buf_t *db_fake, dmu_tx_t *tx)
 {
@@ -2510,7 +3100,7 @@ dmu_buf_will_fill(dmu_buf_t *db_fake, dmu_tx_t *tx)
 	    dmu_tx_private_ok(tx));
 
 	dbuf_noread(db);
-	(void) dbuf_dirty(db, tx);
+	dbuf_partial_overwrite(db, dbuf_dirty(db, tx));
 }
 
 /*
@@ -2675,9 +3265,16 @@ dbuf_assign_arcbuf(dmu_buf_impl_t *db, arc_buf_t *buf, dmu_tx_t *tx)
 
 	mutex_enter(&db->db_mtx);
 
-	while (db->db_state == DB_READ || db->db_state == DB_FILL)
+	while (db->db_state == DB_READ || db->db_state == DB_FILL ||
+	    db->db_partial_filling)
 		cv_wait(&db->db_changed, &db->db_mtx);
 
+	/* A directly written block is replaced without reading it. */
+	if (dbuf_direct_head(db) != NULL) {
+		db->db_state = DB_UNCACHED;
+		DTRACE_SET_STATE(db, "replacing directly written block");
+	}
+
 	ASSERT(db->db_state == DB_CACHED || db->db_state == DB_UNCACHED);
 
 	if (db->db_state == DB_CACHED &&
@@ -2690,7 +3287,7 @@ dbuf_assign_arcbuf(dmu_buf_impl_t *db, arc_buf_t *buf, dmu_tx_t *tx)
 		 */
 		ASSERT(!arc_is_encrypted(buf));
 		mutex_exit(&db->db_mtx);
-		(void) dbuf_dirty(db, tx);
+		dbuf_partial_overwrite(db, dbuf_dirty(db, tx));
 		bcopy(buf->b_data, db->db.db_data, db->db.db_size);
 		arc_buf_destroy(buf, db);
 		return;
@@ -2710,6 +3307,10 @@ dbuf_assign_arcbuf(dmu_buf_impl_t *db, arc_buf_t *buf, dmu_tx_t *tx)
 			}
 			dr->dt.dl.dr_data = buf;
 			arc_buf_destroy(db->db_buf, db);
+			if (dr->dt.dl.dr_partial != NULL) {
+				dbuf_partial_discard(dr);
+				DBUF_STAT_BUMP(partial_overwritten);
+			}
 		} else if (dr == NULL || dr->dt.dl.dr_data != db->db_buf) {
 			arc_release(db->db_buf, db);
 			arc_buf_destroy(db->db_buf, db);
@@ -2725,6 +3326,81 @@ dbuf_assign_arcbuf(dmu_buf_impl_t *db, arc_buf_t *buf, dmu_tx_t *tx)
 	dmu_buf_fill_done(&db->db, tx);
 }
 
+/*
+ * Can dmu_write_direct() replace this block without going through its
+ * dbuf?  Only if the dbuf holds no data which would have to be kept
+ * consistent with the new block: it is uncached and clean, or it only
+ * has blocks that were themselves written directly.
+ */
+boolean_t
+dbuf_direct_ok(dmu_buf_impl_t *db, dmu_tx_t *tx)
+{
+	boolean_t ok;
+
+	ASSERT(!zfs_refcount_is_zero(&db->db_holds));
+	ASSERT3U(db->db_level, ==, 0);
+	ASSERT(tx->tx_txg != 0);
+
+	mutex_enter(&db->db_mtx);
+	ok = (db->db_state == DB_UNCACHED &&
+	    list_is_empty(&db->db_dirty_records)) ||
+	    (!db->db_partial_filling && dbuf_direct_head(db) != NULL);
+	mutex_exit(&db->db_mtx);
+
+	return (ok);
+}
+
+/*
+ * Make a block written by dmu_write_direct() the contents of this dbuf
+ * in the given txg, the same way dmu_sync() overrides a dirty record.
+ * The dbuf is left in the DB_NOFILL state with no data until it is read
+ * or refilled.  Returns B_FALSE, and leaves the dbuf alone, if it was
+ * cached or dirtied since dbuf_direct_ok() was checked; the caller still
+ * owns the block then.
+ */
+boolean_t
+dbuf_assign_direct(dmu_buf_impl_t *db, const blkptr_t *bp, uint8_t copies,
+    dmu_tx_t *tx)
+{
+	dbuf_dirty_record_t *dr;
+
+	ASSERT(!zfs_refcount_is_zero(&db->db_holds));
+	ASSERT3U(db->db_level, ==, 0);
+	ASSERT(db->db_blkid != DMU_BONUS_BLKID);
+	ASSERT(tx->tx_txg != 0);
+
+	mutex_enter(&db->db_mtx);
+	while (db->db_partial_filling)
+		cv_wait(&db->db_changed, &db->db_mtx);
+	if (!(db->db_state == DB_UNCACHED &&
+	    list_is_empty(&db->db_dirty_records)) &&
+	    dbuf_direct_head(db) == NULL) {
+		mutex_exit(&db->db_mtx);
+		return (B_FALSE);
+	}
+	db->db_state = DB_NOFILL;
+	DTRACE_SET_STATE(db, "assigning directly written block");
+	mutex_exit(&db->db_mtx);
+
+	/*
+	 * Redirtying in the same txg frees the block written before.
+	 */
+	dr = dbuf_dirty(db, tx);
+
+	mutex_enter(&db->db_mtx);
+	ASSERT3P(dr, ==, list_head(&db->db_dirty_records));
+	ASSERT3P(dr->dt.dl.dr_data, ==, NULL);
+	ASSERT3U(dr->dt.dl.dr_override_state, ==, DR_NOT_OVERRIDDEN);
+	dr->dt.dl.dr_overridden_by = *bp;
+	dr->dt.dl.dr_override_state = DR_OVERRIDDEN;
+	dr->dt.dl.dr_copies = copies;
+	dr->dt.dl.dr_nopwrite = B_FALSE;
+	dr->dt.dl.dr_direct = B_TRUE;
+	mutex_exit(&db->db_mtx);
+
+	return (B_TRUE);
+}
+
 void
 dbuf_destroy(dmu_buf_impl_t *db)
 {
@@ -2968,6 +3644,7 @@ dbuf_create(dnode_t *dn, uint8_t level, uint64_t blkid,
 	db->db_user_immediate_evict = FALSE;
 	db->db_freed_in_flight = FALSE;
 	db->db_pending_evict = FALSE;
+	db->db_uncached = FALSE;
 
 	if (blkid == DMU_BONUS_BLKID) {
 		ASSERT3P(parent, ==, dn->dn_dbuf);
@@ -3069,6 +3746,7 @@ typedef struct dbuf_prefetch_arg {
 	arc_flags_t dpa_aflags; /* Flags to pass to the final prefetch. */
 	dbuf_prefetch_fn dpa_cb; /* prefetch completion callback */
 	void *dpa_arg; /* prefetch completion arg */
+	arc_dataset_t *dpa_arc_dataset; /* held, charged for the reads */
 } dbuf_prefetch_arg_t;
 
 static void
@@ -3076,6 +3754,8 @@ dbuf_prefetch_fini(dbuf_prefetch_arg_t *dpa, boolean_t io_done)
 {
 	if (dpa->dpa_cb != NULL)
 		dpa->dpa_cb(dpa->dpa_arg, io_done);
+	if (dpa->dpa_arc_dataset != NULL)
+		arc_dataset_rele(dpa->dpa_arc_dataset);
 	kmem_free(dpa, sizeof (*dpa));
 }
 
@@ -3117,9 +3797,10 @@ dbuf_issue_final_prefetch(dbuf_prefetch_arg_t *dpa, blkptr_t *bp)
 	ASSERT3U(dpa->dpa_curlevel, ==, BP_GET_LEVEL(bp));
 	ASSERT3U(dpa->dpa_curlevel, ==, dpa->dpa_zb.zb_level);
 	ASSERT(dpa->dpa_zio != NULL);
-	(void) arc_read(dpa->dpa_zio, dpa->dpa_spa, bp,
+	(void) arc_read_dataset(dpa->dpa_zio, dpa->dpa_spa, bp,
 	    dbuf_issue_final_prefetch_done, dpa,
-	    dpa->dpa_prio, zio_flags, &aflags, &dpa->dpa_zb);
+	    dpa->dpa_prio, zio_flags, &aflags, &dpa->dpa_zb,
+	    dpa->dpa_arc_dataset);
 }
 
 /*
@@ -3206,10 +3887,10 @@ dbuf_prefetch_indirect_done(zio_t *zio, const zbookmark_phys_t *zb,
 		SET_BOOKMARK(&zb, dpa->dpa_zb.zb_objset,
 		    dpa->dpa_zb.zb_object, dpa->dpa_curlevel, nextblkid);
 
-		(void) arc_read(dpa->dpa_zio, dpa->dpa_spa,
+		(void) arc_read_dataset(dpa->dpa_zio, dpa->dpa_spa,
 		    bp, dbuf_prefetch_indirect_done, dpa, dpa->dpa_prio,
 		    ZIO_FLAG_CANFAIL | ZIO_FLAG_SPECULATIVE,
-		    &iter_aflags, &zb);
+		    &iter_aflags, &zb, dpa->dpa_arc_dataset);
 	}
 
 	arc_buf_destroy(abuf, private);
@@ -3316,6 +3997,9 @@ dbuf_prefetch_impl(dnode_t *dn, int64_t level, uint64_t blkid,
 	dpa->dpa_zio = pio;
 	dpa->dpa_cb = cb;
 	dpa->dpa_arg = arg;
+	dpa->dpa_arc_dataset = dn->dn_objset->os_arc_dataset;
+	if (dpa->dpa_arc_dataset != NULL)
+		arc_dataset_hold(dpa->dpa_arc_dataset);
 
 	/* flag if L2ARC eligible, l2arc_noprefetch then decides */
 	if (DNODE_LEVEL_IS_L2CACHEABLE(dn, level))
@@ -3341,10 +4025,10 @@ dbuf_prefetch_impl(dnode_t *dn, int64_t level, uint64_t blkid,
 
 		SET_BOOKMARK(&zb, ds != NULL ? ds->ds_object : DMU_META_OBJSET,
 		    dn->dn_object, curlevel, curblkid);
-		(void) arc_read(dpa->dpa_zio, dpa->dpa_spa,
+		(void) arc_read_dataset(dpa->dpa_zio, dpa->dpa_spa,
 		    &bp, dbuf_prefetch_indirect_done, dpa, prio,
 		    ZIO_FLAG_CANFAIL | ZIO_FLAG_SPECULATIVE,
-		    &iter_aflags, &zb);
+		    &iter_aflags, &zb, dpa->dpa_arc_dataset);
 	}
 	/*
 	 * We use pio here instead of dpa_zio since it's possible that
@@ -3411,6 +4095,17 @@ dbuf_hold_impl(dnode_t *dn, uint8_t level, uint64_t blkid,
 
 	*dbp = NULL;
 
+	if (dbuf_lockless_hold && !fail_uncached) {
+		db = dbuf_find_held(dn->dn_objset, dn->dn_object, level,
+		    blkid, tag);
+		if (db != NULL) {
+			DBUF_STAT_BUMP(hash_hits_lockless);
+			ASSERT3P(DB_DNODE(db), ==, dn);
+			*dbp = db;
+			return (0);
+		}
+	}
+
 	/* dbuf_find() returns with db_mtx held */
 	db = dbuf_find(dn->dn_objset, dn->dn_object, level, blkid);
 
@@ -3442,6 +4137,30 @@ dbuf_hold_impl(dnode_t *dn, uint8_t level, uint64_t blkid,
 		return (SET_ERROR(ENOENT));
 	}
 
+	dbuf_hold_locked(dn, db, tag);
+
+	/* NOTE: we can't rele the parent until after we drop the db_mtx */
+	if (parent)
+		dbuf_rele(parent, NULL);
+
+	ASSERT3P(DB_DNODE(db), ==, dn);
+	ASSERT3U(db->db_blkid, ==, blkid);
+	ASSERT3U(db->db_level, ==, level);
+	*dbp = db;
+
+	return (0);
+}
+
+/*
+ * Add a hold on a dbuf returned by dbuf_find() or dbuf_create(), taking it
+ * off the dbuf caches if needed.  Called with db_mtx held, returns with
+ * db_mtx dropped.
+ */
+static void
+dbuf_hold_locked(dnode_t *dn, dmu_buf_impl_t *db, void *tag)
+{
+	ASSERT(MUTEX_HELD(&db->db_mtx));
+
 	if (db->db_buf != NULL) {
 		arc_buf_access(db->db_buf);
 		ASSERT3P(db->db.db_data, ==, db->db_buf->b_data);
@@ -3485,17 +4204,98 @@ dbuf_hold_impl(dnode_t *dn, uint8_t level, uint64_t blkid,
 	(void) zfs_refcount_add(&db->db_holds, tag);
 	DBUF_VERIFY(db);
 	mutex_exit(&db->db_mtx);
+}
 
-	/* NOTE: we can't rele the parent until after we drop the db_mtx */
-	if (parent)
-		dbuf_rele(parent, NULL);
+/*
+ * Hold the level-0 dbufs for blocks [blkid, blkid + nblks) of dn into dbp.
+ * This is equivalent to calling dbuf_hold() for each block, but the level-1
+ * parent of uncached blocks is held and read once per indirect block
+ * rather than once per block.  Dbufs which are already held elsewhere are
+ * referenced without taking db_mtx, as in dbuf_hold_impl().
+ *
+ * On failure the dbufs held so far are left in dbp for the caller to
+ * release; the remaining entries are not touched.
+ * Note: dn_struct_rwlock must be held.
+ */
+int
+dbuf_hold_array(dnode_t *dn, uint64_t blkid, uint64_t nblks, void *tag,
+    dmu_buf_t **dbp)
+{
+	dmu_buf_impl_t *parent = NULL;
+	int epbs = dn->dn_indblkshift - SPA_BLKPTRSHIFT;
+	int nlevels = dn->dn_phys->dn_nlevels;
+	int err = 0;
 
-	ASSERT3P(DB_DNODE(db), ==, dn);
-	ASSERT3U(db->db_blkid, ==, blkid);
-	ASSERT3U(db->db_level, ==, level);
-	*dbp = db;
+	ASSERT(RW_LOCK_HELD(&dn->dn_struct_rwlock));
 
-	return (0);
+	for (uint64_t i = 0; i < nblks; i++) {
+		uint64_t bid = blkid + i;
+		dmu_buf_impl_t *db = NULL;
+		blkptr_t *bp;
+
+		if (dbuf_lockless_hold) {
+			db = dbuf_find_held(dn->dn_objset, dn->dn_object, 0,
+			    bid, tag);
+		}
+		if (db != NULL) {
+			DBUF_STAT_BUMP(hash_hits_lockless);
+			dbp[i] = &db->db;
+			continue;
+		}
+
+		/* dbuf_find() returns with db_mtx held */
+		db = dbuf_find(dn->dn_objset, dn->dn_object, 0, bid);
+		if (db != NULL) {
+			dbuf_hold_locked(dn, db, tag);
+			dbp[i] = &db->db;
+			continue;
+		}
+
+		/*
+		 * Blocks referenced directly from the dnode, or beyond the
+		 * range addressable by its current indirect blocks, take the
+		 * regular path through dbuf_findbp().
+		 */
+		if (nlevels < 2 || bid >= ((uint64_t)dn->dn_phys->dn_nblkptr <<
+		    ((nlevels - 1) * epbs))) {
+			err = dbuf_hold_impl(dn, 0, bid, FALSE, FALSE, tag,
+			    &db);
+			if (err != 0)
+				break;
+			dbp[i] = &db->db;
+			continue;
+		}
+
+		if (parent != NULL && parent->db_blkid != (bid >> epbs)) {
+			dbuf_rele(parent, NULL);
+			parent = NULL;
+		}
+		if (parent == NULL) {
+			err = dbuf_hold_impl(dn, 1, bid >> epbs, FALSE, FALSE,
+			    NULL, &parent);
+			if (err != 0)
+				break;
+			err = dbuf_read(parent, NULL, (DB_RF_HAVESTRUCT |
+			    DB_RF_NOPREFETCH | DB_RF_CANFAIL));
+			if (err != 0)
+				break;
+		}
+
+		rw_enter(&parent->db_rwlock, RW_READER);
+		bp = ((blkptr_t *)parent->db.db_data) +
+		    (bid & ((1ULL << epbs) - 1));
+		rw_exit(&parent->db_rwlock);
+
+		/* dbuf_create() returns with db_mtx held */
+		db = dbuf_create(dn, 0, bid, parent, bp);
+		dbuf_hold_locked(dn, db, tag);
+		dbp[i] = &db->db;
+	}
+
+	if (parent != NULL)
+		dbuf_rele(parent, NULL);
+
+	return (err);
 }
 
 dmu_buf_impl_t *
@@ -3689,7 +4489,7 @@ dbuf_rele_and_unlock(dmu_buf_impl_t *db, void *tag, boolean_t evicting)
 			blkptr_t bp;
 			spa_t *spa = dmu_objset_spa(db->db_objset);
 
-			if (!DBUF_IS_CACHEABLE(db) &&
+			if ((!DBUF_IS_CACHEABLE(db) || db->db_uncached) &&
 			    db->db_blkptr != NULL &&
 			    !BP_IS_HOLE(db->db_blkptr) &&
 			    !BP_IS_EMBEDDED(db->db_blkptr)) {
@@ -3698,7 +4498,7 @@ dbuf_rele_and_unlock(dmu_buf_impl_t *db, void *tag, boolean_t evicting)
 			}
 
 			if (!DBUF_IS_CACHEABLE(db) ||
-			    db->db_pending_evict) {
+			    db->db_pending_evict || db->db_uncached) {
 				dbuf_destroy(db);
 			} else if (!multilist_link_active(&db->db_cache_link)) {
 				ASSERT3U(db->db_caching_status, ==,
@@ -4280,6 +5080,13 @@ dbuf_sync_leaf(dbuf_dirty_record_t *dr, dmu_tx_t *tx)
 		ASSERT(dr->dt.dl.dr_override_state != DR_NOT_OVERRIDDEN);
 	}
 
+	/*
+	 * A partially overwritten block is completed from its previous
+	 * version before it is written out.
+	 */
+	if (db->db_state != DB_NOFILL && dr->dt.dl.dr_partial != NULL)
+		VERIFY0(dbuf_partial_fill(db, txg, ZIO_FLAG_MUSTSUCCEED));
+
 	/*
 	 * If this is a dnode block, ensure it is appropriately encrypted
 	 * or decrypted, depending on what we are writing to it this txg.
@@ -4325,6 +5132,21 @@ dbuf_sync_list(list_t *list, int level, dmu_tx_t *tx)
 {
 	dbuf_dirty_record_t *dr;
 
+	/*
+	 * Read the old versions of partially overwritten blocks in
+	 * parallel, rather than one at a time in dbuf_sync_leaf().
+	 */
+	if (level == 0) {
+		for (dr = list_head(list); dr != NULL;
+		    dr = list_next(list, dr)) {
+			if (dr->dr_dbuf != NULL && dr->dr_zio == NULL &&
+			    dr->dr_dbuf->db_level == 0 &&
+			    dr->dr_dbuf->db_blkid != DMU_BONUS_BLKID &&
+			    dr->dt.dl.dr_partial != NULL)
+				dbuf_partial_prefetch(dr);
+		}
+	}
+
 	while ((dr = list_head(list))) {
 		if (dr->dr_zio != NULL) {
 			/*
@@ -4568,9 +5390,16 @@ dbuf_write_done(zio_t *zio, arc_buf_t *buf, void *vdb)
 	if (db->db_level == 0) {
 		ASSERT(db->db_blkid != DMU_BONUS_BLKID);
 		ASSERT(dr->dt.dl.dr_override_state == DR_NOT_OVERRIDDEN);
+		ASSERT3P(dr->dt.dl.dr_partial, ==, NULL);
 		if (db->db_state != DB_NOFILL) {
-			if (dr->dt.dl.dr_data != db->db_buf)
+			if (dr->dt.dl.dr_data != NULL &&
+			    dr->dt.dl.dr_data != db->db_buf)
 				arc_buf_destroy(dr->dt.dl.dr_data, db);
+		} else if (dr->dt.dl.dr_direct &&
+		    list_is_empty(&db->db_dirty_records)) {
+			/* The directly written block is now on disk. */
+			db->db_state = DB_UNCACHED;
+			DTRACE_SET_STATE(db, "direct write done");
 		}
 	} else {
 		ASSERT(list_head(&dr->dt.di.dr_children) == NULL);
@@ -4838,7 +5667,8 @@ dbuf_write(dbuf_dirty_record_t *dr, arc_buf_t *data, dmu_tx_t *tx)
 
 	if (db->db_blkid == DMU_SPILL_BLKID)
 		wp_flag = WP_SPILL;
-	wp_flag |= (db->db_state == DB_NOFILL) ? WP_NOFILL : 0;
+	wp_flag |= (db->db_state == DB_NOFILL ||
+	    (db->db_level == 0 && data == NULL)) ? WP_NOFILL : 0;
 
 	dmu_write_policy(os, dn, db->db_level, wp_flag, &zp);
 
@@ -4895,7 +5725,7 @@ dbuf_write(dbuf_dirty_record_t *dr, arc_buf_t *data, dmu_tx_t *tx)
 		    &zp, dbuf_write_ready,
 		    children_ready_cb, dbuf_write_physdone,
 		    dbuf_write_done, db, ZIO_PRIORITY_ASYNC_WRITE,
-		    ZIO_FLAG_MUSTSUCCEED, &zb);
+		    ZIO_FLAG_MUSTSUCCEED, &zb, os->os_arc_dataset);
 	}
 }
 
@@ -4947,6 +5777,12 @@ ZFS_MODULE_PARAM(zfs_dbuf_cache, dbuf_cache_, lowater_pct, UINT, ZMOD_RW,
 	"Percentage below dbuf_cache_max_bytes when the evict thread stops "
 	"evicting dbufs.");
 
+ZFS_MODULE_PARAM(zfs_dbuf, dbuf_, lockless_hold, INT, ZMOD_RW,
+	"Hold cached dbufs which are already held without taking db_mtx.");
+
+ZFS_MODULE_PARAM(zfs_dbuf, dbuf_, deferred_fill_min_size, ULONG, ZMOD_RW,
+	"Minimum block size for partial writes which do not read the block.");
+
 ZFS_MODULE_PARAM(zfs_dbuf, dbuf_, metadata_cache_max_bytes, ULONG, ZMOD_RW,
 	"Maximum size in bytes of the dbuf metadata cache.");
 
@@ -212,6 +212,8 @@ dmu_buf_hold_by_dnode(dnode_t *dn, uint64_t offset,
 		db_flags |= DB_RF_NOPREFETCH;
 	if (flags & DMU_READ_NO_DECRYPT)
 		db_flags |= DB_RF_NO_DECRYPT;
+	if (flags & DMU_READ_NO_DIRECT)
+		db_flags |= DB_RF_NO_DIRECT;
 
 	err = dmu_buf_hold_noread_by_dnode(dn, offset, tag, dbp);
 	if (err == 0) {
@@ -237,6 +239,8 @@ dmu_buf_hold(objset_t *os, uint64_t object, uint64_t offset,
 		db_flags |= DB_RF_NOPREFETCH;
 	if (flags & DMU_READ_NO_DECRYPT)
 		db_flags |= DB_RF_NO_DECRYPT;
+	if (flags & DMU_READ_NO_DIRECT)
+		db_flags |= DB_RF_NO_DIRECT;
 
 	err = dmu_buf_hold_noread(os, object, offset, tag, dbp);
 	if (err == 0) {
@@ -492,9 +496,20 @@ dmu_spill_hold_by_bonus(dmu_buf_t *bonus, uint32_t flags, void *tag,
  * and can induce severe lock contention when writing to several files
  * whose dnodes are in the same block.
  */
-int
-dmu_buf_hold_array_by_dnode(dnode_t *dn, uint64_t offset, uint64_t length,
-    boolean_t read, void *tag, int *numbufsp, dmu_buf_t ***dbpp, uint32_t flags)
+/*
+ * Hold the dbufs covering the given range and, if "read" is set, start
+ * reading the uncached ones.  Reads issued here are children of a root zio
+ * which is returned in *ziop with the given done callback, or NULL if no
+ * read was issued; the caller must wait for it or hand it to zio_nowait().
+ * *missedp is set if any block was not cached, including blocks which are
+ * being read by another thread and have to be waited for with
+ * dmu_buf_wait_array().
+ */
+static int
+dmu_buf_hold_array_issue(dnode_t *dn, uint64_t offset, uint64_t length,
+    boolean_t read, void *tag, int *numbufsp, dmu_buf_t ***dbpp,
+    uint32_t flags, zio_done_func_t *done, void *private, zio_t **ziop,
+    boolean_t *missedp)
 {
 	dmu_buf_t **dbp;
 	zstream_t *zs = NULL;
@@ -534,9 +549,6 @@ dmu_buf_hold_array_by_dnode(dnode_t *dn, uint64_t offset, uint64_t length,
 	}
 	dbp = kmem_zalloc(sizeof (dmu_buf_t *) * nblks, KM_SLEEP);
 
-	if (read)
-		zio = zio_root(dn->dn_objset->os_spa, NULL, NULL,
-		    ZIO_FLAG_CANFAIL);
 	blkid = dbuf_whichblock(dn, 0, offset);
 	if ((flags & DMU_READ_NO_PREFETCH) == 0 &&
 	    DNODE_META_IS_CACHEABLE(dn) && length <= zfetch_array_rd_sz) {
@@ -546,19 +558,25 @@ dmu_buf_hold_array_by_dnode(dnode_t *dn, uint64_t offset, uint64_t length,
 		 * base predictions on the original less racy request order.
 		 */
 		zs = dmu_zfetch_prepare(&dn->dn_zfetch, blkid, nblks,
-		    read && DNODE_IS_CACHEABLE(dn), B_TRUE);
+		    read && (DNODE_IS_CACHEABLE(dn) || DNODE_IS_UNCACHED(dn)),
+		    B_TRUE);
 	}
-	for (i = 0; i < nblks; i++) {
-		dmu_buf_impl_t *db = dbuf_hold(dn, blkid + i, tag);
-		if (db == NULL) {
-			if (zs)
-				dmu_zfetch_run(zs, missed, B_TRUE);
-			rw_exit(&dn->dn_struct_rwlock);
-			dmu_buf_rele_array(dbp, nblks, tag);
-			if (read)
-				zio_nowait(zio);
-			return (SET_ERROR(EIO));
-		}
+
+	/*
+	 * Hold the whole range in one pass, so that the parent indirect
+	 * block of uncached blocks is looked up once rather than per block.
+	 */
+	err = dbuf_hold_array(dn, blkid, nblks, tag, dbp);
+	if (err != 0) {
+		if (zs)
+			dmu_zfetch_run(zs, missed, B_TRUE);
+		rw_exit(&dn->dn_struct_rwlock);
+		dmu_buf_rele_array(dbp, nblks, tag);
+		return (SET_ERROR(EIO));
+	}
+
+	for (i = 0; read && i < nblks; i++) {
+		dmu_buf_impl_t *db = (dmu_buf_impl_t *)dbp[i];
 
 		/*
 		 * Initiate async demand data read.
@@ -566,14 +584,17 @@ dmu_buf_hold_array_by_dnode(dnode_t *dn, uint64_t offset, uint64_t length,
 		 * (1) dbuf_read() may change the state to CACHED due to a
 		 * hit in the ARC, and (2) on a cache miss, a child will
 		 * have been added to "zio" but not yet completed, so the
-		 * state will not yet be CACHED.
+		 * state will not yet be CACHED.  The root zio is only
+		 * created once a block is found not to be cached, so reads
+		 * served entirely from the dbuf cache do not allocate one.
 		 */
-		if (read) {
-			(void) dbuf_read(db, zio, dbuf_flags);
-			if (db->db_state != DB_CACHED)
-				missed = B_TRUE;
+		if (zio == NULL && db->db_state != DB_CACHED) {
+			zio = zio_root(dn->dn_objset->os_spa, done, private,
+			    ZIO_FLAG_CANFAIL);
 		}
-		dbp[i] = &db->db;
+		(void) dbuf_read(db, zio, dbuf_flags);
+		if (db->db_state != DB_CACHED)
+			missed = B_TRUE;
 	}
 
 	if (!read)
@@ -583,36 +604,188 @@ dmu_buf_hold_array_by_dnode(dnode_t *dn, uint64_t offset, uint64_t length,
 		dmu_zfetch_run(zs, missed, B_TRUE);
 	rw_exit(&dn->dn_struct_rwlock);
 
-	if (read) {
+	*numbufsp = nblks;
+	*dbpp = dbp;
+	*ziop = zio;
+	*missedp = missed;
+	return (0);
+}
+
+/*
+ * Wait for dbufs which were being read or filled by another thread when
+ * they were held.
+ */
+static int
+dmu_buf_wait_array(dmu_buf_t **dbp, int numbufs)
+{
+	int err = 0;
+
+	for (int i = 0; i < numbufs; i++) {
+		dmu_buf_impl_t *db = (dmu_buf_impl_t *)dbp[i];
+		mutex_enter(&db->db_mtx);
+		while (db->db_state == DB_READ ||
+		    db->db_state == DB_FILL)
+			cv_wait(&db->db_changed, &db->db_mtx);
+		if (db->db_state == DB_UNCACHED)
+			err = SET_ERROR(EIO);
+		mutex_exit(&db->db_mtx);
+		if (err)
+			break;
+	}
+	return (err);
+}
+
+int
+dmu_buf_hold_array_by_dnode(dnode_t *dn, uint64_t offset, uint64_t length,
+    boolean_t read, void *tag, int *numbufsp, dmu_buf_t ***dbpp, uint32_t flags)
+{
+	dmu_buf_t **dbp;
+	int numbufs, err;
+	zio_t *zio;
+	boolean_t missed;
+
+	err = dmu_buf_hold_array_issue(dn, offset, length, read, tag,
+	    &numbufs, &dbp, flags, NULL, NULL, &zio, &missed);
+	if (err)
+		return (err);
+
+	if (read && zio != NULL) {
 		/* wait for async read i/o */
 		err = zio_wait(zio);
 		if (err) {
-			dmu_buf_rele_array(dbp, nblks, tag);
+			dmu_buf_rele_array(dbp, numbufs, tag);
 			return (err);
 		}
+	}
 
+	if (read && missed) {
 		/* wait for other io to complete */
-		for (i = 0; i < nblks; i++) {
-			dmu_buf_impl_t *db = (dmu_buf_impl_t *)dbp[i];
-			mutex_enter(&db->db_mtx);
-			while (db->db_state == DB_READ ||
-			    db->db_state == DB_FILL)
-				cv_wait(&db->db_changed, &db->db_mtx);
-			if (db->db_state == DB_UNCACHED)
-				err = SET_ERROR(EIO);
-			mutex_exit(&db->db_mtx);
-			if (err) {
-				dmu_buf_rele_array(dbp, nblks, tag);
-				return (err);
-			}
+		err = dmu_buf_wait_array(dbp, numbufs);
+		if (err) {
+			dmu_buf_rele_array(dbp, numbufs, tag);
+			return (err);
 		}
 	}
 
-	*numbufsp = nblks;
+	*numbufsp = numbufs;
 	*dbpp = dbp;
 	return (0);
 }
 
+/*
+ * State of a dmu_read_async_dnode() call whose reads are in flight.
+ */
+typedef struct dmu_read_async {
+	dmu_buf_t		**dra_dbp;
+	int			dra_numbufs;
+	int			dra_err;
+	void			*dra_tag;
+	dmu_read_done_func_t	*dra_done;
+	void			*dra_arg;
+	taskq_ent_t		dra_tqent;
+} dmu_read_async_t;
+
+static taskq_t *dmu_read_async_taskq;
+
+/*
+ * Runs from dmu_read_async_taskq once the reads issued for a request are
+ * done.  Blocks which another thread was reading may still be in flight,
+ * so wait for them here rather than in the zio completion path.
+ */
+static void
+dmu_read_async_task(void *arg)
+{
+	dmu_read_async_t *dra = arg;
+	int err = dra->dra_err;
+
+	if (err == 0)
+		err = dmu_buf_wait_array(dra->dra_dbp, dra->dra_numbufs);
+	if (dra->dra_done != NULL) {
+		dra->dra_done(dra->dra_arg, dra->dra_dbp, dra->dra_numbufs,
+		    err);
+	}
+	dmu_buf_rele_array(dra->dra_dbp, dra->dra_numbufs, dra->dra_tag);
+	kmem_free(dra, sizeof (dmu_read_async_t));
+}
+
+static void
+dmu_read_async_done(zio_t *zio)
+{
+	dmu_read_async_t *dra = zio->io_private;
+
+	/* Every block turned out to be cached; see dmu_read_async_dnode(). */
+	if (dra->dra_dbp == NULL)
+		return;
+
+	dra->dra_err = zio->io_error;
+	taskq_dispatch_ent(dmu_read_async_taskq, dmu_read_async_task, dra, 0,
+	    &dra->dra_tqent);
+}
+
+/*
+ * Read a range of an object without waiting for the I/O.
+ *
+ * If every block of the range is already cached, the dbufs are returned
+ * held with "tag" in *dbpp and *numbufsp, and 0 is returned; the caller
+ * reads them and releases them with dmu_buf_rele_array().  Otherwise the
+ * reads are issued and EINPROGRESS is returned.  Once all of the blocks
+ * are available, or one of them failed, "done" is called from a taskq
+ * with the held dbufs and the error, which are released when it returns.
+ * "done" may be NULL to only bring the range into the cache.  Any other
+ * error means nothing was issued and "done" will not be called.  Looking
+ * up the blocks may still wait for the dnode's struct lock and for reads of
+ * uncached indirect blocks; see dmu_read_uio_dnode_nowait() for a variant
+ * which does not block at all.
+ */
+int
+dmu_read_async_dnode(dnode_t *dn, uint64_t offset, uint64_t length,
+    void *tag, int *numbufsp, dmu_buf_t ***dbpp, dmu_read_done_func_t *done,
+    void *arg, uint32_t flags)
+{
+	dmu_read_async_t *dra;
+	dmu_buf_t **dbp;
+	int numbufs, err;
+	zio_t *zio;
+	boolean_t missed;
+
+	dra = kmem_zalloc(sizeof (dmu_read_async_t), KM_SLEEP);
+	taskq_init_ent(&dra->dra_tqent);
+	err = dmu_buf_hold_array_issue(dn, offset, length, B_TRUE, tag,
+	    &numbufs, &dbp, flags, dmu_read_async_done, dra, &zio, &missed);
+	if (err != 0) {
+		kmem_free(dra, sizeof (dmu_read_async_t));
+		return (err);
+	}
+
+	if (!missed) {
+		/*
+		 * A root zio may have been created for a block which then
+		 * hit in the ARC.  It has no children, and since dra_dbp is
+		 * not set its done callback does nothing.
+		 */
+		if (zio != NULL)
+			(void) zio_wait(zio);
+		kmem_free(dra, sizeof (dmu_read_async_t));
+		*numbufsp = numbufs;
+		*dbpp = dbp;
+		return (0);
+	}
+
+	dra->dra_dbp = dbp;
+	dra->dra_numbufs = numbufs;
+	dra->dra_tag = tag;
+	dra->dra_done = done;
+	dra->dra_arg = arg;
+	if (zio != NULL) {
+		zio_nowait(zio);
+	} else {
+		/* Only waiting on reads issued by other threads. */
+		taskq_dispatch_ent(dmu_read_async_taskq, dmu_read_async_task,
+		    dra, 0, &dra->dra_tqent);
+	}
+	return (SET_ERROR(EINPROGRESS));
+}
+
 static int
 dmu_buf_hold_array(objset_t *os, uint64_t object, uint64_t offset,
     uint64_t length, int read, void *tag, int *numbufsp, dmu_buf_t ***dbpp)
@@ -736,6 +909,20 @@ dmu_prefetch(objset_t *os, uint64_t object, int64_t level, uint64_t offset,
 	dnode_rele(dn, FTAG);
 }
 
+/*
+ * Tell the predictive prefetcher how the object behind this buffer is
+ * going to be accessed.  The hint lasts while the dnode stays cached.
+ */
+void
+dmu_prefetch_hint(dmu_buf_t *db_fake, dmu_prefetch_hint_t hint)
+{
+	dmu_buf_impl_t *db = (dmu_buf_impl_t *)db_fake;
+
+	DB_DNODE_ENTER(db);
+	dmu_zfetch_set_hint(&DB_DNODE(db)->dn_zfetch, hint);
+	DB_DNODE_EXIT(db);
+}
+
 /*
  * Get the next "chunk" of file data to free.  We traverse the file from
  * the end so that the file gets shorter over time (if we crashes in the
@@ -1194,20 +1381,11 @@ dmu_redact(objset_t *os, uint64_t object, uint64_t offset, uint64_t size,
 }
 
 #ifdef _KERNEL
-int
-dmu_read_uio_dnode(dnode_t *dn, zfs_uio_t *uio, uint64_t size)
+static int
+dmu_read_uio_copy(dmu_buf_t **dbp, int numbufs, zfs_uio_t *uio,
+    uint64_t size)
 {
-	dmu_buf_t **dbp;
-	int numbufs, i, err;
-
-	/*
-	 * NB: we could do this block-at-a-time, but it's nice
-	 * to be reading in parallel.
-	 */
-	err = dmu_buf_hold_array_by_dnode(dn, zfs_uio_offset(uio), size,
-	    TRUE, FTAG, &numbufs, &dbp, 0);
-	if (err)
-		return (err);
+	int i, err = 0;
 
 	for (i = 0; i < numbufs; i++) {
 		uint64_t tocpy;
@@ -1227,11 +1405,178 @@ dmu_read_uio_dnode(dnode_t *dn, zfs_uio_t *uio, uint64_t size)
 
 		size -= tocpy;
 	}
+
+	return (err);
+}
+
+int
+dmu_read_uio_dnode(dnode_t *dn, zfs_uio_t *uio, uint64_t size)
+{
+	dmu_buf_t **dbp;
+	int numbufs, err;
+
+	/*
+	 * NB: we could do this block-at-a-time, but it's nice
+	 * to be reading in parallel.
+	 */
+	err = dmu_buf_hold_array_by_dnode(dn, zfs_uio_offset(uio), size,
+	    TRUE, FTAG, &numbufs, &dbp, 0);
+	if (err)
+		return (err);
+
+	err = dmu_read_uio_copy(dbp, numbufs, uio, size);
 	dmu_buf_rele_array(dbp, numbufs, FTAG);
 
 	return (err);
 }
 
+/*
+ * Like dmu_read_uio_dnode(), but never blocks.  Only blocks which are
+ * already cached are held: if the dnode's struct lock is contended, or any
+ * block of the range or its parent indirect block is not cached, EAGAIN is
+ * returned without copying anything.  Prefetches are issued for the
+ * uncached blocks, so that the caller's retry is likely to find them.
+ */
+int
+dmu_read_uio_dnode_nowait(dnode_t *dn, zfs_uio_t *uio, uint64_t size)
+{
+	uint64_t offset = zfs_uio_offset(uio);
+	uint64_t blkid, nblks, i;
+	dmu_buf_t **dbp;
+	int err = 0;
+
+	if (!rw_tryenter(&dn->dn_struct_rwlock, RW_READER))
+		return (SET_ERROR(EAGAIN));
+
+	if (dn->dn_datablkshift) {
+		int blkshift = dn->dn_datablkshift;
+		nblks = (P2ROUNDUP(offset + size, 1ULL << blkshift) -
+		    P2ALIGN(offset, 1ULL << blkshift)) >> blkshift;
+	} else {
+		if (offset + size > dn->dn_datablksz) {
+			rw_exit(&dn->dn_struct_rwlock);
+			return (SET_ERROR(EIO));
+		}
+		nblks = 1;
+	}
+	dbp = kmem_zalloc(sizeof (dmu_buf_t *) * nblks, KM_SLEEP);
+
+	blkid = dbuf_whichblock(dn, 0, offset);
+	for (i = 0; i < nblks; i++) {
+		dmu_buf_impl_t *db;
+
+		if (dbuf_hold_impl(dn, 0, blkid + i, B_FALSE, B_TRUE, FTAG,
+		    &db) != 0) {
+			dbuf_prefetch(dn, 0, blkid + i, ZIO_PRIORITY_ASYNC_READ,
+			    0);
+			err = SET_ERROR(EAGAIN);
+			continue;
+		}
+		dbp[i] = &db->db;
+	}
+	rw_exit(&dn->dn_struct_rwlock);
+
+	if (err == 0)
+		err = dmu_read_uio_copy(dbp, nblks, uio, size);
+	dmu_buf_rele_array(dbp, nblks, FTAG);
+
+	return (err);
+}
+
+/*
+ * Read whole blocks of an object for direct I/O, straight from disk into a
+ * private buffer and then into the uio, without caching them in the ARC or
+ * the dbuf cache.  Blocks which have a dbuf, and so may have newer or dirty
+ * contents, are read through it instead, which keeps direct reads coherent
+ * with buffered writes.  The range must be block aligned; ENOTSUP is
+ * returned for ranges and objects this cannot handle, such as unaligned
+ * ranges and encrypted datasets, and the caller falls back to
+ * dmu_read_uio_dnode().  The caller must keep the range from being
+ * written, e.g. with a range lock.
+ */
+int
+dmu_read_uio_direct(dnode_t *dn, zfs_uio_t *uio, uint64_t size)
+{
+	objset_t *os = dn->dn_objset;
+	spa_t *spa = os->os_spa;
+	uint64_t offset = zfs_uio_offset(uio);
+	uint64_t blksz, blkid, nblks, i;
+	abd_t **abds;
+	zio_t *rio;
+	int err = 0;
+
+	if (os->os_encrypted || dn->dn_datablkshift == 0 || size == 0)
+		return (SET_ERROR(ENOTSUP));
+
+	blksz = dn->dn_datablksz;
+	if (P2PHASE(offset, blksz) != 0 || P2PHASE(size, blksz) != 0)
+		return (SET_ERROR(ENOTSUP));
+
+	blkid = offset >> dn->dn_datablkshift;
+	nblks = size >> dn->dn_datablkshift;
+	abds = kmem_zalloc(nblks * sizeof (abd_t *), KM_SLEEP);
+
+	/*
+	 * A NULL entry is read through its dbuf, holes and freed blocks are
+	 * zero filled.
+	 */
+	rio = zio_root(spa, NULL, NULL, ZIO_FLAG_CANFAIL);
+	rw_enter(&dn->dn_struct_rwlock, RW_READER);
+	for (i = 0; i < nblks; i++) {
+		dmu_buf_impl_t *db;
+		zbookmark_phys_t zb;
+		blkptr_t bp;
+
+		db = dbuf_find(os, dn->dn_object, 0, blkid + i);
+		if (db != NULL) {
+			mutex_exit(&db->db_mtx);
+			continue;
+		}
+
+		/*
+		 * Blocks freed in a txg which has not synced yet still have
+		 * their old bp, they must read as zeros like holes do; see
+		 * dbuf_read_hole().
+		 */
+		if (dbuf_dnode_findbp(dn, 0, blkid + i, &bp, NULL, NULL) != 0 ||
+		    BP_IS_HOLE(&bp) || dnode_block_freed(dn, blkid + i)) {
+			abds[i] = abd_alloc_linear(blksz, B_FALSE);
+			abd_zero(abds[i], blksz);
+			continue;
+		}
+		if (BP_IS_EMBEDDED(&bp) || BP_GET_LSIZE(&bp) != blksz)
+			continue;
+
+		abds[i] = abd_alloc_linear(blksz, B_FALSE);
+		SET_BOOKMARK(&zb, dmu_objset_id(os), dn->dn_object, 0,
+		    blkid + i);
+		zio_nowait(zio_read(rio, spa, &bp, abds[i], blksz, NULL, NULL,
+		    ZIO_PRIORITY_SYNC_READ, ZIO_FLAG_CANFAIL, &zb));
+
+		/*
+		 * Charge the read like arc_read() does for a miss; blocks
+		 * read through their dbuf are charged there.
+		 */
+		zfs_racct_read(blksz, 1);
+	}
+	rw_exit(&dn->dn_struct_rwlock);
+	err = zio_wait(rio);
+
+	for (i = 0; i < nblks; i++) {
+		if (err == 0 && abds[i] == NULL) {
+			err = dmu_read_uio_dnode(dn, uio, blksz);
+		} else if (err == 0) {
+			err = zfs_uio_fault_move(abd_to_buf(abds[i]), blksz,
+			    UIO_READ, uio);
+		}
+		if (abds[i] != NULL)
+			abd_free(abds[i]);
+	}
+	kmem_free(abds, nblks * sizeof (abd_t *));
+
+	return (err);
+}
+
 /*
  * Read 'size' bytes into the uio buffer.
  * From object zdb->db_object.
@@ -1312,7 +1657,7 @@ dmu_write_uio_dnode(dnode_t *dn, zfs_uio_t *uio, uint64_t size, dmu_tx_t *tx)
 		if (tocpy == db->db_size)
 			dmu_buf_will_fill(db, tx);
 		else
-			dmu_buf_will_dirty(db, tx);
+			dmu_buf_will_dirty_range(db, bufoff, tocpy, tx);
 
 		/*
 		 * XXX zfs_uiomove could block forever (eg.nfs-backed
@@ -1443,9 +1788,9 @@ dmu_lightweight_write_by_dnode(dnode_t *dn, uint64_t offset, abd_t *abd,
  * If this is not possible copy the contents of passed arc buf via
  * dmu_write().
  */
-int
-dmu_assign_arcbuf_by_dnode(dnode_t *dn, uint64_t offset, arc_buf_t *buf,
-    dmu_tx_t *tx)
+static int
+dmu_assign_arcbuf_impl(dnode_t *dn, uint64_t offset, arc_buf_t *buf,
+    boolean_t uncached, dmu_tx_t *tx)
 {
 	dmu_buf_impl_t *db;
 	objset_t *os = dn->dn_objset;
@@ -1467,6 +1812,11 @@ dmu_assign_arcbuf_by_dnode(dnode_t *dn, uint64_t offset, arc_buf_t *buf,
 	if (offset == db->db.db_offset && blksz == db->db.db_size) {
 		zfs_racct_write(blksz, 1);
 		dbuf_assign_arcbuf(db, buf, tx);
+		if (uncached) {
+			mutex_enter(&db->db_mtx);
+			db->db_uncached = TRUE;
+			mutex_exit(&db->db_mtx);
+		}
 		dbuf_rele(db, FTAG);
 	} else {
 		/* compressed bufs must always be assignable to their dbuf */
@@ -1481,6 +1831,32 @@ dmu_assign_arcbuf_by_dnode(dnode_t *dn, uint64_t offset, arc_buf_t *buf,
 	return (0);
 }
 
+int
+dmu_assign_arcbuf_by_dnode(dnode_t *dn, uint64_t offset, arc_buf_t *buf,
+    dmu_tx_t *tx)
+{
+	return (dmu_assign_arcbuf_impl(dn, offset, buf, B_FALSE, tx));
+}
+
+/*
+ * Assign a loaned ARC buffer for a direct I/O write.  The block is written
+ * out with the txg like any other, but the dbuf and its ARC buffer are
+ * evicted once they are clean and unreferenced rather than being cached.
+ */
+int
+dmu_assign_arcbuf_direct(dmu_buf_t *handle, uint64_t offset, arc_buf_t *buf,
+    dmu_tx_t *tx)
+{
+	int err;
+	dmu_buf_impl_t *dbuf = (dmu_buf_impl_t *)handle;
+
+	DB_DNODE_ENTER(dbuf);
+	err = dmu_assign_arcbuf_impl(DB_DNODE(dbuf), offset, buf, B_TRUE, tx);
+	DB_DNODE_EXIT(dbuf);
+
+	return (err);
+}
+
 int
 dmu_assign_arcbuf_by_dbuf(dmu_buf_t *handle, uint64_t offset, arc_buf_t *buf,
     dmu_tx_t *tx)
@@ -1495,6 +1871,101 @@ dmu_assign_arcbuf_by_dbuf(dmu_buf_t *handle, uint64_t offset, arc_buf_t *buf,
 	return (err);
 }
 
+static void
+dmu_write_direct_ready(zio_t *zio)
+{
+	blkptr_t *bp = zio->io_bp;
+
+	if (zio->io_error == 0) {
+		if (BP_IS_HOLE(bp)) {
+			/* The block size still needs to be known for replay. */
+			BP_SET_LSIZE(bp, zio->io_lsize);
+		} else if (!BP_IS_EMBEDDED(bp)) {
+			ASSERT(BP_GET_LEVEL(bp) == 0);
+			BP_SET_FILL(bp, 1);
+		}
+	}
+}
+
+/*
+ * Write a whole block of an object straight from the caller's ABD, e.g.
+ * one built over pinned user pages, without copying it into a buffer of
+ * its own.  The block is written out right away and its block pointer
+ * becomes the contents of the block in this txg, the way dmu_sync()
+ * overrides a dirty buffer; the data only has to stay put until this
+ * returns.  ENOTSUP is returned, and nothing is changed, for blocks and
+ * objects this cannot handle: unaligned or partial blocks, blocks whose
+ * dbuf holds data, and encrypted or deduplicated datasets.  The caller
+ * then falls back to a regular write.  The caller must keep the block
+ * from being read or written, e.g. with a range lock.
+ */
+int
+dmu_write_direct(dnode_t *dn, uint64_t offset, abd_t *data, dmu_tx_t *tx)
+{
+	objset_t *os = dn->dn_objset;
+	spa_t *spa = os->os_spa;
+	uint64_t txg = dmu_tx_get_txg(tx);
+	uint64_t size = abd_get_size(data);
+	dmu_buf_impl_t *db;
+	zbookmark_phys_t zb;
+	zio_bad_cksum_t zbc;
+	zio_prop_t zp;
+	blkptr_t bp;
+	int err;
+
+	if (os->os_encrypted || txg > spa_freeze_txg(spa))
+		return (SET_ERROR(ENOTSUP));
+
+	rw_enter(&dn->dn_struct_rwlock, RW_READER);
+	db = dbuf_hold(dn, dbuf_whichblock(dn, 0, offset), FTAG);
+	rw_exit(&dn->dn_struct_rwlock);
+	if (db == NULL)
+		return (SET_ERROR(EIO));
+
+	dmu_write_policy(os, dn, 0, WP_DMU_SYNC, &zp);
+	zp.zp_nopwrite = B_FALSE;
+
+	if (offset != db->db.db_offset || size != db->db.db_size ||
+	    zp.zp_dedup || !dbuf_direct_ok(db, tx)) {
+		dbuf_rele(db, FTAG);
+		return (SET_ERROR(ENOTSUP));
+	}
+
+	SET_BOOKMARK(&zb, dmu_objset_id(os), dn->dn_object, 0, db->db_blkid);
+	BP_ZERO(&bp);
+	err = zio_wait(zio_write(NULL, spa, txg, &bp, data, size, size, &zp,
+	    dmu_write_direct_ready, NULL, NULL, NULL, NULL,
+	    ZIO_PRIORITY_SYNC_WRITE, ZIO_FLAG_CANFAIL, &zb));
+	if (err != 0) {
+		dbuf_rele(db, FTAG);
+		return (SET_ERROR(ENOTSUP));
+	}
+	if (BP_IS_HOLE(&bp) && bp.blk_birth == 0)
+		BP_ZERO(&bp);
+
+	/*
+	 * The data may have been changed by someone else while it was being
+	 * written, in which case the checksum of an uncompressed block does
+	 * not match what is on disk.  Give up on such blocks.
+	 */
+	if (!BP_IS_HOLE(&bp) && !BP_IS_EMBEDDED(&bp) &&
+	    BP_GET_COMPRESS(&bp) == ZIO_COMPRESS_OFF &&
+	    zio_checksum_error_impl(spa, &bp, BP_GET_CHECKSUM(&bp), data,
+	    size, 0, &zbc) != 0)
+		err = SET_ERROR(ENOTSUP);
+
+	if (err == 0 && dbuf_assign_direct(db, &bp, zp.zp_copies, tx)) {
+		zfs_racct_write(size, 1);
+	} else {
+		if (!BP_IS_HOLE(&bp))
+			zio_free(spa, txg, &bp);
+		err = SET_ERROR(ENOTSUP);
+	}
+	dbuf_rele(db, FTAG);
+
+	return (err);
+}
+
 typedef struct {
 	dbuf_dirty_record_t	*dsa_dr;
 	dmu_sync_cb_t		*dsa_done;
@@ -1730,12 +2201,44 @@ dmu_sync(zio_t *pio, uint64_t txg, dmu_sync_cb_t *done, zgd_t *zgd)
 	dmu_write_policy(os, dn, db->db_level, WP_DMU_SYNC, &zp);
 	DB_DNODE_EXIT(db);
 
+	/*
+	 * A block written by dmu_write_direct() is on disk already; just
+	 * log its block pointer.  The dbuf may not have been read then, so
+	 * if the block has synced out since, the caller waits for the txg.
+	 */
+	mutex_enter(&db->db_mtx);
+	dr = dbuf_find_dirty_eq(db, txg);
+	if (dr != NULL && dr->dt.dl.dr_direct) {
+		*zgd->zgd_bp = dr->dt.dl.dr_overridden_by;
+		if (BP_IS_HOLE(zgd->zgd_bp))
+			BP_SET_LSIZE(zgd->zgd_bp, db->db.db_size);
+		mutex_exit(&db->db_mtx);
+		zil_lwb_add_block(zgd->zgd_lwb, zgd->zgd_bp);
+		done(zgd, 0);
+		return (0);
+	}
+	if (db->db.db_data == NULL) {
+		mutex_exit(&db->db_mtx);
+		return (SET_ERROR(EIO));
+	}
+	mutex_exit(&db->db_mtx);
+
 	/*
 	 * If we're frozen (running ziltest), we always need to generate a bp.
 	 */
 	if (txg > spa_freeze_txg(os->os_spa))
 		return (dmu_sync_late_arrival(pio, os, done, zgd, &zp, &zb));
 
+	/*
+	 * A partially overwritten block must be filled in before it can be
+	 * written.  If that fails, the caller waits for the txg to sync.
+	 */
+	mutex_enter(&db->db_mtx);
+	int err = dbuf_partial_fill(db, txg, ZIO_FLAG_CANFAIL);
+	mutex_exit(&db->db_mtx);
+	if (err != 0)
+		return (SET_ERROR(EIO));
+
 	/*
 	 * Grabbing db_mtx now provides a barrier between dbuf_sync_leaf()
 	 * and us.  If we determine that this txg is not yet syncing,
@@ -1843,7 +2346,8 @@ dmu_sync(zio_t *pio, uint64_t txg, dmu_sync_cb_t *done, zgd_t *zgd)
 	zio_nowait(arc_write(pio, os->os_spa, txg,
 	    zgd->zgd_bp, dr->dt.dl.dr_data, DBUF_IS_L2CACHEABLE(db),
 	    &zp, dmu_sync_ready, NULL, NULL, dmu_sync_done, dsa,
-	    ZIO_PRIORITY_SYNC_WRITE, ZIO_FLAG_CANFAIL, &zb));
+	    ZIO_PRIORITY_SYNC_WRITE, ZIO_FLAG_CANFAIL, &zb,
+	    os->os_arc_dataset));
 
 	return (0);
 }
@@ -2294,11 +2798,15 @@ dmu_init(void)
 	l2arc_init();
 	arc_init();
 	dbuf_init();
+	dmu_read_async_taskq = taskq_create("dmu_read_async", boot_ncpus,
+	    defclsyspri, boot_ncpus, INT_MAX,
+	    TASKQ_PREPOPULATE | TASKQ_DYNAMIC);
 }
 
 void
 dmu_fini(void)
 {
+	taskq_destroy(dmu_read_async_taskq);
 	arc_fini(); /* arc depends on l2arc, so arc must go first */
 	l2arc_fini();
 	dmu_tx_fini();
@@ -2315,7 +2823,9 @@ EXPORT_SYMBOL(dmu_bonus_hold);
 EXPORT_SYMBOL(dmu_bonus_hold_by_dnode);
 EXPORT_SYMBOL(dmu_buf_hold_array_by_bonus);
 EXPORT_SYMBOL(dmu_buf_rele_array);
+EXPORT_SYMBOL(dmu_read_async_dnode);
 EXPORT_SYMBOL(dmu_prefetch);
+EXPORT_SYMBOL(dmu_prefetch_hint);
 EXPORT_SYMBOL(dmu_free_range);
 EXPORT_SYMBOL(dmu_free_long_range);
 EXPORT_SYMBOL(dmu_free_long_object);
@@ -2341,6 +2851,8 @@ EXPORT_SYMBOL(dmu_request_arcbuf);
 EXPORT_SYMBOL(dmu_return_arcbuf);
 EXPORT_SYMBOL(dmu_assign_arcbuf_by_dnode);
 EXPORT_SYMBOL(dmu_assign_arcbuf_by_dbuf);
+EXPORT_SYMBOL(dmu_assign_arcbuf_direct);
+EXPORT_SYMBOL(dmu_write_direct);
 EXPORT_SYMBOL(dmu_buf_hold);
 EXPORT_SYMBOL(dmu_ot);
 
@@ -241,11 +241,57 @@ primary_cache_changed_cb(void *arg, uint64_t newval)
 	 * Inheritance and range checking should have been done by now.
 	 */
 	ASSERT(newval == ZFS_CACHE_ALL || newval == ZFS_CACHE_NONE ||
-	    newval == ZFS_CACHE_METADATA);
+	    newval == ZFS_CACHE_METADATA || newval == ZFS_CACHE_UNCACHED);
 
 	os->os_primary_cache = newval;
 }
 
+static void
+arc_quota_changed_cb(void *arg, uint64_t newval)
+{
+	objset_t *os = arg;
+
+	arc_dataset_set_quota(os->os_arc_dataset, newval);
+}
+
+static void
+arc_reservation_changed_cb(void *arg, uint64_t newval)
+{
+	objset_t *os = arg;
+
+	arc_dataset_set_reservation(os->os_arc_dataset, newval);
+}
+
+static void
+l2arc_admit_changed_cb(void *arg, uint64_t newval)
+{
+	objset_t *os = arg;
+
+	arc_dataset_set_l2arc_admit(os->os_arc_dataset, newval);
+}
+
+static void
+prefetch_distance_changed_cb(void *arg, uint64_t newval)
+{
+	objset_t *os = arg;
+
+	os->os_prefetch_distance = newval;
+}
+
+static void
+direct_changed_cb(void *arg, uint64_t newval)
+{
+	objset_t *os = arg;
+
+	/*
+	 * Inheritance and range checking should have been done by now.
+	 */
+	ASSERT(newval == ZFS_DIRECT_DISABLED ||
+	    newval == ZFS_DIRECT_STANDARD || newval == ZFS_DIRECT_ALWAYS);
+
+	os->os_direct = newval;
+}
+
 static void
 secondary_cache_changed_cb(void *arg, uint64_t newval)
 {
@@ -521,6 +567,11 @@ dmu_objset_open_impl(spa_t *spa, dsl_dataset_t *ds, blkptr_t *bp,
 			    zfs_prop_to_name(ZFS_PROP_SECONDARYCACHE),
 			    secondary_cache_changed_cb, os);
 		}
+		if (err == 0) {
+			err = dsl_prop_register(ds,
+			    zfs_prop_to_name(ZFS_PROP_DIRECT),
+			    direct_changed_cb, os);
+		}
 		if (!ds->ds_is_snapshot) {
 			if (err == 0) {
 				err = dsl_prop_register(ds,
@@ -574,8 +625,33 @@ dmu_objset_open_impl(spa_t *spa, dsl_dataset_t *ds, blkptr_t *bp,
 				    ZFS_PROP_SPECIAL_SMALL_BLOCKS),
 				    smallblk_changed_cb, os);
 			}
+			if (err == 0) {
+				os->os_arc_dataset =
+				    arc_dataset_register(spa, ds->ds_object);
+				err = dsl_prop_register(ds,
+				    zfs_prop_to_name(ZFS_PROP_ARC_QUOTA),
+				    arc_quota_changed_cb, os);
+			}
+			if (err == 0) {
+				err = dsl_prop_register(ds,
+				    zfs_prop_to_name(ZFS_PROP_ARC_RESERVATION),
+				    arc_reservation_changed_cb, os);
+			}
+			if (err == 0) {
+				err = dsl_prop_register(ds,
+				    zfs_prop_to_name(ZFS_PROP_L2ARC_ADMIT),
+				    l2arc_admit_changed_cb, os);
+			}
+			if (err == 0) {
+				err = dsl_prop_register(ds,
+				    zfs_prop_to_name(
+				    ZFS_PROP_PREFETCH_DISTANCE),
+				    prefetch_distance_changed_cb, os);
+			}
 		}
 		if (err != 0) {
+			if (os->os_arc_dataset != NULL)
+				arc_dataset_unregister(os->os_arc_dataset);
 			arc_buf_destroy(os->os_phys_buf, &os->os_phys_buf);
 			kmem_free(os, sizeof (objset_t));
 			return (err);
@@ -616,6 +692,7 @@ dmu_objset_open_impl(spa_t *spa, dsl_dataset_t *ds, blkptr_t *bp,
 	mutex_init(&os->os_userused_lock, NULL, MUTEX_DEFAULT, NULL);
 	mutex_init(&os->os_obj_lock, NULL, MUTEX_DEFAULT, NULL);
 	mutex_init(&os->os_user_ptr_lock, NULL, MUTEX_DEFAULT, NULL);
+	dnode_hold_cache_init(&os->os_dnode_hold_cache);
 	os->os_obj_next_percpu_len = boot_ncpus;
 	os->os_obj_next_percpu = kmem_zalloc(os->os_obj_next_percpu_len *
 	    sizeof (os->os_obj_next_percpu[0]), KM_SLEEP);
@@ -884,6 +961,9 @@ dmu_objset_evict_dbufs(objset_t *os)
 	dnode_t *dn_marker;
 	dnode_t *dn;
 
+	/* Release the dnode hold cache's holds so the dnodes can go. */
+	dnode_hold_cache_purge(&os->os_dnode_hold_cache);
+
 	dn_marker = kmem_alloc(sizeof (dnode_t), KM_SLEEP);
 
 	mutex_enter(&os->os_lock);
@@ -977,6 +1057,8 @@ dmu_objset_evict_done(objset_t *os)
 	zil_free(os->os_zil);
 
 	arc_buf_destroy(os->os_phys_buf, &os->os_phys_buf);
+	if (os->os_arc_dataset != NULL)
+		arc_dataset_unregister(os->os_arc_dataset);
 
 	/*
 	 * This is a barrier to prevent the objset from going away in
@@ -995,6 +1077,7 @@ dmu_objset_evict_done(objset_t *os)
 	mutex_destroy(&os->os_obj_lock);
 	mutex_destroy(&os->os_user_ptr_lock);
 	mutex_destroy(&os->os_upgrade_lock);
+	dnode_hold_cache_fini(&os->os_dnode_hold_cache);
 	for (int i = 0; i < TXG_SIZE; i++) {
 		multilist_destroy(os->os_dirty_dnodes[i]);
 	}
@@ -1658,7 +1741,8 @@ dmu_objset_sync(objset_t *os, zio_t *pio, dmu_tx_t *tx)
 	zio = arc_write(pio, os->os_spa, tx->tx_txg,
 	    blkptr_copy, os->os_phys_buf, DMU_OS_IS_L2CACHEABLE(os),
 	    &zp, dmu_objset_write_ready, NULL, NULL, dmu_objset_write_done,
-	    os, ZIO_PRIORITY_ASYNC_WRITE, ZIO_FLAG_MUSTSUCCEED, &zb);
+	    os, ZIO_PRIORITY_ASYNC_WRITE, ZIO_FLAG_MUSTSUCCEED, &zb,
+	    os->os_arc_dataset);
 
 	/*
 	 * Sync special dnodes - the parent IO for the sync is the root block
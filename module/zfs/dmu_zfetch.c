@@ -48,18 +48,41 @@ int zfs_prefetch_disable = B_FALSE;
 unsigned int	zfetch_max_streams = 8;
 /* min time before stream reclaim */
 unsigned int	zfetch_min_sec_reap = 2;
+/* min bytes to prefetch per stream (default 4MB) */
+unsigned int	zfetch_min_distance = 4 * 1024 * 1024;
 /* max bytes to prefetch per stream (default 8MB) */
 unsigned int	zfetch_max_distance = 8 * 1024 * 1024;
 /* max bytes to prefetch indirects for per stream (default 64MB) */
 unsigned int	zfetch_max_idistance = 64 * 1024 * 1024;
 /* max number of bytes in an array_read in which we allow prefetching (1MB) */
 unsigned long	zfetch_array_rd_sz = 1024 * 1024;
+/* detect strided and backward streams */
+int		zfetch_detect_stride = B_TRUE;
 
 typedef struct zfetch_stats {
 	kstat_named_t zfetchstat_hits;
 	kstat_named_t zfetchstat_misses;
 	kstat_named_t zfetchstat_max_streams;
 	kstat_named_t zfetchstat_io_issued;
+	/*
+	 * Accesses predicted by strided and backward streams, and those of
+	 * them which still missed the cache (the prefetch came too late).
+	 * The hits and misses above count accesses of all stream types.
+	 */
+	kstat_named_t zfetchstat_stride_hits;
+	kstat_named_t zfetchstat_stride_misses;
+	kstat_named_t zfetchstat_backward_hits;
+	kstat_named_t zfetchstat_backward_misses;
+	/*
+	 * Current number of streams and the sum of their data prefetch
+	 * distances in bytes, and how often a distance was grown because
+	 * prefetched blocks arrived too late or shrunk because they all
+	 * arrived in time.
+	 */
+	kstat_named_t zfetchstat_streams;
+	kstat_named_t zfetchstat_distance;
+	kstat_named_t zfetchstat_distance_grown;
+	kstat_named_t zfetchstat_distance_shrunk;
 } zfetch_stats_t;
 
 static zfetch_stats_t zfetch_stats = {
@@ -67,6 +90,14 @@ static zfetch_stats_t zfetch_stats = {
 	{ "misses",			KSTAT_DATA_UINT64 },
 	{ "max_streams",		KSTAT_DATA_UINT64 },
 	{ "io_issued",		KSTAT_DATA_UINT64 },
+	{ "stride_hits",		KSTAT_DATA_UINT64 },
+	{ "stride_misses",		KSTAT_DATA_UINT64 },
+	{ "backward_hits",		KSTAT_DATA_UINT64 },
+	{ "backward_misses",		KSTAT_DATA_UINT64 },
+	{ "streams",			KSTAT_DATA_UINT64 },
+	{ "distance",			KSTAT_DATA_UINT64 },
+	{ "distance_grown",		KSTAT_DATA_UINT64 },
+	{ "distance_shrunk",		KSTAT_DATA_UINT64 },
 };
 
 #define	ZFETCHSTAT_BUMP(stat) \
@@ -115,6 +146,9 @@ dmu_zfetch_init(zfetch_t *zf, dnode_t *dno)
 		return;
 	zf->zf_dnode = dno;
 	zf->zf_numstreams = 0;
+	zf->zf_lastmiss = 0;
+	zf->zf_lastdelta = 0;
+	zf->zf_hint = DMU_PREFETCH_NORMAL;
 
 	list_create(&zf->zf_stream, sizeof (zstream_t),
 	    offsetof(zstream_t, zs_node));
@@ -122,6 +156,37 @@ dmu_zfetch_init(zfetch_t *zf, dnode_t *dno)
 	mutex_init(&zf->zf_lock, NULL, MUTEX_DEFAULT, NULL);
 }
 
+/*
+ * Account for streams being created or removed and for changes of their
+ * prefetch distances, globally and for the dataset the object belongs to.
+ */
+static void
+dmu_zfetch_stream_account(zfetch_t *zf, int64_t streams, int64_t distance)
+{
+	if (streams != 0)
+		ZFETCHSTAT_ADD(zfetchstat_streams, streams);
+	if (distance != 0)
+		ZFETCHSTAT_ADD(zfetchstat_distance, distance);
+	arc_dataset_prefetch_update(zf->zf_dnode->dn_objset->os_arc_dataset,
+	    streams, distance);
+}
+
+/*
+ * The most bytes a stream of this object may prefetch ahead of the reader:
+ * the prefetch_distance property of the dataset, if set, or else
+ * zfetch_max_distance.  The property is bounded by zfetch_max_idistance,
+ * since indirect blocks are never prefetched less far ahead than data.
+ */
+static uint32_t
+dmu_zfetch_max_distance(zfetch_t *zf)
+{
+	uint64_t max = zf->zf_dnode->dn_objset->os_prefetch_distance;
+
+	if (max == 0)
+		return (zfetch_max_distance);
+	return (MIN(max, zfetch_max_idistance));
+}
+
 static void
 dmu_zfetch_stream_fini(zstream_t *zs)
 {
@@ -135,6 +200,7 @@ dmu_zfetch_stream_remove(zfetch_t *zf, zstream_t *zs)
 	ASSERT(MUTEX_HELD(&zf->zf_lock));
 	list_remove(&zf->zf_stream, zs);
 	zf->zf_numstreams--;
+	dmu_zfetch_stream_account(zf, -1, -(int64_t)zs->zs_pf_dist);
 	membar_producer();
 	if (zfs_refcount_remove(&zs->zs_refs, NULL) == 0)
 		dmu_zfetch_stream_fini(zs);
@@ -159,13 +225,39 @@ dmu_zfetch_fini(zfetch_t *zf)
 	zf->zf_dnode = NULL;
 }
 
+/*
+ * Apply an access pattern hint from the consumer.  A random hint stops
+ * predictive prefetch for the object and drops its streams, a sequential
+ * hint makes every stream prefetch zfetch_max_distance ahead as soon as
+ * it is detected, even before it has seen a cache miss.
+ */
+void
+dmu_zfetch_set_hint(zfetch_t *zf, dmu_prefetch_hint_t hint)
+{
+	zstream_t *zs;
+
+	mutex_enter(&zf->zf_lock);
+	zf->zf_hint = hint;
+	if (hint == DMU_PREFETCH_RANDOM) {
+		while ((zs = list_head(&zf->zf_stream)) != NULL)
+			dmu_zfetch_stream_remove(zf, zs);
+	}
+	mutex_exit(&zf->zf_lock);
+}
+
+/*
+ * A strided stream whose accesses are adjacent and go backwards.
+ */
+#define	ZS_BACKWARD(zs)	((zs)->zs_stride == -(int64_t)(zs)->zs_nblks)
+
 /*
  * If there aren't too many streams already, create a new stream.
  * The "blkid" argument is the next block that we expect this stream to access.
  * While we're here, clean up old streams (which haven't been
  * accessed for at least zfetch_min_sec_reap seconds).
+ * Returns the new stream, or NULL if there are too many.
  */
-static void
+static zstream_t *
 dmu_zfetch_stream_create(zfetch_t *zf, uint64_t blkid)
 {
 	zstream_t *zs_next;
@@ -202,7 +294,7 @@ dmu_zfetch_stream_create(zfetch_t *zf, uint64_t blkid)
 	    zfetch_max_distance));
 	if (zf->zf_numstreams >= max_streams) {
 		ZFETCHSTAT_BUMP(zfetchstat_max_streams);
-		return;
+		return (NULL);
 	}
 
 	zstream_t *zs = kmem_zalloc(sizeof (*zs), KM_SLEEP);
@@ -220,6 +312,138 @@ dmu_zfetch_stream_create(zfetch_t *zf, uint64_t blkid)
 	zfs_refcount_add(&zs->zs_refs, NULL);
 	zf->zf_numstreams++;
 	list_insert_head(&zf->zf_stream, zs);
+	dmu_zfetch_stream_account(zf, 1, 0);
+	return (zs);
+}
+
+/*
+ * Called for an access that matched no stream.  If it is the same distance
+ * from the previous unmatched access as that one was from the one before,
+ * start a strided stream expecting the next access that distance further
+ * on.  Adjacent forward accesses are left to the sequential streams.
+ * Returns B_TRUE if a strided stream was created.
+ */
+static boolean_t
+dmu_zfetch_stride_detect(zfetch_t *zf, uint64_t blkid, uint64_t nblks,
+    uint64_t maxblkid)
+{
+	int64_t delta = (int64_t)(blkid - zf->zf_lastmiss);
+	boolean_t match = (delta == zf->zf_lastdelta);
+	zstream_t *zs;
+
+	ASSERT(MUTEX_HELD(&zf->zf_lock));
+
+	zf->zf_lastmiss = blkid;
+	zf->zf_lastdelta = delta;
+
+	if (!zfetch_detect_stride || !match || delta == (int64_t)nblks ||
+	    ABS(delta) < (int64_t)nblks)
+		return (B_FALSE);
+	if ((int64_t)blkid + delta < 0 ||
+	    (int64_t)blkid + delta > (int64_t)maxblkid)
+		return (B_FALSE);
+
+	zs = dmu_zfetch_stream_create(zf, blkid + delta);
+	if (zs == NULL)
+		return (B_FALSE);
+	zs->zs_stride = delta;
+	zs->zs_nblks = nblks;
+	return (B_TRUE);
+}
+
+/*
+ * Advance a strided stream past the access at blkid and extend the range
+ * of accesses to prefetch, doubling the number of accesses ahead of the
+ * reader up to zfetch_max_distance.  Returns B_FALSE if the next access
+ * would fall outside the object, in which case the stream is removed.
+ */
+static boolean_t
+dmu_zfetch_stride_update(zfetch_t *zf, zstream_t *zs, uint64_t blkid,
+    uint64_t maxblkid)
+{
+	int64_t stride = zs->zs_stride;
+	int64_t next = (int64_t)blkid + stride;
+	int64_t ahead, target, limit, max_acc;
+
+	ASSERT(MUTEX_HELD(&zf->zf_lock));
+
+	if (ZS_BACKWARD(zs))
+		ZFETCHSTAT_BUMP(zfetchstat_backward_hits);
+	else
+		ZFETCHSTAT_BUMP(zfetchstat_stride_hits);
+
+	if (next < 0 || next > (int64_t)maxblkid) {
+		dmu_zfetch_stream_remove(zf, zs);
+		return (B_FALSE);
+	}
+	zs->zs_blkid = next;
+
+	/*
+	 * All positions lie on the stream's lattice, so these divisions are
+	 * exact, and a negative result means the position is behind.
+	 */
+	if ((int64_t)(zs->zs_pf_blkid1 - next) / stride < 0)
+		zs->zs_pf_blkid1 = next;
+	ahead = (int64_t)(zs->zs_pf_blkid - next) / stride;
+	if (ahead < 0) {
+		zs->zs_pf_blkid = next;
+		ahead = 0;
+	}
+
+	max_acc = MAX(1, (dmu_zfetch_max_distance(zf) >>
+	    zf->zf_dnode->dn_datablkshift) / zs->zs_nblks);
+	limit = (stride > 0) ? ((int64_t)maxblkid - next) / stride + 1 :
+	    next / -stride + 1;
+	if (zf->zf_hint == DMU_PREFETCH_SEQUENTIAL)
+		target = MIN(max_acc, limit);
+	else
+		target = MIN(MIN(2 * (ahead + 1), max_acc), limit);
+	if (target > ahead)
+		zs->zs_pf_blkid = next + target * stride;
+	return (B_TRUE);
+}
+
+/*
+ * Adapt the data prefetch distance of a sequential stream on a hit by an
+ * access of nbytes.  The first hit prefetches twice the access, and the
+ * distance then doubles on every hit until it reaches zfetch_min_distance.
+ * Beyond that it only doubles if a read of the stream missed the cache
+ * since the last hit, meaning the prefetch did not arrive in time, and
+ * shrinks by an eighth once a whole distance worth of accesses hit, so
+ * that streams which are ahead of their reader give back memory.  The
+ * distance is capped by dmu_zfetch_max_distance().
+ */
+static void
+dmu_zfetch_adapt(zfetch_t *zf, zstream_t *zs, uint32_t nbytes)
+{
+	uint32_t max = dmu_zfetch_max_distance(zf);
+	uint32_t dist = zs->zs_pf_dist;
+
+	ASSERT(MUTEX_HELD(&zf->zf_lock));
+
+	if (zf->zf_hint == DMU_PREFETCH_SEQUENTIAL) {
+		dist = max;
+	} else if (dist == 0) {
+		dist = 2 * nbytes;
+	} else if (zs->zs_late) {
+		dist = 2 * MIN(dist, max);
+		ZFETCHSTAT_BUMP(zfetchstat_distance_grown);
+	} else if (dist < zfetch_min_distance) {
+		dist *= 2;
+	} else if (++zs->zs_pf_hits >= dist / nbytes &&
+	    dist > zfetch_min_distance) {
+		dist = MAX(dist - dist / 8, zfetch_min_distance);
+		ZFETCHSTAT_BUMP(zfetchstat_distance_shrunk);
+	}
+	dist = MIN(MAX(dist, nbytes), MAX(max, nbytes));
+	zs->zs_late = B_FALSE;
+
+	if (dist != zs->zs_pf_dist) {
+		dmu_zfetch_stream_account(zf, 0,
+		    (int64_t)dist - (int64_t)zs->zs_pf_dist);
+		zs->zs_pf_dist = dist;
+		zs->zs_pf_hits = 0;
+	}
 }
 
 static void
@@ -255,7 +479,7 @@ dmu_zfetch_prepare(zfetch_t *zf, uint64_t blkid, uint64_t nblks,
 	end_of_access_blkid = blkid + nblks;
 	spa_t *spa = zf->zf_dnode->dn_objset->os_spa;
 
-	if (zfs_prefetch_disable)
+	if (zfs_prefetch_disable || zf->zf_hint == DMU_PREFETCH_RANDOM)
 		return (NULL);
 	/*
 	 * If we haven't yet loaded the indirect vdevs' mappings, we
@@ -298,6 +522,8 @@ dmu_zfetch_prepare(zfetch_t *zf, uint64_t blkid, uint64_t nblks,
 	    zs = list_next(&zf->zf_stream, zs)) {
 		if (blkid == zs->zs_blkid) {
 			break;
+		} else if (zs->zs_stride != 0) {
+			continue;
 		} else if (blkid + 1 == zs->zs_blkid) {
 			blkid++;
 			nblks--;
@@ -329,9 +555,12 @@ dmu_zfetch_prepare(zfetch_t *zf, uint64_t blkid, uint64_t nblks,
 	if (zs == NULL) {
 		/*
 		 * This access is not part of any existing stream.  Create
-		 * a new stream for it.
+		 * a new strided stream if it continues a pattern of
+		 * unmatched accesses, or a new sequential stream otherwise.
 		 */
-		dmu_zfetch_stream_create(zf, end_of_access_blkid);
+		if (!dmu_zfetch_stride_detect(zf, blkid, nblks, maxblkid))
+			(void) dmu_zfetch_stream_create(zf,
+			    end_of_access_blkid);
 		mutex_exit(&zf->zf_lock);
 		if (!have_lock)
 			rw_exit(&zf->zf_dnode->dn_struct_rwlock);
@@ -339,6 +568,18 @@ dmu_zfetch_prepare(zfetch_t *zf, uint64_t blkid, uint64_t nblks,
 		return (NULL);
 	}
 
+	if (zs->zs_stride != 0) {
+		if (!dmu_zfetch_stride_update(zf, zs, blkid, maxblkid) ||
+		    !fetch_data) {
+			mutex_exit(&zf->zf_lock);
+			if (!have_lock)
+				rw_exit(&zf->zf_dnode->dn_struct_rwlock);
+			ZFETCHSTAT_BUMP(zfetchstat_hits);
+			return (NULL);
+		}
+		goto out;
+	}
+
 	/*
 	 * This access was to a block that we issued a prefetch for on
 	 * behalf of this stream. Issue further prefetches for this stream.
@@ -356,21 +597,15 @@ dmu_zfetch_prepare(zfetch_t *zf, uint64_t blkid, uint64_t nblks,
 		zs->zs_ipf_blkid1 = end_of_access_blkid;
 
 	/*
-	 * Double our amount of prefetched data, but don't let the
-	 * prefetch get further ahead than zfetch_max_distance.
+	 * Prefetch data up to the stream's current distance past the end
+	 * of this access, see dmu_zfetch_adapt().
 	 */
 	if (fetch_data) {
-		max_dist_blks =
-		    zfetch_max_distance >> zf->zf_dnode->dn_datablkshift;
-		/*
-		 * Previously, we were (zs_pf_blkid - blkid) ahead.  We
-		 * want to now be double that, so read that amount again,
-		 * plus the amount we are catching up by (i.e. the amount
-		 * read just now).
-		 */
-		pf_ahead_blks = zs->zs_pf_blkid - blkid + nblks;
-		max_blks = max_dist_blks - (pf_start - end_of_access_blkid);
-		pf_nblks = MIN(pf_ahead_blks, max_blks);
+		dmu_zfetch_adapt(zf, zs,
+		    nblks << zf->zf_dnode->dn_datablkshift);
+		pf_nblks = MAX((int64_t)end_of_access_blkid +
+		    (zs->zs_pf_dist >> zf->zf_dnode->dn_datablkshift) -
+		    pf_start, 0);
 	} else {
 		pf_nblks = 0;
 	}
@@ -397,6 +632,7 @@ dmu_zfetch_prepare(zfetch_t *zf, uint64_t blkid, uint64_t nblks,
 	zs->zs_ipf_blkid = ipf_start + ipf_nblks;
 
 	zs->zs_blkid = end_of_access_blkid;
+out:
 	/* Protect the stream from reclamation. */
 	zs->zs_atime = gethrtime();
 	zfs_refcount_add(&zs->zs_refs, NULL);
@@ -416,10 +652,18 @@ dmu_zfetch_run(zstream_t *zs, boolean_t missed, boolean_t have_lock)
 {
 	zfetch_t *zf = zs->zs_fetch;
 	int64_t pf_start, pf_end, ipf_start, ipf_end;
+	int64_t stride = zs->zs_stride;
+	uint64_t nblks = zs->zs_nblks;
 	int epbs, issued;
 
-	if (missed)
+	if (missed) {
 		zs->zs_missed = missed;
+		zs->zs_late = missed;
+		if (stride != 0 && ZS_BACKWARD(zs))
+			ZFETCHSTAT_BUMP(zfetchstat_backward_misses);
+		else if (stride != 0)
+			ZFETCHSTAT_BUMP(zfetchstat_stride_misses);
+	}
 
 	/*
 	 * Postpone the prefetch if there are more concurrent callers.
@@ -434,23 +678,34 @@ dmu_zfetch_run(zstream_t *zs, boolean_t missed, boolean_t have_lock)
 	}
 
 	mutex_enter(&zf->zf_lock);
-	if (zs->zs_missed) {
+	if (zs->zs_missed || zf->zf_hint == DMU_PREFETCH_SEQUENTIAL) {
 		pf_start = zs->zs_pf_blkid1;
 		pf_end = zs->zs_pf_blkid1 = zs->zs_pf_blkid;
 	} else {
 		pf_start = pf_end = 0;
 	}
-	ipf_start = MAX(zs->zs_pf_blkid1, zs->zs_ipf_blkid1);
-	ipf_end = zs->zs_ipf_blkid1 = zs->zs_ipf_blkid;
+	if (stride != 0) {
+		/*
+		 * Strided streams prefetch whole accesses; the indirect
+		 * blocks above them are read by dbuf_prefetch_impl().
+		 */
+		ipf_start = ipf_end = 0;
+	} else {
+		ipf_start = MAX(zs->zs_pf_blkid1, zs->zs_ipf_blkid1);
+		ipf_end = zs->zs_ipf_blkid1 = zs->zs_ipf_blkid;
+	}
 	mutex_exit(&zf->zf_lock);
-	ASSERT3S(pf_start, <=, pf_end);
+	ASSERT(stride != 0 || pf_start <= pf_end);
 	ASSERT3S(ipf_start, <=, ipf_end);
 
 	epbs = zf->zf_dnode->dn_indblkshift - SPA_BLKPTRSHIFT;
 	ipf_start = P2ROUNDUP(ipf_start, 1 << epbs) >> epbs;
 	ipf_end = P2ROUNDUP(ipf_end, 1 << epbs) >> epbs;
 	ASSERT3S(ipf_start, <=, ipf_end);
-	issued = pf_end - pf_start + ipf_end - ipf_start;
+	if (stride != 0)
+		issued = (pf_end - pf_start) / stride * nblks;
+	else
+		issued = pf_end - pf_start + ipf_end - ipf_start;
 	if (issued > 1) {
 		/* More references on top of taken in dmu_zfetch_prepare(). */
 		zfs_refcount_add_many(&zs->zs_refs, issued - 1, NULL);
@@ -465,6 +720,17 @@ dmu_zfetch_run(zstream_t *zs, boolean_t missed, boolean_t have_lock)
 		rw_enter(&zf->zf_dnode->dn_struct_rwlock, RW_READER);
 
 	issued = 0;
+	if (stride != 0) {
+		for (int64_t blk = pf_start; blk != pf_end; blk += stride) {
+			for (uint64_t i = 0; i < nblks; i++) {
+				issued += dbuf_prefetch_impl(zf->zf_dnode, 0,
+				    blk + i, ZIO_PRIORITY_ASYNC_READ,
+				    ARC_FLAG_PREDICTIVE_PREFETCH,
+				    dmu_zfetch_stream_done, zs);
+			}
+		}
+		pf_start = pf_end = 0;
+	}
 	for (int64_t blk = pf_start; blk < pf_end; blk++) {
 		issued += dbuf_prefetch_impl(zf->zf_dnode, 0, blk,
 		    ZIO_PRIORITY_ASYNC_READ, ARC_FLAG_PREDICTIVE_PREFETCH,
@@ -504,6 +770,9 @@ ZFS_MODULE_PARAM(zfs_prefetch, zfetch_, max_streams, UINT, ZMOD_RW,
 ZFS_MODULE_PARAM(zfs_prefetch, zfetch_, min_sec_reap, UINT, ZMOD_RW,
 	"Min time before stream reclaim");
 
+ZFS_MODULE_PARAM(zfs_prefetch, zfetch_, min_distance, UINT, ZMOD_RW,
+	"Min bytes to prefetch per stream");
+
 ZFS_MODULE_PARAM(zfs_prefetch, zfetch_, max_distance, UINT, ZMOD_RW,
 	"Max bytes to prefetch per stream");
 
@@ -512,4 +781,7 @@ ZFS_MODULE_PARAM(zfs_prefetch, zfetch_, max_idistance, UINT, ZMOD_RW,
 
 ZFS_MODULE_PARAM(zfs_prefetch, zfetch_, array_rd_sz, ULONG, ZMOD_RW,
 	"Number of bytes in a array_read");
+
+ZFS_MODULE_PARAM(zfs_prefetch, zfetch_, detect_stride, INT, ZMOD_RW,
+	"Detect strided and backward prefetch streams");
 /* END CSTYLED */
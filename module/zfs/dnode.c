@@ -55,6 +55,10 @@ dnode_stats_t dnode_stats = {
 	{ "dnode_hold_free_lock_retry",		KSTAT_DATA_UINT64 },
 	{ "dnode_hold_free_overflow",		KSTAT_DATA_UINT64 },
 	{ "dnode_hold_free_refcount",		KSTAT_DATA_UINT64 },
+	{ "dnode_hold_cache_hits",		KSTAT_DATA_UINT64 },
+	{ "dnode_hold_cache_misses",		KSTAT_DATA_UINT64 },
+	{ "dnode_hold_cache_replaced",		KSTAT_DATA_UINT64 },
+	{ "dnode_hold_cache_dropped",		KSTAT_DATA_UINT64 },
 	{ "dnode_free_interior_lock_retry",	KSTAT_DATA_UINT64 },
 	{ "dnode_allocate",			KSTAT_DATA_UINT64 },
 	{ "dnode_reallocate",			KSTAT_DATA_UINT64 },
@@ -79,6 +83,12 @@ static dnode_phys_t dnode_phys_zero __maybe_unused;
 int zfs_default_bs = SPA_MINBLOCKSHIFT;
 int zfs_default_ibs = DN_MAX_INDBLKSHIFT;
 
+/*
+ * Number of entries in the dnode hold cache of each objset, rounded down
+ * to a power of two when the objset is opened.  0 disables the cache.
+ */
+int zfs_dnode_hold_cache_size = 256;
+
 #ifdef	_KERNEL
 static kmem_cbrc_t dnode_move(void *, void *, size_t, void *);
 #endif /* _KERNEL */
@@ -1205,6 +1215,164 @@ dnode_special_open(objset_t *os, dnode_phys_t *dnp, uint64_t object,
 	zrl_exit(&dnh->dnh_zrlock);
 }
 
+#define	DNODE_HOLD_CACHE_LOCK(dhc, idx) \
+	(&(dhc)->dhc_locks[(idx) & (DNODE_HOLD_CACHE_LOCKS - 1)])
+
+/*
+ * Called by the ARC when it needs metadata released.  The cache's holds
+ * keep its dnodes, and the dbufs and ARC buffers of their dnode blocks,
+ * from being evicted, so drop all of them; entries are cheap to refill.
+ */
+static void
+dnode_hold_cache_prune(int64_t nr_to_scan, void *arg)
+{
+	dnode_hold_cache_purge(arg);
+}
+
+void
+dnode_hold_cache_init(dnode_hold_cache_t *dhc)
+{
+	int size = zfs_dnode_hold_cache_size;
+
+	for (int i = 0; i < DNODE_HOLD_CACHE_LOCKS; i++)
+		mutex_init(&dhc->dhc_locks[i], NULL, MUTEX_DEFAULT, NULL);
+
+	dhc->dhc_mask = 0;
+	dhc->dhc_dnodes = NULL;
+	dhc->dhc_prune = NULL;
+	if (size <= 0)
+		return;
+	size = 1ULL << (highbit64(size) - 1);
+	dhc->dhc_mask = size - 1;
+	dhc->dhc_dnodes = kmem_zalloc(size * sizeof (dnode_t *), KM_SLEEP);
+	dhc->dhc_prune = arc_add_prune_callback(dnode_hold_cache_prune, dhc);
+}
+
+void
+dnode_hold_cache_fini(dnode_hold_cache_t *dhc)
+{
+	if (dhc->dhc_prune != NULL) {
+		arc_remove_prune_callback(dhc->dhc_prune);
+		dhc->dhc_prune = NULL;
+	}
+	if (dhc->dhc_dnodes != NULL) {
+		for (uint64_t i = 0; i <= dhc->dhc_mask; i++)
+			ASSERT3P(dhc->dhc_dnodes[i], ==, NULL);
+		kmem_free(dhc->dhc_dnodes,
+		    (dhc->dhc_mask + 1) * sizeof (dnode_t *));
+		dhc->dhc_dnodes = NULL;
+	}
+	for (int i = 0; i < DNODE_HOLD_CACHE_LOCKS; i++)
+		mutex_destroy(&dhc->dhc_locks[i]);
+}
+
+/*
+ * Drop every cached dnode and the cache's holds on them.  Entries can be
+ * refilled by later holds, so callers which need the dnodes released for
+ * good must prevent new holds themselves.
+ */
+void
+dnode_hold_cache_purge(dnode_hold_cache_t *dhc)
+{
+	if (dhc->dhc_dnodes == NULL)
+		return;
+
+	for (uint64_t i = 0; i <= dhc->dhc_mask; i++) {
+		kmutex_t *lock = DNODE_HOLD_CACHE_LOCK(dhc, i);
+		dnode_t *dn;
+
+		mutex_enter(lock);
+		dn = dhc->dhc_dnodes[i];
+		dhc->dhc_dnodes[i] = NULL;
+		mutex_exit(lock);
+		if (dn != NULL) {
+			DNODE_STAT_BUMP(dnode_hold_cache_dropped);
+			dnode_rele(dn, dhc);
+		}
+	}
+}
+
+/*
+ * Look up an allocated object in the dnode hold cache and add a hold on
+ * it.  The cache's own hold keeps the dnode in place, so this neither
+ * touches the meta dnode nor the dnode handle.  Objects freed since they
+ * were cached are left to the slow path to report.
+ */
+static dnode_t *
+dnode_hold_cache_lookup(dnode_hold_cache_t *dhc, uint64_t object, void *tag)
+{
+	uint64_t idx = object & dhc->dhc_mask;
+	kmutex_t *lock = DNODE_HOLD_CACHE_LOCK(dhc, idx);
+	dnode_t *dn;
+
+	mutex_enter(lock);
+	dn = dhc->dhc_dnodes[idx];
+	if (dn == NULL || dn->dn_object != object ||
+	    dn->dn_type == DMU_OT_NONE || dn->dn_free_txg != 0) {
+		mutex_exit(lock);
+		DNODE_STAT_BUMP(dnode_hold_cache_misses);
+		return (NULL);
+	}
+	VERIFY3U(zfs_refcount_add(&dn->dn_holds, tag), >, 1);
+	mutex_exit(lock);
+
+	DNODE_STAT_BUMP(dnode_hold_cache_hits);
+	return (dn);
+}
+
+/*
+ * Cache a dnode which the caller holds, replacing whichever dnode used the
+ * entry before.  A dnode being freed is not cached; dnode_free() sets
+ * dn_free_txg before it drops the entry, under the same lock.
+ */
+static void
+dnode_hold_cache_insert(dnode_hold_cache_t *dhc, dnode_t *dn)
+{
+	uint64_t idx = dn->dn_object & dhc->dhc_mask;
+	kmutex_t *lock = DNODE_HOLD_CACHE_LOCK(dhc, idx);
+	dnode_t *odn;
+
+	mutex_enter(lock);
+	odn = dhc->dhc_dnodes[idx];
+	if (odn == dn || dn->dn_free_txg != 0) {
+		mutex_exit(lock);
+		return;
+	}
+	VERIFY3U(zfs_refcount_add(&dn->dn_holds, dhc), >, 1);
+	dhc->dhc_dnodes[idx] = dn;
+	mutex_exit(lock);
+
+	if (odn != NULL) {
+		DNODE_STAT_BUMP(dnode_hold_cache_replaced);
+		dnode_rele(odn, dhc);
+	}
+}
+
+/*
+ * Drop a dnode from the dnode hold cache of its objset, if it is cached.
+ */
+static void
+dnode_hold_cache_remove(dnode_t *dn)
+{
+	dnode_hold_cache_t *dhc = &dn->dn_objset->os_dnode_hold_cache;
+	uint64_t idx = dn->dn_object & dhc->dhc_mask;
+	kmutex_t *lock = DNODE_HOLD_CACHE_LOCK(dhc, idx);
+
+	if (dhc->dhc_dnodes == NULL)
+		return;
+
+	mutex_enter(lock);
+	if (dhc->dhc_dnodes[idx] != dn) {
+		mutex_exit(lock);
+		return;
+	}
+	dhc->dhc_dnodes[idx] = NULL;
+	mutex_exit(lock);
+
+	DNODE_STAT_BUMP(dnode_hold_cache_dropped);
+	dnode_rele(dn, dhc);
+}
+
 static void
 dnode_buf_evict_async(void *dbu)
 {
@@ -1288,6 +1456,7 @@ dnode_hold_impl(objset_t *os, uint64_t object, int flag, int slots,
 	dnode_children_t *dnc;
 	dnode_phys_t *dn_block;
 	dnode_handle_t *dnh;
+	dnode_hold_cache_t *dhc;
 
 	ASSERT(!(flag & DNODE_MUST_BE_ALLOCATED) || (slots == 0));
 	ASSERT(!(flag & DNODE_MUST_BE_FREE) || (slots > 0));
@@ -1332,6 +1501,17 @@ dnode_hold_impl(objset_t *os, uint64_t object, int flag, int slots,
 	if (object == 0 || object >= DN_MAX_OBJECT)
 		return (SET_ERROR(EINVAL));
 
+	dhc = &os->os_dnode_hold_cache;
+	if ((flag & (DNODE_MUST_BE_ALLOCATED | DNODE_DRY_RUN)) ==
+	    DNODE_MUST_BE_ALLOCATED && dhc->dhc_dnodes != NULL) {
+		dn = dnode_hold_cache_lookup(dhc, object, tag);
+		if (dn != NULL) {
+			DNODE_VERIFY(dn);
+			*dnp = dn;
+			return (0);
+		}
+	}
+
 	mdn = DMU_META_DNODE(os);
 	ASSERT(mdn->dn_object == DMU_META_DNODE_OBJECT);
 
@@ -1563,6 +1743,9 @@ dnode_hold_impl(objset_t *os, uint64_t object, int flag, int slots,
 	ASSERT3U(dn->dn_object, ==, object);
 	dbuf_rele(db, FTAG);
 
+	if ((flag & DNODE_MUST_BE_ALLOCATED) && dhc->dhc_dnodes != NULL)
+		dnode_hold_cache_insert(dhc, dn);
+
 	*dnp = dn;
 	return (0);
 }
@@ -1729,6 +1912,7 @@ dnode_free(dnode_t *dn, dmu_tx_t *tx)
 	dn->dn_free_txg = tx->tx_txg;
 	mutex_exit(&dn->dn_mtx);
 
+	dnode_hold_cache_remove(dn);
 	dnode_setdirty(dn, tx);
 }
 
@@ -2581,3 +2765,8 @@ EXPORT_SYMBOL(dnode_free_range);
 EXPORT_SYMBOL(dnode_evict_dbufs);
 EXPORT_SYMBOL(dnode_evict_bonus);
 #endif
+
+/* BEGIN CSTYLED */
+ZFS_MODULE_PARAM(zfs, zfs_, dnode_hold_cache_size, INT, ZMOD_RW,
+	"Number of recently held dnodes cached per objset");
+/* END CSTYLED */
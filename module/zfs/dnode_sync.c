@@ -537,6 +537,8 @@ dnode_undirty_dbufs(list_t *list)
 			dnode_undirty_dbufs(&dr->dt.di.dr_children);
 
 		mutex_enter(&db->db_mtx);
+		while (db->db_partial_filling)
+			cv_wait(&db->db_changed, &db->db_mtx);
 		/* XXX - use dbuf_undirty()? */
 		list_remove(list, dr);
 		ASSERT(list_head(&db->db_dirty_records) == dr);
@@ -547,6 +549,7 @@ dnode_undirty_dbufs(list_t *list)
 			ASSERT(db->db_blkid == DMU_BONUS_BLKID ||
 			    dr->dt.dl.dr_data == db->db_buf);
 			dbuf_unoverride(dr);
+			dbuf_partial_discard(dr);
 		} else {
 			mutex_destroy(&dr->dt.di.dr_mtx);
 			list_destroy(&dr->dt.di.dr_children);
@@ -149,6 +149,36 @@ zfs_refcount_add(zfs_refcount_t *rc, const void *holder)
 	return (zfs_refcount_add_many(rc, 1, holder));
 }
 
+/*
+ * Add a reference only if the count is not zero.  This lets a caller that
+ * found the object without the lock ordering its transitions to and from
+ * zero take an additional reference on an object that is already held.
+ */
+boolean_t
+zfs_refcount_add_if_nonzero(zfs_refcount_t *rc, const void *holder)
+{
+	reference_t *ref = NULL;
+
+	if (rc->rc_tracked) {
+		ref = kmem_cache_alloc(reference_cache, KM_SLEEP);
+		ref->ref_holder = holder;
+		ref->ref_number = 1;
+	}
+	mutex_enter(&rc->rc_mtx);
+	if (rc->rc_count == 0) {
+		mutex_exit(&rc->rc_mtx);
+		if (ref != NULL)
+			kmem_cache_free(reference_cache, ref);
+		return (B_FALSE);
+	}
+	if (rc->rc_tracked)
+		list_insert_head(&rc->rc_list, ref);
+	rc->rc_count++;
+	mutex_exit(&rc->rc_mtx);
+
+	return (B_TRUE);
+}
+
 int64_t
 zfs_refcount_remove_many(zfs_refcount_t *rc, uint64_t number,
     const void *holder)
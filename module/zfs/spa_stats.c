@@ -23,6 +23,7 @@
 #include <sys/spa_impl.h>
 #include <sys/vdev_impl.h>
 #include <sys/spa.h>
+#include <sys/zil.h>
 #include <zfs_comutil.h>
 
 /*
@@ -548,6 +549,162 @@ spa_tx_assign_add_nsecs(spa_t *spa, uint64_t nsecs)
 	atomic_inc_64(&((kstat_named_t *)shk->priv)[idx].value.ui64);
 }
 
+/*
+ * ZIL commit statistics - Latency histograms for each phase of zil_commit().
+ */
+static const char *spa_zil_commit_phase_names[ZIL_COMMIT_PHASES] = {
+	"queue", "build", "issue", "device", "flush", "wakeup"
+};
+
+static int
+spa_zil_commit_headers(char *buf, size_t size)
+{
+	size_t off;
+
+	off = snprintf(buf, size, "%-12s", "latency");
+	for (int p = 0; p < ZIL_COMMIT_PHASES && off < size; p++) {
+		off += snprintf(buf + off, size - off, " %12s",
+		    spa_zil_commit_phase_names[p]);
+	}
+	if (off < size)
+		(void) snprintf(buf + off, size - off, "\n");
+
+	return (0);
+}
+
+/*
+ * Print one row per power of two bucket, from the lowest to the highest
+ * bucket used by any phase.
+ */
+static int
+spa_zil_commit_data(char *buf, size_t size, void *data)
+{
+	spa_t *spa = (spa_t *)data;
+	uint64_t *histo;
+	int lo = VDEV_L_HISTO_BUCKETS, hi = -1;
+	size_t off = 0;
+
+	buf[0] = '\0';
+	for (int p = 0; p < ZIL_COMMIT_PHASES; p++) {
+		histo = spa_zil_commit_histo(spa, p);
+		for (int b = 0; b < VDEV_L_HISTO_BUCKETS; b++) {
+			if (histo[b] != 0) {
+				lo = MIN(lo, b);
+				hi = MAX(hi, b);
+			}
+		}
+	}
+
+	for (int b = lo; b <= hi; b++) {
+		off += snprintf(buf + off, size - off, "%-12llu",
+		    (u_longlong_t)1 << b);
+		for (int p = 0; p < ZIL_COMMIT_PHASES && off < size; p++) {
+			histo = spa_zil_commit_histo(spa, p);
+			off += snprintf(buf + off, size - off, " %12llu",
+			    (u_longlong_t)histo[b]);
+		}
+		if (off < size)
+			off += snprintf(buf + off, size - off, "\n");
+		if (off >= size)
+			return (ENOMEM);
+	}
+
+	return (0);
+}
+
+static void *
+spa_zil_commit_addr(kstat_t *ksp, loff_t n)
+{
+	if (n == 0)
+		return (ksp->ks_private);	/* return the spa_t */
+	return (NULL);
+}
+
+/*
+ * When the kstat is written zero all buckets.
+ */
+static int
+spa_zil_commit_update(kstat_t *ksp, int rw)
+{
+	spa_t *spa = ksp->ks_private;
+	spa_history_kstat_t *shk = &spa->spa_stats.zil_commit_histogram;
+
+	if (rw == KSTAT_WRITE)
+		bzero(shk->priv, shk->size);
+
+	return (0);
+}
+
+/*
+ * Return the ZIL commit latency histograms of the pool, in nanoseconds, in
+ * /proc/spl/kstat/zfs/<pool>/zil_commit_latency.  The same histograms are
+ * exported on the root vdev for "zpool iostat -Z".
+ */
+static void
+spa_zil_commit_init(spa_t *spa)
+{
+	spa_history_kstat_t *shk = &spa->spa_stats.zil_commit_histogram;
+	char *name;
+	kstat_t *ksp;
+
+	mutex_init(&shk->lock, NULL, MUTEX_DEFAULT, NULL);
+
+	shk->count = ZIL_COMMIT_PHASES * VDEV_L_HISTO_BUCKETS;
+	shk->size = shk->count * sizeof (uint64_t);
+	shk->priv = kmem_zalloc(shk->size, KM_SLEEP);
+
+	name = kmem_asprintf("zfs/%s", spa_name(spa));
+	ksp = kstat_create(name, 0, "zil_commit_latency", "misc",
+	    KSTAT_TYPE_RAW, 0, KSTAT_FLAG_VIRTUAL);
+
+	shk->kstat = ksp;
+	if (ksp) {
+		ksp->ks_lock = &shk->lock;
+		ksp->ks_data = NULL;
+		ksp->ks_private = spa;
+		ksp->ks_update = spa_zil_commit_update;
+		kstat_set_raw_ops(ksp, spa_zil_commit_headers,
+		    spa_zil_commit_data, spa_zil_commit_addr);
+		kstat_install(ksp);
+	}
+
+	kmem_strfree(name);
+}
+
+static void
+spa_zil_commit_destroy(spa_t *spa)
+{
+	spa_history_kstat_t *shk = &spa->spa_stats.zil_commit_histogram;
+	kstat_t *ksp = shk->kstat;
+
+	if (ksp)
+		kstat_delete(ksp);
+
+	kmem_free(shk->priv, shk->size);
+	mutex_destroy(&shk->lock);
+}
+
+uint64_t *
+spa_zil_commit_histo(spa_t *spa, int phase)
+{
+	spa_history_kstat_t *shk = &spa->spa_stats.zil_commit_histogram;
+
+	ASSERT3S(phase, <, ZIL_COMMIT_PHASES);
+	return ((uint64_t *)shk->priv + phase * VDEV_L_HISTO_BUCKETS);
+}
+
+/*
+ * Add the time spent in each zil_commit_phase_t by one zil_commit().
+ */
+void
+spa_zil_commit_add_nsecs(spa_t *spa, const hrtime_t *nsecs)
+{
+	for (int p = 0; p < ZIL_COMMIT_PHASES; p++) {
+		atomic_inc_64(&spa_zil_commit_histo(spa, p)[
+		    L_HISTO(nsecs[p])]);
+	}
+}
+
 /*
  * ==========================================================================
  * SPA IO History Routines
@@ -897,6 +1054,8 @@ static spa_iostats_t spa_iostats_template = {
 	{ "simple_trim_bytes_skipped",		KSTAT_DATA_UINT64 },
 	{ "simple_trim_extents_failed",		KSTAT_DATA_UINT64 },
 	{ "simple_trim_bytes_failed",		KSTAT_DATA_UINT64 },
+	{ "flush_issued",			KSTAT_DATA_UINT64 },
+	{ "flush_skipped",			KSTAT_DATA_UINT64 },
 };
 
 #define	SPA_IOSTATS_ADD(stat, val) \
@@ -940,6 +1099,24 @@ spa_iostats_trim_add(spa_t *spa, trim_type_t type,
 	}
 }
 
+void
+spa_iostats_flush_add(spa_t *spa, boolean_t issued)
+{
+	spa_history_kstat_t *shk = &spa->spa_stats.iostats;
+	kstat_t *ksp = shk->kstat;
+	spa_iostats_t *iostats;
+
+	if (ksp == NULL)
+		return;
+
+	iostats = ksp->ks_data;
+	if (issued) {
+		SPA_IOSTATS_ADD(flush_issued, 1);
+	} else {
+		SPA_IOSTATS_ADD(flush_skipped, 1);
+	}
+}
+
 static int
 spa_iostats_update(kstat_t *ksp, int rw)
 {
@@ -1000,11 +1177,13 @@ spa_stats_init(spa_t *spa)
 	spa_mmp_history_init(spa);
 	spa_state_init(spa);
 	spa_iostats_init(spa);
+	spa_zil_commit_init(spa);
 }
 
 void
 spa_stats_destroy(spa_t *spa)
 {
+	spa_zil_commit_destroy(spa);
 	spa_iostats_destroy(spa);
 	spa_health_destroy(spa);
 	spa_tx_assign_destroy(spa);
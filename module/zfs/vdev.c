@@ -4291,6 +4291,8 @@ vdev_get_child_stat_ex(vdev_t *cvd, vdev_stat_ex_t *vsx, vdev_stat_ex_t *cvsx)
 			vsx->vsx_agg_histo[t][b] += cvsx->vsx_agg_histo[t][b];
 	}
 
+	vsx->vsx_flush_issued += cvsx->vsx_flush_issued;
+	vsx->vsx_flush_skipped += cvsx->vsx_flush_skipped;
 }
 
 boolean_t
@@ -4472,6 +4474,23 @@ vdev_scan_stat_init(vdev_t *vd)
 	mutex_exit(&vd->vdev_stat_lock);
 }
 
+/*
+ * Count a cache flush to a leaf vdev, either sent to the device or skipped
+ * because the device has no volatile write cache to flush.
+ */
+void
+vdev_stat_flush(vdev_t *vd, boolean_t issued)
+{
+	mutex_enter(&vd->vdev_stat_lock);
+	if (issued)
+		vd->vdev_stat_ex.vsx_flush_issued++;
+	else
+		vd->vdev_stat_ex.vsx_flush_skipped++;
+	mutex_exit(&vd->vdev_stat_lock);
+
+	spa_iostats_flush_add(vd->vdev_spa, issued);
+}
+
 void
 vdev_stat_update(zio_t *zio, uint64_t psize)
 {
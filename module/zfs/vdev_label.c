@@ -152,6 +152,7 @@
 #include <sys/fs/zfs.h>
 #include <sys/byteorder.h>
 #include <sys/zfs_bootenv.h>
+#include <sys/zil.h>
 
 /*
  * Basic routines to read and write from a vdev label.
@@ -368,6 +369,30 @@ vdev_config_generate_stats(vdev_t *vd, nvlist_t *nv)
 	/* IO delays */
 	fnvlist_add_uint64(nvx, ZPOOL_CONFIG_VDEV_SLOW_IOS, vs->vs_slow_ios);
 
+	/* Cache flushes */
+	fnvlist_add_uint64(nvx, ZPOOL_CONFIG_VDEV_FLUSH_ISSUED,
+	    vsx->vsx_flush_issued);
+	fnvlist_add_uint64(nvx, ZPOOL_CONFIG_VDEV_FLUSH_SKIPPED,
+	    vsx->vsx_flush_skipped);
+
+	/* ZIL commit latencies, which are per pool */
+	if (vd == vd->vdev_spa->spa_root_vdev) {
+		static const char *zil_histo_names[ZIL_COMMIT_PHASES] = {
+			[ZIL_COMMIT_QUEUE] = ZPOOL_CONFIG_ZIL_QUEUE_LAT_HISTO,
+			[ZIL_COMMIT_BUILD] = ZPOOL_CONFIG_ZIL_BUILD_LAT_HISTO,
+			[ZIL_COMMIT_ISSUE] = ZPOOL_CONFIG_ZIL_ISSUE_LAT_HISTO,
+			[ZIL_COMMIT_DEVICE] = ZPOOL_CONFIG_ZIL_DEVICE_LAT_HISTO,
+			[ZIL_COMMIT_FLUSH] = ZPOOL_CONFIG_ZIL_FLUSH_LAT_HISTO,
+			[ZIL_COMMIT_WAKEUP] = ZPOOL_CONFIG_ZIL_WAKEUP_LAT_HISTO,
+		};
+
+		for (int p = 0; p < ZIL_COMMIT_PHASES; p++) {
+			fnvlist_add_uint64_array(nvx, zil_histo_names[p],
+			    spa_zil_commit_histo(vd->vdev_spa, p),
+			    VDEV_L_HISTO_BUCKETS);
+		}
+	}
+
 	/* Add extended stats nvlist to main nvlist */
 	fnvlist_add_nvlist(nv, ZPOOL_CONFIG_VDEV_STATS_EX, nvx);
 
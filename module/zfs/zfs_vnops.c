@@ -49,6 +49,7 @@
 #include <sys/spa.h>
 #include <sys/txg.h>
 #include <sys/dbuf.h>
+#include <sys/abd.h>
 #include <sys/policy.h>
 #include <sys/zfs_vnops.h>
 #include <sys/zfs_quota.h>
@@ -168,6 +169,36 @@ zfs_access(znode_t *zp, int mode, int flag, cred_t *cr)
 
 static unsigned long zfs_vnops_read_chunk_size = 1024 * 1024; /* Tunable */
 
+/*
+ * Direct I/O writes of whole blocks are written straight from the pinned
+ * user pages when possible (Linux only), rather than copied into a loaned
+ * ARC buffer first.
+ */
+static int zfs_direct_zero_copy = 1;
+
+/*
+ * Returns B_TRUE if I/O issued with "ioflag" should bypass the ARC, as set
+ * by the "direct" property.  Files with pages in the page cache always use
+ * the buffered paths, which keep those pages coherent.
+ */
+static boolean_t
+zfs_io_direct(znode_t *zp, int ioflag)
+{
+	zfsvfs_t *zfsvfs = ZTOZSB(zp);
+
+	if (zn_has_cached_data(zp))
+		return (B_FALSE);
+
+	switch (zfsvfs->z_os->os_direct) {
+	case ZFS_DIRECT_ALWAYS:
+		return (B_TRUE);
+	case ZFS_DIRECT_STANDARD:
+		return (!!(ioflag & O_DIRECT));
+	default:
+		return (B_FALSE);
+	}
+}
+
 /*
  * Read bytes from specified file into supplied buffer.
  *
@@ -257,6 +288,14 @@ zfs_read(struct znode *zp, zfs_uio_t *uio, int ioflag, cred_t *cr)
 	ssize_t n = MIN(zfs_uio_resid(uio), zp->z_size - zfs_uio_offset(uio));
 	ssize_t start_resid = n;
 
+	/*
+	 * Look up the dnode once for the whole read rather than once per
+	 * chunk; each chunk then holds all of its dbufs in a single pass.
+	 */
+	dmu_buf_impl_t *db = (dmu_buf_impl_t *)sa_get_db(zp->z_sa_hdl);
+	DB_DNODE_ENTER(db);
+	dnode_t *dn = DB_DNODE(db);
+
 	while (n > 0) {
 		ssize_t nbytes = MIN(n, zfs_vnops_read_chunk_size -
 		    P2PHASE(zfs_uio_offset(uio), zfs_vnops_read_chunk_size));
@@ -268,8 +307,11 @@ zfs_read(struct znode *zp, zfs_uio_t *uio, int ioflag, cred_t *cr)
 		if (zn_has_cached_data(zp) && !(ioflag & O_DIRECT)) {
 			error = mappedread(zp, nbytes, uio);
 		} else {
-			error = dmu_read_uio_dbuf(sa_get_db(zp->z_sa_hdl),
-			    uio, nbytes);
+			error = SET_ERROR(ENOTSUP);
+			if (zfs_io_direct(zp, ioflag))
+				error = dmu_read_uio_direct(dn, uio, nbytes);
+			if (error == ENOTSUP)
+				error = dmu_read_uio_dnode(dn, uio, nbytes);
 		}
 
 		if (error) {
@@ -281,6 +323,7 @@ zfs_read(struct znode *zp, zfs_uio_t *uio, int ioflag, cred_t *cr)
 
 		n -= nbytes;
 	}
+	DB_DNODE_EXIT(db);
 
 	int64_t nread = start_resid - n;
 	dataset_kstats_update_read_kstats(&zfsvfs->z_kstat, nread);
@@ -293,6 +336,90 @@ out:
 	return (error);
 }
 
+/*
+ * Read from a file without waiting for I/O or locks, for IOCB_NOWAIT and
+ * AIO submissions.  Cached data is copied out as zfs_read() would; at the
+ * first chunk which is not entirely cached, including its indirect blocks,
+ * its uncached blocks are prefetched and the read stops short.  EAGAIN is
+ * returned if nothing could be read, in which case the caller is expected
+ * to retry with zfs_read() from a context which may block, by which time
+ * the data is usually cached.
+ */
+int
+zfs_read_nowait(struct znode *zp, zfs_uio_t *uio, int ioflag, cred_t *cr)
+{
+	int error = 0;
+
+	zfsvfs_t *zfsvfs = ZTOZSB(zp);
+	ZFS_ENTER(zfsvfs);
+	ZFS_VERIFY_ZP(zp);
+
+	/*
+	 * Leave everything but plain reads of unmapped, cached data to
+	 * zfs_read(): its error checks, syncing the log and reading
+	 * through the page cache may all block.
+	 */
+	if ((zp->z_pflags & ZFS_AV_QUARANTINED) || Z_ISDIR(ZTOTYPE(zp)) ||
+	    zfs_uio_offset(uio) < (offset_t)0 || zfs_uio_resid(uio) == 0 ||
+	    zfsvfs->z_os->os_sync == ZFS_SYNC_ALWAYS ||
+	    zn_has_cached_data(zp) || (ioflag & O_DIRECT)) {
+		ZFS_EXIT(zfsvfs);
+		return (SET_ERROR(EAGAIN));
+	}
+#ifdef FRSYNC
+	if (ioflag & FRSYNC) {
+		ZFS_EXIT(zfsvfs);
+		return (SET_ERROR(EAGAIN));
+	}
+#endif
+
+	zfs_locked_range_t *lr = zfs_rangelock_tryenter(&zp->z_rangelock,
+	    zfs_uio_offset(uio), zfs_uio_resid(uio), RL_READER);
+	if (lr == NULL) {
+		ZFS_EXIT(zfsvfs);
+		return (SET_ERROR(EAGAIN));
+	}
+
+	if (zfs_uio_offset(uio) >= zp->z_size)
+		goto out;
+
+	ssize_t n = MIN(zfs_uio_resid(uio), zp->z_size - zfs_uio_offset(uio));
+	ssize_t start_resid = n;
+
+	dmu_buf_impl_t *db = (dmu_buf_impl_t *)sa_get_db(zp->z_sa_hdl);
+	DB_DNODE_ENTER(db);
+	dnode_t *dn = DB_DNODE(db);
+
+	while (n > 0) {
+		ssize_t nbytes = MIN(n, zfs_vnops_read_chunk_size -
+		    P2PHASE(zfs_uio_offset(uio), zfs_vnops_read_chunk_size));
+
+		error = dmu_read_uio_dnode_nowait(dn, uio, nbytes);
+		if (error) {
+			/* convert checksum errors into IO errors */
+			if (error == ECKSUM)
+				error = SET_ERROR(EIO);
+			break;
+		}
+
+		n -= nbytes;
+	}
+	DB_DNODE_EXIT(db);
+
+	int64_t nread = start_resid - n;
+	if (error == EAGAIN && nread > 0)
+		error = 0;
+	dataset_kstats_update_read_kstats(&zfsvfs->z_kstat, nread);
+	task_io_account_read(nread);
+out:
+	zfs_rangelock_exit(lr);
+
+	if (error == 0)
+		ZFS_ACCESSTIME_STAMP(zfsvfs, zp);
+	ZFS_EXIT(zfsvfs);
+	return (error);
+}
+
 /*
  * Write the bytes to a file.
  *
@@ -453,7 +580,10 @@ zfs_write(znode_t *zp, zfs_uio_t *uio, int ioflag, cred_t *cr)
 		}
 
 		arc_buf_t *abuf = NULL;
-		if (n >= max_blksz && woff >= zp->z_size &&
+		abd_t *pabd = NULL;
+		boolean_t zero_copy = B_FALSE;
+		boolean_t direct = zfs_io_direct(zp, ioflag);
+		if (n >= max_blksz && (woff >= zp->z_size || direct) &&
 		    P2PHASE(woff, max_blksz) == 0 &&
 		    zp->z_blksz == max_blksz) {
 			/*
@@ -462,19 +592,26 @@ zfs_write(znode_t *zp, zfs_uio_t *uio, int ioflag, cred_t *cr)
 			 * a transaction.  This avoids the possibility of
 			 * holding up the transaction if the data copy hangs
 			 * up on a pagefault (e.g., from an NFS server mapping).
+			 * Direct I/O also takes this path when overwriting,
+			 * since it never needs the old contents, and pins the
+			 * user pages instead of copying them if it can.
 			 */
 			size_t cbytes;
 
-			abuf = dmu_request_arcbuf(sa_get_db(zp->z_sa_hdl),
-			    max_blksz);
-			ASSERT(abuf != NULL);
-			ASSERT(arc_buf_size(abuf) == max_blksz);
-			if ((error = zfs_uiocopy(abuf->b_data, max_blksz,
-			    UIO_WRITE, uio, &cbytes))) {
-				dmu_return_arcbuf(abuf);
-				break;
+			if (direct && zfs_direct_zero_copy)
+				pabd = zfs_uio_pin_abd(uio, max_blksz);
+			if (pabd == NULL) {
+				abuf = dmu_request_arcbuf(
+				    sa_get_db(zp->z_sa_hdl), max_blksz);
+				ASSERT(abuf != NULL);
+				ASSERT(arc_buf_size(abuf) == max_blksz);
+				if ((error = zfs_uiocopy(abuf->b_data,
+				    max_blksz, UIO_WRITE, uio, &cbytes))) {
+					dmu_return_arcbuf(abuf);
+					break;
+				}
+				ASSERT3S(cbytes, ==, max_blksz);
 			}
-			ASSERT3S(cbytes, ==, max_blksz);
 		}
 
 		/*
@@ -493,6 +630,7 @@ zfs_write(znode_t *zp, zfs_uio_t *uio, int ioflag, cred_t *cr)
 			dmu_tx_abort(tx);
 			if (abuf != NULL)
 				dmu_return_arcbuf(abuf);
+			abd_free(pabd);
 			break;
 		}
 
@@ -529,7 +667,7 @@ zfs_write(znode_t *zp, zfs_uio_t *uio, int ioflag, cred_t *cr)
 		    MIN(n, max_blksz - P2PHASE(woff, max_blksz));
 
 		ssize_t tx_bytes;
-		if (abuf == NULL) {
+		if (abuf == NULL && pabd == NULL) {
 			tx_bytes = zfs_uio_resid(uio);
 			zfs_uio_fault_disable(uio, B_TRUE);
 			error = dmu_write_uio_dbuf(sa_get_db(zp->z_sa_hdl),
@@ -560,7 +698,7 @@ zfs_write(znode_t *zp, zfs_uio_t *uio, int ioflag, cred_t *cr)
 			}
 			tx_bytes -= zfs_uio_resid(uio);
 		} else {
-			/* Implied by abuf != NULL: */
+			/* Implied by abuf != NULL or pabd != NULL: */
 			ASSERT3S(n, >=, max_blksz);
 			ASSERT0(P2PHASE(woff, max_blksz));
 			/*
@@ -571,15 +709,41 @@ zfs_write(znode_t *zp, zfs_uio_t *uio, int ioflag, cred_t *cr)
 			ASSERT3S(nbytes, ==, max_blksz);
 			/*
 			 * Thus, we're writing a full block at a block-aligned
-			 * offset and extending the file past EOF.
+			 * offset and extending the file past EOF, or
+			 * overwriting it for direct I/O.
 			 *
-			 * dmu_assign_arcbuf_by_dbuf() will directly assign the
-			 * arc buffer to a dbuf.
+			 * dmu_write_direct() writes the pinned pages out right
+			 * away.  Otherwise, or if it can not, the data goes in
+			 * an arc buffer: dmu_assign_arcbuf_by_dbuf() will
+			 * directly assign it to a dbuf, and
+			 * dmu_assign_arcbuf_direct() also keeps it from being
+			 * cached once written.
 			 */
-			error = dmu_assign_arcbuf_by_dbuf(
-			    sa_get_db(zp->z_sa_hdl), woff, abuf, tx);
+			if (pabd != NULL) {
+				DB_DNODE_ENTER(db);
+				error = dmu_write_direct(DB_DNODE(db), woff,
+				    pabd, tx);
+				DB_DNODE_EXIT(db);
+				zero_copy = (error == 0);
+				if (error == ENOTSUP) {
+					abuf = dmu_request_arcbuf(
+					    sa_get_db(zp->z_sa_hdl), max_blksz);
+					abd_copy_to_buf(abuf->b_data, pabd,
+					    max_blksz);
+					error = 0;
+				}
+				abd_free(pabd);
+			}
+			if (abuf != NULL && direct) {
+				error = dmu_assign_arcbuf_direct(
+				    sa_get_db(zp->z_sa_hdl), woff, abuf, tx);
+			} else if (abuf != NULL) {
+				error = dmu_assign_arcbuf_by_dbuf(
+				    sa_get_db(zp->z_sa_hdl), woff, abuf, tx);
+			}
 			if (error != 0) {
-				dmu_return_arcbuf(abuf);
+				if (abuf != NULL)
+					dmu_return_arcbuf(abuf);
 				dmu_tx_commit(tx);
 				break;
 			}
@@ -651,7 +815,7 @@ zfs_write(znode_t *zp, zfs_uio_t *uio, int ioflag, cred_t *cr)
 		error = sa_bulk_update(zp->z_sa_hdl, bulk, count, tx);
 
 		zfs_log_write(zilog, tx, TX_WRITE, zp, woff, tx_bytes, ioflag,
-		    NULL, NULL);
+		    zero_copy, NULL, NULL);
 		dmu_tx_commit(tx);
 
 		if (error != 0)
@@ -834,7 +998,7 @@ zfs_get_data(void *arg, uint64_t gen, lr_write_t *lr, char *buf,
 #endif
 		if (error == 0)
 			error = dmu_buf_hold(os, object, offset, zgd, &db,
-			    DMU_READ_NO_PREFETCH);
+			    DMU_READ_NO_PREFETCH | DMU_READ_NO_DIRECT);
 
 		if (error == 0) {
 			blkptr_t *bp = &lr->lr_blkptr;
@@ -909,3 +1073,6 @@ EXPORT_SYMBOL(zfs_setsecattr);
 
 ZFS_MODULE_PARAM(zfs_vnops, zfs_vnops_, read_chunk_size, ULONG, ZMOD_RW,
 	"Bytes to read per chunk");
+
+ZFS_MODULE_PARAM(zfs, zfs_, direct_zero_copy, INT, ZMOD_RW,
+	"Write whole direct I/O blocks from pinned user pages");
@@ -91,6 +91,15 @@
  */
 int zfs_commit_timeout_pct = 5;
 
+/*
+ * When non-zero, an lwb written to the main pool (i.e. not to a slog) is
+ * held open for this percentage of the last lwb latency, rather than for
+ * zfs_commit_timeout_pct, while other threads are also committing. Their
+ * small synchronous writes are then aggregated into fewer, larger log
+ * blocks, which saves allocations and IOPS on pools of spinning disks.
+ */
+int zil_aggregate_pct = 0;
+
 /*
  * See zil.h for more information about these fields.
  */
@@ -132,6 +141,13 @@ int zil_nocacheflush = 0;
  */
 unsigned long zil_slog_bulk = 768 * 1024;
 
+/*
+ * Number of lists per txg that zil_itx_assign() spreads itxs over by CPU,
+ * so that threads logging concurrently do not all serialize on one lock.
+ * Zero means one list per CPU. Takes effect when a ZIL is next opened.
+ */
+int zil_itx_lists = 0;
+
 static kmem_cache_t *zil_lwb_cache;
 static kmem_cache_t *zil_zcw_cache;
 
@@ -560,6 +576,7 @@ zil_alloc_lwb(zilog_t *zilog, blkptr_t *bp, boolean_t slog, uint64_t txg,
 	lwb->lwb_root_zio = NULL;
 	lwb->lwb_tx = NULL;
 	lwb->lwb_issued_timestamp = 0;
+	lwb->lwb_written_timestamp = 0;
 	if (BP_GET_CHECKSUM(bp) == ZIO_CHECKSUM_ZILOG2) {
 		lwb->lwb_nused = sizeof (zil_chain_t);
 		lwb->lwb_sz = BP_GET_LSIZE(bp);
@@ -629,7 +646,7 @@ zilog_dirty(zilog_t *zilog, uint64_t txg)
 
 /*
  * Determine if the zil is dirty in the specified txg. Callers wanting to
- * ensure that the dirty state does not change must hold the itxg_lock for
+ * ensure that the dirty state does not change must hold an itxg_lock for
  * the specified txg. Holding the lock will ensure that the zil cannot be
  * dirtied (zil_itx_assign) or cleaned (zil_clean) while we check its current
  * state.
@@ -1127,6 +1144,7 @@ zil_lwb_flush_vdevs_done(zio_t *zio)
 	dmu_tx_t *tx = lwb->lwb_tx;
 	zil_commit_waiter_t *zcw;
 	itx_t *itx;
+	hrtime_t now;
 
 	spa_config_exit(zilog->zl_spa, SCL_STATE, lwb);
 
@@ -1146,7 +1164,8 @@ zil_lwb_flush_vdevs_done(zio_t *zio)
 	lwb->lwb_tx = NULL;
 
 	ASSERT3U(lwb->lwb_issued_timestamp, >, 0);
-	zilog->zl_last_lwb_latency = gethrtime() - lwb->lwb_issued_timestamp;
+	now = gethrtime();
+	zilog->zl_last_lwb_latency = now - lwb->lwb_issued_timestamp;
 
 	lwb->lwb_root_zio = NULL;
 
@@ -1178,6 +1197,11 @@ zil_lwb_flush_vdevs_done(zio_t *zio)
 		zcw->zcw_lwb = NULL;
 
 		zcw->zcw_zio_error = zio->io_error;
+		zcw->zcw_phase_ts[ZIL_COMMIT_DEVICE] =
+		    lwb->lwb_issued_timestamp;
+		zcw->zcw_phase_ts[ZIL_COMMIT_FLUSH] =
+		    lwb->lwb_written_timestamp;
+		zcw->zcw_phase_ts[ZIL_COMMIT_WAKEUP] = now;
 
 		ASSERT3B(zcw->zcw_done, ==, B_FALSE);
 		zcw->zcw_done = B_TRUE;
@@ -1235,6 +1259,7 @@ zil_lwb_write_done(zio_t *zio)
 	mutex_enter(&zilog->zl_lock);
 	ASSERT3S(lwb->lwb_state, ==, LWB_STATE_ISSUED);
 	lwb->lwb_state = LWB_STATE_WRITE_DONE;
+	lwb->lwb_written_timestamp = gethrtime();
 	lwb->lwb_write_zio = NULL;
 	lwb->lwb_fastwrite = FALSE;
 	nlwb = list_next(&zilog->zl_lwb_list, lwb);
@@ -1820,7 +1845,7 @@ zil_itx_destroy(itx_t *itx)
  * so no locks are needed.
  */
 static void
-zil_itxg_clean(itxs_t *itxs)
+zil_itxs_destroy(itxs_t *itxs)
 {
 	itx_t *itx;
 	list_t *list;
@@ -1874,6 +1899,55 @@ zil_itxg_clean(itxs_t *itxs)
 	kmem_free(itxs, sizeof (itxs_t));
 }
 
+/*
+ * Free up a chain of detached itxs_t, as built by zil_clean() from the
+ * itxgs of one txg.
+ */
+static void
+zil_itxg_clean(itxs_t *itxs)
+{
+	itxs_t *next;
+
+	for (; itxs != NULL; itxs = next) {
+		next = itxs->i_next;
+		zil_itxs_destroy(itxs);
+	}
+}
+
+static itxg_t *
+zil_itxg(zilog_t *zilog, uint64_t txg, uint_t i)
+{
+	ASSERT3U(i, <, zilog->zl_itxg_count);
+	return (&zilog->zl_itxg[txg & TXG_MASK][i]);
+}
+
+/*
+ * Merge the itxs on src into dst, leaving src empty. Both lists must be
+ * in itx_seq order, and dst stays that way. The itxs on src are usually
+ * newer than those on dst, so the merge works back from the tails.
+ */
+static void
+zil_itx_list_merge(list_t *dst, list_t *src)
+{
+	itx_t *itx, *pos;
+
+	itx = list_head(src);
+	pos = list_tail(dst);
+	if (itx == NULL || pos == NULL || pos->itx_seq < itx->itx_seq) {
+		list_move_tail(dst, src);
+		return;
+	}
+
+	while ((itx = list_remove_tail(src)) != NULL) {
+		while (pos != NULL && pos->itx_seq > itx->itx_seq)
+			pos = list_prev(dst, pos);
+		if (pos == NULL)
+			list_insert_head(dst, itx);
+		else
+			list_insert_after(dst, pos, itx);
+	}
+}
+
 static int
 zil_aitx_compare(const void *x1, const void *x2)
 {
@@ -1905,22 +1979,27 @@ zil_remove_async(zilog_t *zilog, uint64_t oid)
 		otxg = spa_last_synced_txg(zilog->zl_spa) + 1;
 
 	for (txg = otxg; txg < (otxg + TXG_CONCURRENT_STATES); txg++) {
-		itxg_t *itxg = &zilog->zl_itxg[txg & TXG_MASK];
+		for (uint_t i = 0; i < zilog->zl_itxg_count; i++) {
+			itxg_t *itxg = zil_itxg(zilog, txg, i);
 
-		mutex_enter(&itxg->itxg_lock);
-		if (itxg->itxg_txg != txg) {
+			if (!itxg->itxg_has_async)
+				continue;
+
+			mutex_enter(&itxg->itxg_lock);
+			if (itxg->itxg_txg != txg) {
+				mutex_exit(&itxg->itxg_lock);
+				continue;
+			}
+
+			/*
+			 * Locate the object node and append its list.
+			 */
+			t = &itxg->itxg_itxs->i_async_tree;
+			ian = avl_find(t, &oid, &where);
+			if (ian != NULL)
+				list_move_tail(&clean_list, &ian->ia_list);
 			mutex_exit(&itxg->itxg_lock);
-			continue;
 		}
-
-		/*
-		 * Locate the object node and append its list.
-		 */
-		t = &itxg->itxg_itxs->i_async_tree;
-		ian = avl_find(t, &oid, &where);
-		if (ian != NULL)
-			list_move_tail(&clean_list, &ian->ia_list);
-		mutex_exit(&itxg->itxg_lock);
 	}
 	while ((itx = list_head(&clean_list)) != NULL) {
 		list_remove(&clean_list, itx);
@@ -1949,7 +2028,7 @@ zil_itx_assign(zilog_t *zilog, itx_t *itx, dmu_tx_t *tx)
 	else
 		txg = dmu_tx_get_txg(tx);
 
-	itxg = &zilog->zl_itxg[txg & TXG_MASK];
+	itxg = zil_itxg(zilog, txg, CPU_SEQID_UNSTABLE % zilog->zl_itxg_count);
 	mutex_enter(&itxg->itxg_lock);
 	itxs = itxg->itxg_itxs;
 	if (itxg->itxg_txg != txg) {
@@ -1972,9 +2051,19 @@ zil_itx_assign(zilog_t *zilog, itx_t *itx, dmu_tx_t *tx)
 		avl_create(&itxs->i_async_tree, zil_aitx_compare,
 		    sizeof (itx_async_node_t),
 		    offsetof(itx_async_node_t, ia_node));
+		itxg->itxg_has_sync = B_FALSE;
+		itxg->itxg_has_async = B_FALSE;
 	}
+
+	/*
+	 * The sequence number is taken under the itxg_lock, so each list
+	 * stays in itx_seq order by appending to it, and any itx already
+	 * on a list has a lower itx_seq than one not yet assigned.
+	 */
+	itx->itx_seq = atomic_inc_64_nv(&zilog->zl_itx_seq);
 	if (itx->itx_sync) {
 		list_insert_tail(&itxs->i_sync_list, itx);
+		itxg->itxg_has_sync = B_TRUE;
 	} else {
 		avl_tree_t *t = &itxs->i_async_tree;
 		uint64_t foid =
@@ -1992,6 +2081,7 @@ zil_itx_assign(zilog_t *zilog, itx_t *itx, dmu_tx_t *tx)
 			avl_insert(t, ian, where);
 		}
 		list_insert_tail(&ian->ia_list, itx);
+		itxg->itxg_has_async = B_TRUE;
 	}
 
 	itx->itx_lr.lrc_txg = dmu_tx_get_txg(tx);
@@ -2020,22 +2110,35 @@ zil_itx_assign(zilog_t *zilog, itx_t *itx, dmu_tx_t *tx)
 void
 zil_clean(zilog_t *zilog, uint64_t synced_txg)
 {
-	itxg_t *itxg = &zilog->zl_itxg[synced_txg & TXG_MASK];
-	itxs_t *clean_me;
+	itxs_t *clean_me = NULL;
 
 	ASSERT3U(synced_txg, <, ZILTEST_TXG);
 
-	mutex_enter(&itxg->itxg_lock);
-	if (itxg->itxg_itxs == NULL || itxg->itxg_txg == ZILTEST_TXG) {
+	for (uint_t i = 0; i < zilog->zl_itxg_count; i++) {
+		itxg_t *itxg = zil_itxg(zilog, synced_txg, i);
+		itxs_t *itxs;
+
+		mutex_enter(&itxg->itxg_lock);
+		if (itxg->itxg_itxs == NULL ||
+		    itxg->itxg_txg == ZILTEST_TXG) {
+			mutex_exit(&itxg->itxg_lock);
+			continue;
+		}
+		ASSERT3U(itxg->itxg_txg, <=, synced_txg);
+		ASSERT3U(itxg->itxg_txg, !=, 0);
+		itxs = itxg->itxg_itxs;
+		itxg->itxg_itxs = NULL;
+		itxg->itxg_txg = 0;
+		itxg->itxg_has_sync = B_FALSE;
+		itxg->itxg_has_async = B_FALSE;
 		mutex_exit(&itxg->itxg_lock);
-		return;
+
+		itxs->i_next = clean_me;
+		clean_me = itxs;
 	}
-	ASSERT3U(itxg->itxg_txg, <=, synced_txg);
-	ASSERT3U(itxg->itxg_txg, !=, 0);
-	clean_me = itxg->itxg_itxs;
-	itxg->itxg_itxs = NULL;
-	itxg->itxg_txg = 0;
-	mutex_exit(&itxg->itxg_lock);
+	if (clean_me == NULL)
+		return;
+
 	/*
 	 * Preferably start a task queue to free up the old itxs but
 	 * if taskq_dispatch can't allocate resources to do that then
@@ -2057,8 +2160,10 @@ zil_clean(zilog_t *zilog, uint64_t synced_txg)
 static void
 zil_get_commit_list(zilog_t *zilog)
 {
-	uint64_t otxg, txg;
+	uint64_t otxg, txg, seq;
 	list_t *commit_list = &zilog->zl_itx_commit_list;
+	list_t txg_list, itxg_list;
+	itx_t *itx;
 
 	ASSERT(MUTEX_HELD(&zilog->zl_issuer_lock));
 
@@ -2067,34 +2172,78 @@ zil_get_commit_list(zilog_t *zilog)
 	else
 		otxg = spa_last_synced_txg(zilog->zl_spa) + 1;
 
+	/*
+	 * Only take itxs assigned up to this point. Every such itx is
+	 * already on its list, so what we take from all of the lists is
+	 * exactly the itxs assigned before some instant, and nothing taken
+	 * can depend on an itx that is left behind.
+	 */
+	seq = atomic_add_64_nv(&zilog->zl_itx_seq, 0);
+
+	/*
+	 * An itx assigned before we read the sequence number either was
+	 * still being assigned, or set its itxg's hint before the sequence
+	 * number moved past it.  The atomic read above is a full barrier,
+	 * so the unlocked hint reads below cannot miss the latter.
+	 */
+
+	list_create(&txg_list, sizeof (itx_t), offsetof(itx_t, itx_node));
+	list_create(&itxg_list, sizeof (itx_t), offsetof(itx_t, itx_node));
+
 	/*
 	 * This is inherently racy, since there is nothing to prevent
 	 * the last synced txg from changing. That's okay since we'll
 	 * only commit things in the future.
 	 */
 	for (txg = otxg; txg < (otxg + TXG_CONCURRENT_STATES); txg++) {
-		itxg_t *itxg = &zilog->zl_itxg[txg & TXG_MASK];
+		for (uint_t i = 0; i < zilog->zl_itxg_count; i++) {
+			itxg_t *itxg = zil_itxg(zilog, txg, i);
+			list_t *sync_list;
 
-		mutex_enter(&itxg->itxg_lock);
-		if (itxg->itxg_txg != txg) {
-			mutex_exit(&itxg->itxg_lock);
-			continue;
-		}
+			if (!itxg->itxg_has_sync)
+				continue;
 
-		/*
-		 * If we're adding itx records to the zl_itx_commit_list,
-		 * then the zil better be dirty in this "txg". We can assert
-		 * that here since we're holding the itxg_lock which will
-		 * prevent spa_sync from cleaning it. Once we add the itxs
-		 * to the zl_itx_commit_list we must commit it to disk even
-		 * if it's unnecessary (i.e. the txg was synced).
-		 */
-		ASSERT(zilog_is_dirty_in_txg(zilog, txg) ||
-		    spa_freeze_txg(zilog->zl_spa) != UINT64_MAX);
-		list_move_tail(commit_list, &itxg->itxg_itxs->i_sync_list);
+			mutex_enter(&itxg->itxg_lock);
+			if (itxg->itxg_txg != txg) {
+				mutex_exit(&itxg->itxg_lock);
+				continue;
+			}
 
-		mutex_exit(&itxg->itxg_lock);
+			/*
+			 * If we're adding itx records to the
+			 * zl_itx_commit_list, then the zil better be dirty
+			 * in this "txg". We can assert that here since
+			 * we're holding the itxg_lock which will prevent
+			 * spa_sync from cleaning it. Once we add the itxs
+			 * to the zl_itx_commit_list we must commit it to
+			 * disk even if it's unnecessary (i.e. the txg was
+			 * synced).
+			 */
+			ASSERT(zilog_is_dirty_in_txg(zilog, txg) ||
+			    spa_freeze_txg(zilog->zl_spa) != UINT64_MAX);
+			sync_list = &itxg->itxg_itxs->i_sync_list;
+			itx = list_tail(sync_list);
+			if (itx != NULL && itx->itx_seq <= seq) {
+				list_move_tail(&itxg_list, sync_list);
+			} else {
+				while ((itx = list_head(sync_list)) != NULL &&
+				    itx->itx_seq <= seq) {
+					list_remove(sync_list, itx);
+					list_insert_tail(&itxg_list, itx);
+				}
+			}
+			if (list_is_empty(sync_list))
+				itxg->itxg_has_sync = B_FALSE;
+
+			mutex_exit(&itxg->itxg_lock);
+
+			zil_itx_list_merge(&txg_list, &itxg_list);
+		}
+		list_move_tail(commit_list, &txg_list);
 	}
+
+	list_destroy(&itxg_list);
+	list_destroy(&txg_list);
 }
 
 /*
@@ -2118,38 +2267,54 @@ zil_async_to_sync(zilog_t *zilog, uint64_t foid)
 	 * the last synced txg from changing.
 	 */
 	for (txg = otxg; txg < (otxg + TXG_CONCURRENT_STATES); txg++) {
-		itxg_t *itxg = &zilog->zl_itxg[txg & TXG_MASK];
+		for (uint_t i = 0; i < zilog->zl_itxg_count; i++) {
+			itxg_t *itxg = zil_itxg(zilog, txg, i);
+			list_t *sync_list;
 
-		mutex_enter(&itxg->itxg_lock);
-		if (itxg->itxg_txg != txg) {
-			mutex_exit(&itxg->itxg_lock);
-			continue;
-		}
+			if (!itxg->itxg_has_async)
+				continue;
 
-		/*
-		 * If a foid is specified then find that node and append its
-		 * list. Otherwise walk the tree appending all the lists
-		 * to the sync list. We add to the end rather than the
-		 * beginning to ensure the create has happened.
-		 */
-		t = &itxg->itxg_itxs->i_async_tree;
-		if (foid != 0) {
-			ian = avl_find(t, &foid, &where);
-			if (ian != NULL) {
-				list_move_tail(&itxg->itxg_itxs->i_sync_list,
-				    &ian->ia_list);
+			mutex_enter(&itxg->itxg_lock);
+			if (itxg->itxg_txg != txg) {
+				mutex_exit(&itxg->itxg_lock);
+				continue;
 			}
-		} else {
-			void *cookie = NULL;
 
-			while ((ian = avl_destroy_nodes(t, &cookie)) != NULL) {
-				list_move_tail(&itxg->itxg_itxs->i_sync_list,
-				    &ian->ia_list);
-				list_destroy(&ian->ia_list);
-				kmem_free(ian, sizeof (itx_async_node_t));
+			/*
+			 * If a foid is specified then find that node and
+			 * merge its list. Otherwise walk the tree merging
+			 * all the lists into the sync list. Merging in
+			 * itx_seq order places each itx after the create
+			 * it depends on, and keeps the itxs of an object
+			 * in order across all of the lists of this txg.
+			 */
+			t = &itxg->itxg_itxs->i_async_tree;
+			sync_list = &itxg->itxg_itxs->i_sync_list;
+			if (foid != 0) {
+				ian = avl_find(t, &foid, &where);
+				if (ian != NULL &&
+				    !list_is_empty(&ian->ia_list)) {
+					zil_itx_list_merge(sync_list,
+					    &ian->ia_list);
+					itxg->itxg_has_sync = B_TRUE;
+				}
+			} else {
+				void *cookie = NULL;
+
+				while ((ian = avl_destroy_nodes(t,
+				    &cookie)) != NULL) {
+					zil_itx_list_merge(sync_list,
+					    &ian->ia_list);
+					list_destroy(&ian->ia_list);
+					kmem_free(ian,
+					    sizeof (itx_async_node_t));
+				}
+				itxg->itxg_has_async = B_FALSE;
+				if (!list_is_empty(sync_list))
+					itxg->itxg_has_sync = B_TRUE;
 			}
+			mutex_exit(&itxg->itxg_lock);
 		}
-		mutex_exit(&itxg->itxg_lock);
 	}
 }
 
@@ -2458,6 +2623,7 @@ zil_commit_writer(zilog_t *zilog, zil_commit_waiter_t *zcw)
 	ASSERT(spa_writeable(zilog->zl_spa));
 
 	mutex_enter(&zilog->zl_issuer_lock);
+	zcw->zcw_phase_ts[ZIL_COMMIT_BUILD] = gethrtime();
 
 	if (zcw->zcw_lwb != NULL || zcw->zcw_done) {
 		/*
@@ -2486,6 +2652,7 @@ zil_commit_writer(zilog_t *zilog, zil_commit_waiter_t *zcw)
 	zil_process_commit_list(zilog);
 
 out:
+	zcw->zcw_phase_ts[ZIL_COMMIT_ISSUE] = gethrtime();
 	mutex_exit(&zilog->zl_issuer_lock);
 }
 
@@ -2563,6 +2730,9 @@ zil_commit_waiter_timeout(zilog_t *zilog, zil_commit_waiter_t *zcw)
 
 	ASSERT3S(lwb->lwb_state, ==, LWB_STATE_OPENED);
 
+	boolean_t aggregate = (zil_aggregate_pct != 0 && !lwb->lwb_slog);
+	uint64_t nused = lwb->lwb_nused;
+
 	/*
 	 * As described in the comments above zil_commit_waiter() and
 	 * zil_process_commit_list(), we need to issue this lwb's zio
@@ -2584,8 +2754,13 @@ zil_commit_waiter_timeout(zilog_t *zilog, zil_commit_waiter_t *zcw)
 	 * block size selection algorithm, so it can take this information
 	 * into account, and potentially select a smaller size for the
 	 * next lwb block that is allocated.
+	 *
+	 * When aggregating commits to the main pool, we instead size the
+	 * next block from what the committers put in this one, so that
+	 * the zl_prev_blks history follows the aggregated commit size
+	 * rather than falling back to the smallest block size.
 	 */
-	zilog->zl_cur_used = 0;
+	zilog->zl_cur_used = aggregate ? nused : 0;
 
 	if (nlwb == NULL) {
 		/*
@@ -2620,6 +2795,17 @@ out:
 	ASSERT(MUTEX_HELD(&zcw->zcw_lock));
 }
 
+/*
+ * Returns true if commit waiters should hold the given open lwb for
+ * zil_aggregate_pct of the last lwb latency; see zil_commit_waiter().
+ */
+static boolean_t
+zil_lwb_aggregate(zilog_t *zilog, lwb_t *lwb)
+{
+	return (zil_aggregate_pct != 0 && !lwb->lwb_slog &&
+	    atomic_add_64_nv(&zilog->zl_committers, 0) > 1);
+}
+
 /*
  * This function is responsible for performing the following two tasks:
  *
@@ -2655,6 +2841,16 @@ zil_commit_waiter(zilog_t *zilog, zil_commit_waiter_t *zcw)
 	 * zil_process_commit_list() function.
 	 */
 	int pct = MAX(zfs_commit_timeout_pct, 1);
+
+	/*
+	 * While other threads are committing, we can wait longer for
+	 * them to add their itxs to an lwb bound for the main pool.
+	 */
+	if (!zcw->zcw_done && zcw->zcw_lwb != NULL &&
+	    zcw->zcw_lwb->lwb_state == LWB_STATE_OPENED &&
+	    zil_lwb_aggregate(zilog, zcw->zcw_lwb))
+		pct = MAX(zil_aggregate_pct, pct);
+
 	hrtime_t sleep = (zilog->zl_last_lwb_latency * pct) / 100;
 	hrtime_t wakeup = gethrtime() + sleep;
 	boolean_t timedout = B_FALSE;
@@ -2751,6 +2947,7 @@ zil_alloc_commit_waiter(void)
 	zcw->zcw_lwb = NULL;
 	zcw->zcw_done = B_FALSE;
 	zcw->zcw_zio_error = 0;
+	bzero(zcw->zcw_phase_ts, sizeof (zcw->zcw_phase_ts));
 
 	return (zcw);
 }
@@ -2933,8 +3130,12 @@ zil_commit(zilog_t *zilog, uint64_t foid)
 		 */
 		ASSERT(list_is_empty(&zilog->zl_lwb_list));
 		ASSERT3P(zilog->zl_last_lwb_opened, ==, NULL);
-		for (int i = 0; i < TXG_SIZE; i++)
-			ASSERT3P(zilog->zl_itxg[i].itxg_itxs, ==, NULL);
+		for (int i = 0; i < TXG_SIZE; i++) {
+			for (uint_t j = 0; j < zilog->zl_itxg_count; j++) {
+				ASSERT3P(zilog->zl_itxg[i][j].itxg_itxs, ==,
+				    NULL);
+			}
+		}
 		return;
 	}
 
@@ -2953,9 +3154,32 @@ zil_commit(zilog_t *zilog, uint64_t foid)
 	zil_commit_impl(zilog, foid);
 }
 
+/*
+ * Add the time this commit spent in each phase to the pool's ZIL commit
+ * latency histograms. A phase may have started before the previous one
+ * ended from this waiter's point of view (e.g. the lwb was issued by
+ * another thread while we waited for the zl_issuer_lock), so each start
+ * is moved up to the end of the previous phase.
+ */
+static void
+zil_commit_latency_add(zilog_t *zilog, zil_commit_waiter_t *zcw)
+{
+	hrtime_t *ts = zcw->zcw_phase_ts;
+	hrtime_t nsecs[ZIL_COMMIT_PHASES];
+
+	for (int p = 0; p < ZIL_COMMIT_PHASES; p++) {
+		ts[p + 1] = MAX(ts[p + 1], ts[p]);
+		nsecs[p] = ts[p + 1] - ts[p];
+	}
+
+	spa_zil_commit_add_nsecs(zilog->zl_spa, nsecs);
+}
+
 void
 zil_commit_impl(zilog_t *zilog, uint64_t foid)
 {
+	hrtime_t start = gethrtime();
+
 	ZIL_STAT_BUMP(zil_commit_count);
 
 	/*
@@ -2985,10 +3209,22 @@ zil_commit_impl(zilog_t *zilog, uint64_t foid)
 	 * zil_commit_waiter().
 	 */
 	zil_commit_waiter_t *zcw = zil_alloc_commit_waiter();
+	zcw->zcw_phase_ts[ZIL_COMMIT_QUEUE] = start;
 	zil_commit_itx_assign(zilog, zcw);
 
+	atomic_inc_64(&zilog->zl_committers);
 	zil_commit_writer(zilog, zcw);
 	zil_commit_waiter(zilog, zcw);
+	atomic_dec_64(&zilog->zl_committers);
+
+	/*
+	 * Waiters that were skipped, rather than committed to an lwb,
+	 * have no lwb timestamps and are not counted.
+	 */
+	zcw->zcw_phase_ts[ZIL_COMMIT_PHASES] = gethrtime();
+	if (zcw->zcw_zio_error == 0 &&
+	    zcw->zcw_phase_ts[ZIL_COMMIT_WAKEUP] != 0)
+		zil_commit_latency_add(zilog, zcw);
 
 	if (zcw->zcw_zio_error != 0) {
 		/*
@@ -3181,9 +3417,14 @@ zil_alloc(objset_t *os, zil_header_t *zh_phys)
 	mutex_init(&zilog->zl_lock, NULL, MUTEX_DEFAULT, NULL);
 	mutex_init(&zilog->zl_issuer_lock, NULL, MUTEX_DEFAULT, NULL);
 
+	zilog->zl_itxg_count = zil_itx_lists > 0 ? zil_itx_lists : boot_ncpus;
 	for (int i = 0; i < TXG_SIZE; i++) {
-		mutex_init(&zilog->zl_itxg[i].itxg_lock, NULL,
-		    MUTEX_DEFAULT, NULL);
+		zilog->zl_itxg[i] = kmem_zalloc(zilog->zl_itxg_count *
+		    sizeof (itxg_t), KM_SLEEP);
+		for (uint_t j = 0; j < zilog->zl_itxg_count; j++) {
+			mutex_init(&zilog->zl_itxg[i][j].itxg_lock, NULL,
+			    MUTEX_DEFAULT, NULL);
+		}
 	}
 
 	list_create(&zilog->zl_lwb_list, sizeof (lwb_t),
@@ -3221,9 +3462,15 @@ zil_free(zilog_t *zilog)
 		 *
 		 * Also free up the ziltest itxs.
 		 */
-		if (zilog->zl_itxg[i].itxg_itxs)
-			zil_itxg_clean(zilog->zl_itxg[i].itxg_itxs);
-		mutex_destroy(&zilog->zl_itxg[i].itxg_lock);
+		for (uint_t j = 0; j < zilog->zl_itxg_count; j++) {
+			itxg_t *itxg = &zilog->zl_itxg[i][j];
+
+			if (itxg->itxg_itxs)
+				zil_itxg_clean(itxg->itxg_itxs);
+			mutex_destroy(&itxg->itxg_lock);
+		}
+		kmem_free(zilog->zl_itxg[i],
+		    zilog->zl_itxg_count * sizeof (itxg_t));
 	}
 
 	mutex_destroy(&zilog->zl_issuer_lock);
@@ -3693,4 +3940,10 @@ ZFS_MODULE_PARAM(zfs_zil, zil_, slog_bulk, ULONG, ZMOD_RW,
 
 ZFS_MODULE_PARAM(zfs_zil, zil_, maxblocksize, INT, ZMOD_RW,
 	"Limit in bytes of ZIL log block size");
+
+ZFS_MODULE_PARAM(zfs_zil, zil_, itx_lists, INT, ZMOD_RW,
+	"Number of per-txg itx lists, 0 for one per CPU");
+
+ZFS_MODULE_PARAM(zfs_zil, zil_, aggregate_pct, INT, ZMOD_RW,
+	"ZIL block open timeout percentage when aggregating commits");
 /* END CSTYLED */
@@ -1288,6 +1288,18 @@ zio_ioctl(zio_t *pio, spa_t *spa, vdev_t *vd, int cmd,
 	zio_t *zio;
 	int c;
 
+	if (vd->vdev_children == 0 && cmd == DKIOCFLUSHWRITECACHE &&
+	    vd->vdev_nowritecache) {
+		/*
+		 * Don't send a cache flush to a device which already told us
+		 * it can't flush one; it would only add latency to the ZIL
+		 * and spa_sync().  Devices whose cache mode can change are
+		 * checked by their vdev_op_io_start on every flush instead.
+		 */
+		vdev_stat_flush(vd, B_FALSE);
+		return (zio_null(pio, spa, NULL, done, private, flags));
+	}
+
 	if (vd->vdev_children == 0) {
 		zio = zio_create(pio, spa, 0, NULL, NULL, 0, 0, done, private,
 		    ZIO_TYPE_IOCTL, ZIO_PRIORITY_NOW, flags, vd, 0, NULL,
@@ -1000,6 +1000,19 @@ zvol_prefetch_minors_impl(void *arg)
 	}
 }
 
+/*
+ * Create the minor for a prefetched zvol or snapshot.  For a zvol this
+ * replays its intent log, which is why several minors are created at once.
+ */
+static void
+zvol_create_minor_task(void *arg)
+{
+	minors_job_t *job = arg;
+
+	if (!job->error)
+		(void) ops->zv_create_minor(job->name);
+}
+
 /*
  * Mask errors to continue dmu_objset_find() traversal
  */
@@ -1151,13 +1164,26 @@ zvol_create_minors_recursive(const char *name)
 	taskq_wait_outstanding(system_taskq, 0);
 
 	/*
-	 * Prefetch is completed, we can do zvol_create_minor_impl
-	 * sequentially.
+	 * Prefetch is completed, we can do zvol_create_minor_impl.  Each
+	 * zvol's intent log is replayed when its minor is created, which
+	 * after a crash can take a while, so the minors of independent
+	 * zvols are created concurrently by a taskq.
 	 */
+	if (!list_is_empty(&minors_list)) {
+		taskq_t *tq = taskq_create("z_zvol_minors", boot_ncpus,
+		    defclsyspri, 1, INT_MAX, TASKQ_DYNAMIC);
+
+		for (job = list_head(&minors_list); job != NULL;
+		    job = list_next(&minors_list, job)) {
+			(void) taskq_dispatch(tq, zvol_create_minor_task, job,
+			    TQ_SLEEP);
+		}
+		taskq_wait(tq);
+		taskq_destroy(tq);
+	}
+
 	while ((job = list_head(&minors_list)) != NULL) {
 		list_remove(&minors_list, job);
-		if (!job->error)
-			(void) ops->zv_create_minor(job->name);
 		kmem_strfree(job->name);
 		kmem_free(job, sizeof (minors_job_t));
 	}
@@ -0,0 +1,104 @@
+/*
+ * This file and its contents are supplied under the terms of the
+ * Common Development and Distribution License ("CDDL"), version 1.0.
+ * You may only use this file in accordance with the terms of version
+ * 1.0 of the CDDL.
+ *
+ * A full copy of the text of the CDDL should have accompanied this
+ * source.  A copy of the CDDL is also available via the Internet at
+ * http://www.illumos.org/license/CDDL.
+ */
+
+#include <sys/types.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char *execname = "file_fadvise";
+
+static const struct {
+	const char *name;
+	int advice;
+} advices[] = {
+	{ "normal",	POSIX_FADV_NORMAL },
+	{ "sequential",	POSIX_FADV_SEQUENTIAL },
+	{ "random",	POSIX_FADV_RANDOM },
+	{ "willneed",	POSIX_FADV_WILLNEED },
+	{ "dontneed",	POSIX_FADV_DONTNEED },
+	{ "noreuse",	POSIX_FADV_NOREUSE },
+};
+
+static void
+usage(void)
+{
+	(void) fprintf(stderr,
+	    "usage: %s -f filename -a advice [-o offset] [-l length]\n"
+	    "\n"
+	    "Call posix_fadvise(2) on a file.\n"
+	    "\n"
+	    "    filename: File to give the advice for\n"
+	    "    advice:   normal, sequential, random, willneed, dontneed\n"
+	    "              or noreuse\n"
+	    "    offset:   Start of the range in bytes (default 0)\n"
+	    "    length:   Length of the range in bytes, 0 for the rest of\n"
+	    "              the file (default 0)\n",
+	    execname);
+	exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+	char *filename = NULL;
+	off_t offset = 0, len = 0;
+	int advice = -1;
+	int c, fd, err;
+
+	while ((c = getopt(argc, argv, "a:f:l:o:")) != -1) {
+		switch (c) {
+		case 'a':
+			for (int i = 0;
+			    i < sizeof (advices) / sizeof (advices[0]); i++) {
+				if (strcmp(optarg, advices[i].name) == 0)
+					advice = advices[i].advice;
+			}
+			if (advice == -1)
+				usage();
+			break;
+		case 'f':
+			filename = optarg;
+			break;
+		case 'l':
+			len = strtoll(optarg, NULL, 0);
+			break;
+		case 'o':
+			offset = strtoll(optarg, NULL, 0);
+			break;
+		default:
+			usage();
+		}
+	}
+	if (filename == NULL || advice == -1)
+		usage();
+
+	fd = open(filename, O_RDONLY);
+	if (fd == -1) {
+		(void) fprintf(stderr, "%s: open %s: %s\n", execname,
+		    filename, strerror(errno));
+		return (1);
+	}
+
+	err = posix_fadvise(fd, offset, len, advice);
+	if (err != 0) {
+		(void) fprintf(stderr, "%s: posix_fadvise %s: %s\n", execname,
+		    filename, strerror(err));
+		(void) close(fd);
+		return (1);
+	}
+
+	(void) close(fd);
+	return (0);
+}
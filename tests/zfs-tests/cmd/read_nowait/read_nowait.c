@@ -0,0 +1,192 @@
+/*
+ * This file and its contents are supplied under the terms of the
+ * Common Development and Distribution License ("CDDL"), version 1.0.
+ * You may only use this file in accordance with the terms of version
+ * 1.0 of the CDDL.
+ *
+ * A full copy of the text of the CDDL should have accompanied this
+ * source.  A copy of the CDDL is also available via the Internet at
+ * http://www.illumos.org/license/CDDL.
+ */
+
+/*
+ * Read a file with preadv2(RWF_NOWAIT), retrying each block which
+ * returns EAGAIN, and compare the data with a normal read of the file.
+ * Prints the number of EAGAIN returns and of reads served without them.
+ * With -e, first issue one RWF_NOWAIT read per block and fail unless every
+ * one of them returns EAGAIN, i.e. none of the file was cached.  With -w,
+ * only verify that a RWF_NOWAIT write fails with EOPNOTSUPP.
+ * Exits with 2 if RWF_NOWAIT reads are not supported.
+ */
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static const char *execname = "read_nowait";
+
+static void
+usage(void)
+{
+	(void) fprintf(stderr,
+	    "usage: %s -f filename [-b blocksize] [-r retries] [-e | -w]\n"
+	    "\n"
+	    "Read a file with RWF_NOWAIT reads and verify the data.\n"
+	    "\n"
+	    "    filename:  File to read\n"
+	    "    blocksize: Bytes per read (default 131072)\n"
+	    "    retries:   EAGAIN returns allowed per block before it\n"
+	    "               fails (default 1000)\n"
+	    "    -e:        Expect the first read of every block to return\n"
+	    "               EAGAIN\n"
+	    "    -w:        Expect a RWF_NOWAIT write to fail with "
+	    "EOPNOTSUPP\n",
+	    execname);
+	exit(1);
+}
+
+int
+main(int argc, char *argv[])
+{
+	char *filename = NULL;
+	size_t bs = 128 * 1024;
+	long retries = 1000;
+	long eagain = 0, nowait = 0;
+	struct stat st;
+	char *buf, *ref;
+	int c, fd, expect = 0, wr = 0;
+
+	while ((c = getopt(argc, argv, "b:ef:r:w")) != -1) {
+		switch (c) {
+		case 'b':
+			bs = strtoull(optarg, NULL, 0);
+			break;
+		case 'e':
+			expect = 1;
+			break;
+		case 'f':
+			filename = optarg;
+			break;
+		case 'r':
+			retries = strtol(optarg, NULL, 0);
+			break;
+		case 'w':
+			wr = 1;
+			break;
+		default:
+			usage();
+		}
+	}
+
+	if (filename == NULL || bs == 0)
+		usage();
+
+#ifndef RWF_NOWAIT
+	(void) fprintf(stderr, "%s: RWF_NOWAIT is not supported\n", execname);
+	return (2);
+#else
+	if ((fd = open(filename, wr ? O_RDWR : O_RDONLY)) < 0 ||
+	    fstat(fd, &st) != 0) {
+		perror(filename);
+		return (1);
+	}
+
+	if ((buf = malloc(bs)) == NULL || (ref = malloc(bs)) == NULL) {
+		perror("malloc");
+		return (1);
+	}
+
+	if (wr) {
+		struct iovec iov = { .iov_base = buf, .iov_len = bs };
+
+		(void) memset(buf, 0, bs);
+		if (pwritev2(fd, &iov, 1, 0, RWF_NOWAIT) >= 0 ||
+		    errno != EOPNOTSUPP) {
+			(void) fprintf(stderr, "%s: RWF_NOWAIT write did not "
+			    "fail with EOPNOTSUPP\n", execname);
+			return (1);
+		}
+		return (0);
+	}
+
+	for (off_t off = 0; expect && off < st.st_size; off += bs) {
+		struct iovec iov = { .iov_base = buf, .iov_len = bs };
+
+		if (preadv2(fd, &iov, 1, off, RWF_NOWAIT) >= 0) {
+			(void) fprintf(stderr, "%s: offset %lld did not return "
+			    "EAGAIN\n", execname, (long long)off);
+			return (1);
+		}
+		if (errno == EOPNOTSUPP || errno == ENOSYS || errno == EINVAL) {
+			(void) fprintf(stderr, "%s: RWF_NOWAIT is not "
+			    "supported: %s\n", execname, strerror(errno));
+			return (2);
+		}
+		if (errno != EAGAIN) {
+			perror("preadv2");
+			return (1);
+		}
+		eagain++;
+	}
+
+	for (off_t off = 0; off < st.st_size; off += bs) {
+		struct iovec iov = { .iov_base = buf, .iov_len = bs };
+		ssize_t n, rn;
+		long tries = 0;
+
+		while ((n = preadv2(fd, &iov, 1, off, RWF_NOWAIT)) < 0) {
+			if (errno == EOPNOTSUPP || errno == ENOSYS ||
+			    errno == EINVAL) {
+				(void) fprintf(stderr, "%s: RWF_NOWAIT is not "
+				    "supported: %s\n", execname,
+				    strerror(errno));
+				return (2);
+			}
+			if (errno != EAGAIN) {
+				perror("preadv2");
+				return (1);
+			}
+			eagain++;
+			if (++tries > retries) {
+				(void) fprintf(stderr, "%s: offset %lld still "
+				    "returns EAGAIN\n", execname,
+				    (long long)off);
+				return (1);
+			}
+			(void) usleep(1000);
+		}
+		nowait++;
+
+		/* A short read is allowed, the rest is read next. */
+		if (n == 0) {
+			(void) fprintf(stderr, "%s: unexpected EOF at offset "
+			    "%lld\n", execname, (long long)off);
+			return (1);
+		}
+		if ((rn = pread(fd, ref, n, off)) != n) {
+			perror("pread");
+			return (1);
+		}
+		if (memcmp(buf, ref, n) != 0) {
+			(void) fprintf(stderr, "%s: data mismatch at offset "
+			    "%lld\n", execname, (long long)off);
+			return (1);
+		}
+		off -= bs - n;
+	}
+
+	(void) printf("eagain %ld nowait %ld\n", eagain, nowait);
+
+	free(buf);
+	free(ref);
+	(void) close(fd);
+
+	return (0);
+#endif
+}